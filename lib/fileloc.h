@@ -51,6 +51,9 @@
 
 #define MC_EXTFS_DIR            "extfs.d"
 
+/* cache of archive indexes */
+#define MC_VFS_INDEX_DIR        "vfs-index"
+
 #define MC_BASHRC_FILE          "bashrc"
 #define MC_CONFIG_FILE          "ini"
 #define MC_FILEBIND_FILE        "mc.ext"
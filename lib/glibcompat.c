@@ -143,3 +143,45 @@ g_error_new_valist (GQuark domain, gint code, const gchar * format, va_list args
 #endif /* ! GLIB_CHECK_VERSION (2, 22, 0) */
 
 /* --------------------------------------------------------------------------------------------- */
+
+#if ! GLIB_CHECK_VERSION (2, 32, 0)
+/**
+ * Pops data from the queue. If the queue is empty, blocks for timeout microseconds,
+ * or until data becomes available.
+ * @param queue a GAsyncQueue
+ * @param timeout the number of microseconds to wait
+ * @returns data from the queue or NULL, when no data is received before the timeout
+ */
+
+gpointer
+g_async_queue_timeout_pop (GAsyncQueue * queue, guint64 timeout)
+{
+    GTimeVal end_time;
+
+    g_get_current_time (&end_time);
+    g_time_val_add (&end_time, (glong) timeout);
+
+    return g_async_queue_timed_pop (queue, &end_time);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Creates a new joinable thread.
+ * @param name thread name, ignored in old glib versions
+ * @param func function to execute in the new thread
+ * @param data argument to supply to the new thread
+ * @param error return location for error, or NULL
+ * @returns the new GThread, or NULL if an error occurred
+ */
+
+GThread *
+g_thread_try_new (const gchar * name, GThreadFunc func, gpointer data, GError ** error)
+{
+    (void) name;
+
+    return g_thread_create (func, data, TRUE, error);
+}
+
+#endif /* ! GLIB_CHECK_VERSION (2, 32, 0) */
+
+/* --------------------------------------------------------------------------------------------- */
@@ -28,6 +28,11 @@ void g_slist_free_full (GSList * list, GDestroyNotify free_func);
 void g_list_free_full (GList * list, GDestroyNotify free_func);
 #endif /* ! GLIB_CHECK_VERSION (2, 28, 0) */
 
+#if ! GLIB_CHECK_VERSION (2, 32, 0)
+gpointer g_async_queue_timeout_pop (GAsyncQueue * queue, guint64 timeout);
+GThread *g_thread_try_new (const gchar * name, GThreadFunc func, gpointer data, GError ** error);
+#endif /* ! GLIB_CHECK_VERSION (2, 32, 0) */
+
 /*** inline functions ****************************************************************************/
 
 #endif /* MC_GLIBCOMPAT_H */
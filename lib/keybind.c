@@ -342,6 +342,7 @@ static name_keymap_t command_names[] = {
     {"SearchBackward", CK_SearchBackward},
     {"SearchForwardContinue", CK_SearchForwardContinue},
     {"SearchBackwardContinue", CK_SearchBackwardContinue},
+    {"Follow", CK_Follow},
 
 #ifdef USE_DIFF_VIEW
     /* diff viewer */
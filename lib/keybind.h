@@ -319,6 +319,7 @@ enum
     CK_SearchBackward,
     CK_SearchForwardContinue,
     CK_SearchBackwardContinue,
+    CK_Follow,
 
     /* diff viewer */
     CK_ShowSymbols = 700,
@@ -18,6 +18,8 @@ typedef enum mc_search_cbret_t mc_search_cbret_t;
 typedef mc_search_cbret_t (*mc_search_fn) (const void *user_data, gsize char_offset,
                                            int *current_char);
 typedef mc_search_cbret_t (*mc_update_fn) (const void *user_data, gsize char_offset);
+typedef mc_search_cbret_t (*mc_search_block_fn) (const void *user_data, gsize char_offset,
+                                                 const char **block, gsize * block_len);
 
 #define MC_SEARCH__NUM_REPLACE_ARGS 64
 
@@ -81,6 +83,10 @@ typedef struct mc_search_struct
     /* function, used for getting data. NULL if not used */
     mc_search_fn search_fn;
 
+    /* function, used for getting contiguous blocks of data instead of search_fn.
+     * NULL if not used */
+    mc_search_block_fn search_block_fn;
+
     /* function, used for updatin current search status. NULL if not used */
     mc_update_fn update_fn;
 
@@ -147,6 +153,7 @@ GString *mc_search_prepare_replace_str (mc_search_t * mc_search, GString * repla
 char *mc_search_prepare_replace_str2 (mc_search_t * lc_mc_search, const char *replace_str);
 
 gboolean mc_search_is_fixed_search_str (mc_search_t *);
+gsize mc_search_get_fixed_max_len (mc_search_t *);
 
 gchar **mc_search_get_types_strings_array (size_t * num);
 
@@ -23,12 +23,22 @@ typedef enum
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
+/* Fixed string searched without regular expression engine */
+typedef struct mc_search_literal_struct
+{
+    guchar *str;                /* in lower case if search is case insensitive */
+    gsize len;
+    gboolean is_case_sensitive;
+    gsize shift[256];           /* Horspool's bad character shifts */
+} mc_search_literal_t;
+
 typedef struct mc_search_cond_struct
 {
     GString *str;
     GString *upper;
     GString *lower;
     mc_search_regex_t *regex_handle;
+    mc_search_literal_t *literal;       /* not NULL if condition is a plain string */
     gchar *charset;
 } mc_search_cond_t;
 
@@ -65,6 +75,10 @@ void mc_search__cond_struct_new_init_normal (const char *, mc_search_t *, mc_sea
 
 gboolean mc_search__run_normal (mc_search_t *, const void *, gsize, gsize, gsize *);
 
+const char *mc_search__literal_find (const mc_search_literal_t *, const char *, gsize);
+
+void mc_search__literal_free (mc_search_literal_t *);
+
 GString *mc_search_normal_prepare_replace_str (mc_search_t *, GString *);
 
 /* search/glob.c : */
@@ -26,6 +26,8 @@
 
 #include <config.h>
 
+#include <string.h>
+
 #include "lib/global.h"
 #include "lib/strutil.h"
 #include "lib/search.h"
@@ -80,6 +82,71 @@ mc_search__normal_translate_to_regex (const GString * astr)
     return buff;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Prepare search of a fixed string without regular expression engine.
+ * Case insensitive search is done this way only for ASCII strings.
+ *
+ * @return NULL if string cannot be searched as is
+ */
+
+static mc_search_literal_t *
+mc_search__literal_new (const mc_search_t * lc_mc_search, const GString * astr)
+{
+    mc_search_literal_t *literal;
+    gsize loop;
+
+    if (lc_mc_search->whole_words || astr->len == 0)
+        return NULL;
+
+    for (loop = 0; loop < astr->len; loop++)
+    {
+        guchar c = (guchar) astr->str[loop];
+
+        /* lines are searched one by one */
+        if (c == '\n' || (!lc_mc_search->is_case_sensitive && c >= 0x80))
+            return NULL;
+    }
+
+    literal = g_new (mc_search_literal_t, 1);
+    literal->len = astr->len;
+    literal->is_case_sensitive = lc_mc_search->is_case_sensitive;
+    literal->str = (guchar *) g_strndup (astr->str, astr->len);
+    if (!literal->is_case_sensitive)
+        for (loop = 0; loop < literal->len; loop++)
+            literal->str[loop] = g_ascii_tolower (literal->str[loop]);
+
+    for (loop = 0; loop < G_N_ELEMENTS (literal->shift); loop++)
+        literal->shift[loop] = literal->len;
+    for (loop = 0; loop + 1 < literal->len; loop++)
+    {
+        guchar c = literal->str[loop];
+
+        literal->shift[c] = literal->len - 1 - loop;
+        if (!literal->is_case_sensitive)
+            literal->shift[g_ascii_toupper (c)] = literal->len - 1 - loop;
+    }
+
+    return literal;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline gboolean
+mc_search__literal_equal (const mc_search_literal_t * literal, const guchar * text)
+{
+    gsize loop;
+
+    if (literal->is_case_sensitive)
+        return (memcmp (text, literal->str, literal->len) == 0);
+
+    for (loop = 0; loop < literal->len; loop++)
+        if (g_ascii_tolower (text[loop]) != literal->str[loop])
+            return FALSE;
+
+    return TRUE;
+}
+
 /*** public functions ****************************************************************************/
 
 void
@@ -88,6 +155,14 @@ mc_search__cond_struct_new_init_normal (const char *charset, mc_search_t * lc_mc
 {
     GString *tmp;
 
+    mc_search_cond->literal = mc_search__literal_new (lc_mc_search, mc_search_cond->str);
+    if (mc_search_cond->literal != NULL)
+    {
+        /* regular expression isn't needed */
+        lc_mc_search->is_utf8 = str_isutf8 (charset);
+        return;
+    }
+
     tmp = mc_search__normal_translate_to_regex (mc_search_cond->str);
     g_string_free (mc_search_cond->str, TRUE);
 
@@ -95,6 +170,58 @@ mc_search__cond_struct_new_init_normal (const char *charset, mc_search_t * lc_mc
     mc_search__cond_struct_new_init_regex (charset, lc_mc_search, mc_search_cond);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find first occurrence of fixed string in the buffer.
+ * Short strings are found by memchr() and memmem() of C library, which scan the buffer
+ * using vector instructions where possible.  Longer and case insensitive strings are found
+ * by Boyer-Moore-Horspool algorithm.
+ *
+ * @param literal prepared string
+ * @param data buffer
+ * @param len length of buffer
+ *
+ * @return pointer to found string in the buffer or NULL if string isn't found
+ */
+
+const char *
+mc_search__literal_find (const mc_search_literal_t * literal, const char *data, gsize len)
+{
+    const guchar *text = (const guchar *) data;
+    const gsize last = literal->len - 1;
+    gsize pos;
+
+    if (len < literal->len)
+        return NULL;
+
+    if (literal->is_case_sensitive)
+    {
+        if (literal->len == 1)
+            return memchr (data, literal->str[0], len);
+#ifdef HAVE_MEMMEM
+        return memmem (data, len, literal->str, literal->len);
+#endif
+    }
+
+    for (pos = 0; pos + last < len; pos += literal->shift[text[pos + last]])
+        if (mc_search__literal_equal (literal, text + pos))
+            return data + pos;
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+mc_search__literal_free (mc_search_literal_t * literal)
+{
+    if (literal == NULL)
+        return;
+
+    g_free (literal->str);
+    g_free (literal);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 gboolean
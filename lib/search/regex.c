@@ -310,13 +310,13 @@ mc_search__g_regex_match_full_safe (const GRegex * regex,
 
 static mc_search__found_cond_t
 mc_search__regex_found_cond_one (mc_search_t * lc_mc_search, mc_search_regex_t * regex,
-                                 GString * search_str)
+                                 const char *search_str, gsize search_len)
 {
 #ifdef SEARCH_TYPE_GLIB
     GError *mcerror = NULL;
 
     if (!mc_search__g_regex_match_full_safe
-        (regex, search_str->str, search_str->len, 0, G_REGEX_MATCH_NEWLINE_ANY,
+        (regex, search_str, search_len, 0, G_REGEX_MATCH_NEWLINE_ANY,
          &lc_mc_search->regex_match_info, &mcerror))
     {
         g_match_info_free (lc_mc_search->regex_match_info);
@@ -334,7 +334,7 @@ mc_search__regex_found_cond_one (mc_search_t * lc_mc_search, mc_search_regex_t *
     lc_mc_search->num_results = g_match_info_get_match_count (lc_mc_search->regex_match_info);
 #else /* SEARCH_TYPE_GLIB */
     lc_mc_search->num_results = pcre_exec (regex, lc_mc_search->regex_match_info,
-                                           search_str->str, search_str->len, 0, 0,
+                                           search_str, search_len, 0, 0,
                                            lc_mc_search->iovector, MC_SEARCH__NUM_REPLACE_ARGS);
     if (lc_mc_search->num_results < 0)
     {
@@ -348,7 +348,8 @@ mc_search__regex_found_cond_one (mc_search_t * lc_mc_search, mc_search_regex_t *
 /* --------------------------------------------------------------------------------------------- */
 
 static mc_search__found_cond_t
-mc_search__regex_found_cond (mc_search_t * lc_mc_search, GString * search_str)
+mc_search__regex_found_cond (mc_search_t * lc_mc_search, const char *search_str,
+                             gsize search_len, gint * start_pos, gint * end_pos)
 {
     gsize loop1;
 
@@ -359,18 +360,62 @@ mc_search__regex_found_cond (mc_search_t * lc_mc_search, GString * search_str)
 
         mc_search_cond = (mc_search_cond_t *) g_ptr_array_index (lc_mc_search->conditions, loop1);
 
+        if (mc_search_cond->literal != NULL)
+        {
+            const char *found;
+
+            found = mc_search__literal_find (mc_search_cond->literal, search_str, search_len);
+            if (found != NULL)
+            {
+                lc_mc_search->num_results = 1;
+                *start_pos = found - search_str;
+                *end_pos = *start_pos + mc_search_cond->literal->len;
+                return COND__FOUND_OK;
+            }
+            continue;
+        }
+
         if (!mc_search_cond->regex_handle)
             continue;
 
         ret =
             mc_search__regex_found_cond_one (lc_mc_search, mc_search_cond->regex_handle,
-                                             search_str);
+                                             search_str, search_len);
+        if (ret == COND__FOUND_OK)
+        {
+#ifdef SEARCH_TYPE_GLIB
+            g_match_info_fetch_pos (lc_mc_search->regex_match_info, 0, start_pos, end_pos);
+#else /* SEARCH_TYPE_GLIB */
+            *start_pos = lc_mc_search->iovector[0];
+            *end_pos = lc_mc_search->iovector[1];
+#endif /* SEARCH_TYPE_GLIB */
+        }
         if (ret != COND__NOT_FOUND)
             return ret;
     }
     return COND__NOT_ALL_FOUND;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Check whether all conditions are plain strings, which are searched without regex buffer */
+
+static gboolean
+mc_search__regex_is_literal (const mc_search_t * lc_mc_search)
+{
+    gsize loop1;
+
+    for (loop1 = 0; loop1 < lc_mc_search->conditions->len; loop1++)
+    {
+        mc_search_cond_t *mc_search_cond;
+
+        mc_search_cond = (mc_search_cond_t *) g_ptr_array_index (lc_mc_search->conditions, loop1);
+        if (mc_search_cond->literal == NULL)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static int
@@ -886,6 +931,9 @@ mc_search__run_regex (mc_search_t * lc_mc_search, const void *user_data,
     gsize current_pos, virtual_pos;
     gint start_pos;
     gint end_pos;
+    gboolean is_literal;
+
+    is_literal = mc_search__regex_is_literal (lc_mc_search);
 
     if (lc_mc_search->regex_buffer != NULL)
         g_string_free (lc_mc_search->regex_buffer, TRUE);
@@ -895,10 +943,63 @@ mc_search__run_regex (mc_search_t * lc_mc_search, const void *user_data,
     virtual_pos = current_pos = start_search;
     while (virtual_pos <= end_search)
     {
+        const char *chunk;
+        gsize chunk_len;
+
         g_string_set_size (lc_mc_search->regex_buffer, 0);
         lc_mc_search->start_buffer = current_pos;
 
-        if (lc_mc_search->search_fn != NULL)
+        if (lc_mc_search->search_block_fn != NULL)
+        {
+            /* collect the line by contiguous blocks instead of byte by byte */
+            chunk = NULL;
+            chunk_len = 0;
+
+            while (TRUE)
+            {
+                const char *block = NULL;
+                gsize block_len = 0;
+                const char *eol;
+
+                ret = lc_mc_search->search_block_fn (user_data, current_pos, &block, &block_len);
+
+                if (ret != MC_SEARCH_CB_OK || block_len == 0)
+                {
+                    ret = MC_SEARCH_CB_ABORT;
+                    break;
+                }
+
+                block_len = MIN (block_len, end_search - current_pos + 1);
+                eol = memchr (block, '\n', block_len);
+                if (eol != NULL)
+                    block_len = eol - block + 1;
+
+                current_pos += block_len;
+
+                if (is_literal && lc_mc_search->regex_buffer->len == 0
+                    && (eol != NULL || current_pos > end_search))
+                {
+                    /* whole line is in one block: search it in place */
+                    chunk = block;
+                    chunk_len = block_len;
+                    break;
+                }
+
+                g_string_append_len (lc_mc_search->regex_buffer, block, block_len);
+
+                if (eol != NULL || current_pos > end_search)
+                    break;
+            }
+
+            virtual_pos = current_pos;
+
+            if (chunk == NULL)
+            {
+                chunk = lc_mc_search->regex_buffer->str;
+                chunk_len = lc_mc_search->regex_buffer->len;
+            }
+        }
+        else if (lc_mc_search->search_fn != NULL)
         {
             while (TRUE)
             {
@@ -924,6 +1025,9 @@ mc_search__run_regex (mc_search_t * lc_mc_search, const void *user_data,
                 if ((char) current_chr == '\n' || virtual_pos > end_search)
                     break;
             }
+
+            chunk = lc_mc_search->regex_buffer->str;
+            chunk_len = lc_mc_search->regex_buffer->len;
         }
         else
         {
@@ -946,20 +1050,20 @@ mc_search__run_regex (mc_search_t * lc_mc_search, const void *user_data,
             }
 
             /* use virtual_pos as index of start of current chunk */
-            g_string_append_len (lc_mc_search->regex_buffer, (char *) user_data + virtual_pos,
-                                 current_pos - virtual_pos);
+            chunk = (const char *) user_data + virtual_pos;
+            chunk_len = current_pos - virtual_pos;
+            /* plain strings are searched in place, regex_buffer is needed for replace only */
+            if (!is_literal)
+            {
+                g_string_append_len (lc_mc_search->regex_buffer, chunk, chunk_len);
+                chunk = lc_mc_search->regex_buffer->str;
+            }
             virtual_pos = current_pos;
         }
 
-        switch (mc_search__regex_found_cond (lc_mc_search, lc_mc_search->regex_buffer))
+        switch (mc_search__regex_found_cond (lc_mc_search, chunk, chunk_len, &start_pos, &end_pos))
         {
         case COND__FOUND_OK:
-#ifdef SEARCH_TYPE_GLIB
-            g_match_info_fetch_pos (lc_mc_search->regex_match_info, 0, &start_pos, &end_pos);
-#else /* SEARCH_TYPE_GLIB */
-            start_pos = lc_mc_search->iovector[0];
-            end_pos = lc_mc_search->iovector[1];
-#endif /* SEARCH_TYPE_GLIB */
             if (found_len != NULL)
                 *found_len = end_pos - start_pos;
             lc_mc_search->normal_offset = lc_mc_search->start_buffer + start_pos;
@@ -102,6 +102,8 @@ mc_search__cond_struct_free (mc_search_cond_t * mc_search_cond)
     g_string_free (mc_search_cond->str, TRUE);
     g_free (mc_search_cond->charset);
 
+    mc_search__literal_free (mc_search_cond->literal);
+
 #ifdef SEARCH_TYPE_GLIB
     if (mc_search_cond->regex_handle)
         g_regex_unref (mc_search_cond->regex_handle);
@@ -394,6 +396,38 @@ mc_search_is_fixed_search_str (mc_search_t * lc_mc_search)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get the maximal length of data matched by the fixed search string.
+ * The string recoded to other charsets or changed case can be longer than the original one.
+ */
+
+gsize
+mc_search_get_fixed_max_len (mc_search_t * lc_mc_search)
+{
+    gsize max_len;
+    guint i;
+
+    max_len = lc_mc_search->original_len;
+
+    if (lc_mc_search->conditions == NULL && !mc_search_prepare (lc_mc_search))
+        return max_len;
+
+    for (i = 0; i < lc_mc_search->conditions->len; i++)
+    {
+        mc_search_cond_t *mc_search_cond;
+
+        mc_search_cond = (mc_search_cond_t *) g_ptr_array_index (lc_mc_search->conditions, i);
+        max_len = MAX (max_len, mc_search_cond->str->len);
+        if (mc_search_cond->upper != NULL)
+            max_len = MAX (max_len, mc_search_cond->upper->len);
+        if (mc_search_cond->lower != NULL)
+            max_len = MAX (max_len, mc_search_cond->lower->len);
+    }
+
+    return max_len;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /* Search specified pattern in specified string.
  *
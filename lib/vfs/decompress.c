@@ -0,0 +1,774 @@
+/*
+   Virtual File System: streaming decompression of archives
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: Virtual File System: streaming decompression of archives
+ *
+ * Compressed archives are read through a decompressor in the process, so the whole
+ * uncompressed archive isn't written to a temporary file.
+ *
+ * Reading forward continues the decompression. While a gzip stream is decompressed, seek
+ * points are recorded at ends of deflate blocks: the position in the compressed data and the
+ * last 32 KiB of uncompressed data. Seeking starts the decompression again from the nearest
+ * seek point before the new position. Other formats start from the beginning of the stream
+ * when seeking backward.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_BZLIB
+#include <bzlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+
+#include "lib/global.h"
+#include "lib/util.h"
+
+#include "vfs.h"
+
+#include "decompress.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* size of buffer of compressed data */
+#define DECOMPRESS_IN_SIZE (64 * 1024)
+
+/* uncompressed data kept in memory, it is the history needed by deflate as well */
+#define DECOMPRESS_WINDOW_SIZE (32 * 1024)
+
+/* initial distance between seek points, in bytes of uncompressed data */
+#define DECOMPRESS_SPAN (1024 * 1024)
+
+/* if there are more seek points, every other one is dropped and the distance is doubled */
+#define DECOMPRESS_MAX_POINTS 256
+
+/* size of gzip trailer: CRC32 and length */
+#define GZIP_TRAILER_SIZE 8
+
+#define DECOMPRESS_POINT(d, i) ((decompress_point_t *) g_ptr_array_index ((d)->points, i))
+
+/*** file scope type declarations ****************************************************************/
+
+#ifdef HAVE_ZLIB
+/* state of gzip decompression at the end of a deflate block */
+typedef struct
+{
+    off_t out;                  /* offset in uncompressed data */
+    off_t in;                   /* offset of the next full byte of compressed data */
+    int bits;                   /* number of bits of the byte before in not used yet */
+    unsigned char window[DECOMPRESS_WINDOW_SIZE];       /* uncompressed data before out */
+} decompress_point_t;
+#endif /* HAVE_ZLIB */
+
+struct vfs_decompress_struct
+{
+    int fd;
+    enum compression_type type;
+    gboolean initialized;       /* decompressor is initialized */
+    gboolean stream_end;        /* all data is decompressed */
+    gboolean stream_start;      /* no data of the current stream (gzip member) is decompressed */
+
+    /* compressed data */
+    unsigned char in[DECOMPRESS_IN_SIZE];
+    const unsigned char *next_in;
+    size_t avail_in;
+    off_t in_offset;            /* offset of the data after the buffer in the file */
+    gboolean in_eof;
+
+    /* uncompressed data is written to the window cyclically */
+    unsigned char window[DECOMPRESS_WINDOW_SIZE];
+    size_t wpos;                /* end of the data written last */
+    size_t rpos;                /* start of the data not read yet */
+    off_t out_offset;           /* offset of the data at wpos */
+
+    union
+    {
+#ifdef HAVE_ZLIB
+        z_stream z;
+#endif
+#ifdef HAVE_BZLIB
+        bz_stream bz;
+#endif
+#ifdef HAVE_LZMA
+        lzma_stream lzma;
+#endif
+        int dummy;
+    } u;
+
+#ifdef HAVE_ZLIB
+    gboolean raw;               /* deflate data without gzip header, after a seek point */
+    size_t skip_in;             /* bytes of gzip trailer to skip in raw mode */
+    GPtrArray *points;          /* seek points ordered by offset */
+    off_t span;                 /* distance between seek points */
+#endif
+};
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+decompress_init (vfs_decompress_t * d)
+{
+    memset (&d->u, 0, sizeof (d->u));
+
+    switch (d->type)
+    {
+#ifdef HAVE_ZLIB
+    case COMPRESSION_GZIP:
+        d->initialized = (inflateInit2 (&d->u.z, 16 + MAX_WBITS) == Z_OK);
+        d->raw = FALSE;
+        d->skip_in = 0;
+        break;
+#endif
+#ifdef HAVE_BZLIB
+    case COMPRESSION_BZIP2:
+        d->initialized = (BZ2_bzDecompressInit (&d->u.bz, 0, 0) == BZ_OK);
+        break;
+#endif
+#ifdef HAVE_LZMA
+    case COMPRESSION_XZ:
+        {
+            lzma_stream init = LZMA_STREAM_INIT;
+
+            d->u.lzma = init;
+            d->initialized =
+                (lzma_stream_decoder (&d->u.lzma, UINT64_MAX, LZMA_CONCATENATED) == LZMA_OK);
+        }
+        break;
+#endif
+    default:
+        d->initialized = FALSE;
+        break;
+    }
+
+    d->stream_start = TRUE;
+    return d->initialized;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+decompress_end (vfs_decompress_t * d)
+{
+    if (!d->initialized)
+        return;
+
+    switch (d->type)
+    {
+#ifdef HAVE_ZLIB
+    case COMPRESSION_GZIP:
+        inflateEnd (&d->u.z);
+        break;
+#endif
+#ifdef HAVE_BZLIB
+    case COMPRESSION_BZIP2:
+        BZ2_bzDecompressEnd (&d->u.bz);
+        break;
+#endif
+#ifdef HAVE_LZMA
+    case COMPRESSION_XZ:
+        lzma_end (&d->u.lzma);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    d->initialized = FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Set position in compressed and uncompressed data */
+
+static gboolean
+decompress_rewind (vfs_decompress_t * d, off_t in, off_t out)
+{
+    if (mc_lseek (d->fd, in, SEEK_SET) != in)
+        return FALSE;
+
+    d->next_in = d->in;
+    d->avail_in = 0;
+    d->in_offset = in;
+    d->in_eof = FALSE;
+    d->wpos = 0;
+    d->rpos = 0;
+    d->out_offset = out;
+    d->stream_end = FALSE;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+decompress_restart (vfs_decompress_t * d)
+{
+    decompress_end (d);
+    return decompress_rewind (d, 0, 0) && decompress_init (d);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Read compressed data if the buffer is empty */
+
+static gboolean
+decompress_fill (vfs_decompress_t * d)
+{
+    ssize_t n;
+
+    if (d->avail_in != 0 || d->in_eof)
+        return TRUE;
+
+    n = mc_read (d->fd, (char *) d->in, sizeof (d->in));
+    if (n < 0)
+        return FALSE;
+
+    d->next_in = d->in;
+    d->avail_in = (size_t) n;
+    d->in_offset += n;
+    d->in_eof = (n == 0);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_ZLIB
+static void
+decompress_gzip_add_point (vfs_decompress_t * d)
+{
+    decompress_point_t *p;
+
+    p = g_new (decompress_point_t, 1);
+    p->out = d->out_offset;
+    p->in = d->in_offset - d->avail_in;
+    p->bits = d->u.z.data_type & 7;
+    /* the oldest data is after wpos */
+    memcpy (p->window, d->window + d->wpos, sizeof (d->window) - d->wpos);
+    memcpy (p->window + sizeof (d->window) - d->wpos, d->window, d->wpos);
+    g_ptr_array_add (d->points, p);
+
+    if (d->points->len > DECOMPRESS_MAX_POINTS)
+    {
+        guint i, j;
+
+        for (i = 0, j = 0; i < d->points->len; i++)
+            if (i % 2 == 0)
+                g_free (DECOMPRESS_POINT (d, i));
+            else
+                g_ptr_array_index (d->points, j++) = DECOMPRESS_POINT (d, i);
+
+        g_ptr_array_set_size (d->points, j);
+        d->span *= 2;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Decompress next piece of gzip data */
+
+static gboolean
+decompress_gzip (vfs_decompress_t * d)
+{
+    z_stream *z = &d->u.z;
+    size_t avail_out;
+    int ret;
+
+    if (d->skip_in != 0)
+    {
+        size_t n;
+
+        n = MIN (d->skip_in, d->avail_in);
+        d->next_in += n;
+        d->avail_in -= n;
+        d->skip_in -= n;
+        if (d->skip_in != 0)
+        {
+            /* truncated trailer is ignored like by gzip */
+            d->stream_end = d->in_eof;
+            return TRUE;
+        }
+
+        /* the next member has a header */
+        d->raw = FALSE;
+        d->stream_start = TRUE;
+        return inflateReset2 (z, 16 + MAX_WBITS) == Z_OK;
+    }
+
+    if (d->avail_in == 0 && d->in_eof)
+    {
+        /* end of the last member */
+        d->stream_end = TRUE;
+        return d->stream_start;
+    }
+
+    avail_out = sizeof (d->window) - d->wpos;
+    z->next_in = (Bytef *) d->next_in;
+    z->avail_in = d->avail_in;
+    z->next_out = d->window + d->wpos;
+    z->avail_out = avail_out;
+
+    ret = inflate (z, Z_BLOCK);
+
+    d->next_in = z->next_in;
+    d->avail_in = z->avail_in;
+    d->wpos += avail_out - z->avail_out;
+    d->out_offset += avail_out - z->avail_out;
+
+    switch (ret)
+    {
+    case Z_OK:
+        if (avail_out != z->avail_out)
+            d->stream_start = FALSE;
+
+        /* end of a block which isn't the last one */
+        if ((z->data_type & 128) != 0 && (z->data_type & 64) == 0
+            && d->out_offset - (d->points->len == 0 ? 0 :
+                                DECOMPRESS_POINT (d, d->points->len - 1)->out) >= d->span)
+            decompress_gzip_add_point (d);
+        return TRUE;
+
+    case Z_BUF_ERROR:
+        /* more input is needed */
+        return TRUE;
+
+    case Z_STREAM_END:
+        if (d->raw)
+        {
+            d->skip_in = GZIP_TRAILER_SIZE;
+            return TRUE;
+        }
+        d->stream_start = TRUE;
+        return inflateReset (z) == Z_OK;
+
+    default:
+        /* garbage after the last member is ignored like by gzip */
+        d->stream_end = d->stream_start;
+        return d->stream_start;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Start decompression from the seek point */
+
+static gboolean
+decompress_gzip_restore (vfs_decompress_t * d, const decompress_point_t * p)
+{
+    z_stream *z = &d->u.z;
+
+    if (!decompress_rewind (d, p->in - (p->bits != 0 ? 1 : 0), p->out)
+        || inflateReset2 (z, -MAX_WBITS) != Z_OK)
+        return FALSE;
+
+    if (p->bits != 0)
+    {
+        if (!decompress_fill (d) || d->avail_in == 0)
+            return FALSE;
+        inflatePrime (z, p->bits, d->next_in[0] >> (8 - p->bits));
+        d->next_in++;
+        d->avail_in--;
+    }
+
+    if (inflateSetDictionary (z, p->window, sizeof (p->window)) != Z_OK)
+        return FALSE;
+
+    memcpy (d->window, p->window, sizeof (d->window));
+    d->wpos = sizeof (d->window);
+    d->rpos = d->wpos;
+    d->raw = TRUE;
+    d->skip_in = 0;
+    d->stream_start = FALSE;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Find the last seek point at or before the offset */
+
+static const decompress_point_t *
+decompress_gzip_find_point (const vfs_decompress_t * d, off_t offset)
+{
+    guint lo = 0, hi = d->points->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (DECOMPRESS_POINT (d, mid)->out <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo == 0 ? NULL : DECOMPRESS_POINT (d, lo - 1);
+}
+#endif /* HAVE_ZLIB */
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_BZLIB
+static gboolean
+decompress_bzip2 (vfs_decompress_t * d)
+{
+    bz_stream *bz = &d->u.bz;
+    size_t avail_out;
+    int ret;
+
+    if (d->avail_in == 0 && d->in_eof)
+    {
+        d->stream_end = TRUE;
+        return d->stream_start;
+    }
+
+    avail_out = sizeof (d->window) - d->wpos;
+    bz->next_in = (char *) d->next_in;
+    bz->avail_in = d->avail_in;
+    bz->next_out = (char *) d->window + d->wpos;
+    bz->avail_out = avail_out;
+
+    ret = BZ2_bzDecompress (bz);
+
+    d->next_in = (const unsigned char *) bz->next_in;
+    d->avail_in = bz->avail_in;
+    d->wpos += avail_out - bz->avail_out;
+    d->out_offset += avail_out - bz->avail_out;
+
+    switch (ret)
+    {
+    case BZ_OK:
+        if (avail_out != bz->avail_out)
+            d->stream_start = FALSE;
+        return TRUE;
+
+    case BZ_STREAM_END:
+        /* parallel bzip2 writes many streams */
+        BZ2_bzDecompressEnd (bz);
+        d->initialized = FALSE;
+        return decompress_init (d);
+
+    default:
+        /* garbage after the last stream is ignored like by bzip2 */
+        d->stream_end = d->stream_start;
+        return d->stream_start;
+    }
+}
+#endif /* HAVE_BZLIB */
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_LZMA
+static gboolean
+decompress_xz (vfs_decompress_t * d)
+{
+    lzma_stream *lzma = &d->u.lzma;
+    size_t avail_out;
+    lzma_ret ret;
+
+    avail_out = sizeof (d->window) - d->wpos;
+    lzma->next_in = d->next_in;
+    lzma->avail_in = d->avail_in;
+    lzma->next_out = d->window + d->wpos;
+    lzma->avail_out = avail_out;
+
+    ret = lzma_code (lzma, d->in_eof ? LZMA_FINISH : LZMA_RUN);
+
+    d->next_in = lzma->next_in;
+    d->avail_in = lzma->avail_in;
+    d->wpos += avail_out - lzma->avail_out;
+    d->out_offset += avail_out - lzma->avail_out;
+
+    switch (ret)
+    {
+    case LZMA_OK:
+        return TRUE;
+
+    case LZMA_STREAM_END:
+        d->stream_end = TRUE;
+        return TRUE;
+
+    default:
+        return FALSE;
+    }
+}
+#endif /* HAVE_LZMA */
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Decompress next piece of data to the window.
+ *
+ * @return number of decompressed bytes, 0 at the end of data, -1 on error
+ */
+
+static ssize_t
+decompress_step (vfs_decompress_t * d)
+{
+    off_t out_offset = d->out_offset;
+
+    if (d->wpos == sizeof (d->window))
+    {
+        d->wpos = 0;
+        d->rpos = 0;
+    }
+
+    while (d->out_offset == out_offset && !d->stream_end)
+    {
+        gboolean ok;
+
+        if (!d->initialized || !decompress_fill (d))
+            return -1;
+
+        switch (d->type)
+        {
+#ifdef HAVE_ZLIB
+        case COMPRESSION_GZIP:
+            ok = decompress_gzip (d);
+            break;
+#endif
+#ifdef HAVE_BZLIB
+        case COMPRESSION_BZIP2:
+            ok = decompress_bzip2 (d);
+            break;
+#endif
+#ifdef HAVE_LZMA
+        case COMPRESSION_XZ:
+            ok = decompress_xz (d);
+            break;
+#endif
+        default:
+            ok = FALSE;
+            break;
+        }
+
+        if (!ok)
+            return -1;
+    }
+
+    return (ssize_t) (d->out_offset - out_offset);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start decompression of the file.
+ *
+ * @param fd file descriptor of the compressed file, it isn't closed by vfs_decompress_close()
+ * @param type compression type detected by get_compression_type()
+ *
+ * @return decompressor or NULL if the type can't be decompressed in the process
+ */
+
+vfs_decompress_t *
+vfs_decompress_open (int fd, enum compression_type type)
+{
+    vfs_decompress_t *d;
+
+    switch (type)
+    {
+#ifdef HAVE_ZLIB
+    case COMPRESSION_GZIP:
+        {
+            unsigned char magic[2];
+
+            /* get_compression_type() reports other formats handled by gzip as well */
+            if (mc_lseek (fd, 0, SEEK_SET) != 0 || mc_read (fd, (char *) magic, 2) != 2
+                || magic[0] != 037 || magic[1] != 0213)
+                return NULL;
+        }
+        break;
+#endif
+#ifdef HAVE_BZLIB
+    case COMPRESSION_BZIP2:
+        break;
+#endif
+#ifdef HAVE_LZMA
+    case COMPRESSION_XZ:
+        break;
+#endif
+    default:
+        return NULL;
+    }
+
+    d = g_new0 (vfs_decompress_t, 1);
+    d->fd = fd;
+    d->type = type;
+#ifdef HAVE_ZLIB
+    d->points = g_ptr_array_new ();
+    d->span = DECOMPRESS_SPAN;
+#endif
+
+    if (!decompress_restart (d))
+    {
+        vfs_decompress_close (d);
+        return NULL;
+    }
+
+    return d;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+ssize_t
+vfs_decompress_read (vfs_decompress_t * d, char *buffer, size_t count)
+{
+    size_t total = 0;
+
+    while (total < count)
+    {
+        size_t n;
+
+        if (d->rpos == d->wpos)
+        {
+            ssize_t res;
+
+            res = decompress_step (d);
+            if (res == -1)
+            {
+                if (total != 0)
+                    break;
+                errno = EIO;
+                return -1;
+            }
+            if (res == 0)
+                break;
+        }
+
+        n = MIN (count - total, d->wpos - d->rpos);
+        memcpy (buffer + total, d->window + d->rpos, n);
+        d->rpos += n;
+        total += n;
+    }
+
+    return (ssize_t) total;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Set position in uncompressed data.
+ *
+ * @return new position or -1 on error. Position can't be set after the end of data.
+ */
+
+off_t
+vfs_decompress_seek (vfs_decompress_t * d, off_t offset, int whence)
+{
+    off_t window_start;
+#ifdef HAVE_ZLIB
+    const decompress_point_t *p = NULL;
+#endif
+
+    if (whence == SEEK_CUR)
+        offset += d->out_offset - (off_t) (d->wpos - d->rpos);
+    else if (whence != SEEK_SET)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (offset < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    window_start = d->out_offset - (off_t) d->wpos;
+
+#ifdef HAVE_ZLIB
+    if (d->type == COMPRESSION_GZIP)
+        p = decompress_gzip_find_point (d, offset);
+
+    if (p != NULL && (offset < window_start || p->out > d->out_offset))
+    {
+        /* the seek point is closer than the current position */
+        if (!decompress_gzip_restore (d, p))
+        {
+            decompress_restart (d);
+            errno = EIO;
+            return -1;
+        }
+    }
+    else
+#endif
+    if (offset < window_start && !decompress_restart (d))
+    {
+        errno = EIO;
+        return -1;
+    }
+
+    /* skip data before the offset */
+    while (d->out_offset < offset)
+    {
+        ssize_t res;
+
+        d->rpos = d->wpos;
+        res = decompress_step (d);
+        if (res == -1)
+        {
+            errno = EIO;
+            return -1;
+        }
+        if (res == 0)
+        {
+            /* end of data */
+            offset = d->out_offset;
+            break;
+        }
+    }
+
+    d->rpos = d->wpos - (size_t) (d->out_offset - offset);
+
+    return offset;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_decompress_close (vfs_decompress_t * d)
+{
+    if (d == NULL)
+        return;
+
+    decompress_end (d);
+
+#ifdef HAVE_ZLIB
+    g_ptr_array_foreach (d->points, (GFunc) g_free, NULL);
+    g_ptr_array_free (d->points, TRUE);
+#endif
+
+    g_free (d);
+}
+
+/* --------------------------------------------------------------------------------------------- */
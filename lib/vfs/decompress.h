@@ -0,0 +1,30 @@
+/**
+ * \file
+ * \brief Header: Virtual File System: streaming decompression of archives
+ */
+
+#ifndef MC__VFS_DECOMPRESS_H
+#define MC__VFS_DECOMPRESS_H
+
+#include "lib/util.h"           /* enum compression_type */
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+typedef struct vfs_decompress_struct vfs_decompress_t;
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+vfs_decompress_t *vfs_decompress_open (int fd, enum compression_type type);
+ssize_t vfs_decompress_read (vfs_decompress_t * d, char *buffer, size_t count);
+off_t vfs_decompress_seek (vfs_decompress_t * d, off_t offset, int whence);
+void vfs_decompress_close (vfs_decompress_t * d);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__VFS_DECOMPRESS_H */
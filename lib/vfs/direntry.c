@@ -75,6 +75,8 @@
 #include "utilvfs.h"
 #include "xdirentry.h"
 #include "gc.h"                 /* vfs_rmstamp */
+#include "indexcache.h"
+#include "readahead.h"
 
 /*** global variables ****************************************************************************/
 
@@ -82,6 +84,9 @@
 
 #define CALL(x) if (MEDATA->x) MEDATA->x
 
+/* Directories with at least this number of entries are looked up through the hash index */
+#define VFS_S_SUBDIR_INDEX_MIN 32
+
 /*** file scope type declarations ****************************************************************/
 
 struct dirhandle
@@ -108,6 +113,97 @@ vfs_s_entry_compare (const void *a, const void *b)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static void
+vfs_s_subdir_index_build (struct vfs_s_inode *dir)
+{
+    GList *iter;
+
+    dir->subdir_index = g_hash_table_new (g_str_hash, g_str_equal);
+    dir->subdir_hidden = 0;
+
+    for (iter = g_queue_peek_head_link (dir->subdir); iter != NULL; iter = g_list_next (iter))
+    {
+        struct vfs_s_entry *ent = (struct vfs_s_entry *) iter->data;
+
+        /* keep the first one of duplicated names as the linear search does */
+        if (ent->name == NULL)
+            continue;
+        if (g_hash_table_lookup (dir->subdir_index, ent->name) == NULL)
+            g_hash_table_insert (dir->subdir_index, ent->name, iter);
+        else
+            dir->subdir_hidden++;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+vfs_s_subdir_index_free (struct vfs_s_inode *dir)
+{
+    if (dir->subdir_index != NULL)
+    {
+        g_hash_table_destroy (dir->subdir_index);
+        dir->subdir_index = NULL;
+        dir->subdir_hidden = 0;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/* Find entry by name in the directory. The index is created once the directory is large enough */
+
+static struct vfs_s_entry *
+vfs_s_subdir_find (struct vfs_s_inode *dir, const char *name)
+{
+    GList *iter;
+
+    if (dir->subdir_index == NULL && g_queue_get_length (dir->subdir) >= VFS_S_SUBDIR_INDEX_MIN)
+        vfs_s_subdir_index_build (dir);
+
+    if (dir->subdir_index != NULL)
+        iter = (GList *) g_hash_table_lookup (dir->subdir_index, name);
+    else
+        iter = g_queue_find_custom (dir->subdir, name, (GCompareFunc) vfs_s_entry_compare);
+
+    return iter != NULL ? (struct vfs_s_entry *) iter->data : NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+vfs_s_subdir_remove (struct vfs_s_inode *dir, struct vfs_s_entry *ent)
+{
+    GList *link = NULL;
+
+    if (dir->subdir_index != NULL && ent->name != NULL)
+        link = (GList *) g_hash_table_lookup (dir->subdir_index, ent->name);
+
+    if (link == NULL || link->data != ent)
+    {
+        /* not indexed: the directory is small, or the entry is hidden by a duplicated name */
+        if (link != NULL)
+            dir->subdir_hidden--;
+        g_queue_remove (dir->subdir, ent);
+        return;
+    }
+
+    g_hash_table_remove (dir->subdir_index, ent->name);
+    g_queue_delete_link (dir->subdir, link);
+
+    /* entry with the same name could be hidden by the removed one */
+    if (dir->subdir_hidden != 0)
+    {
+        link = g_queue_find_custom (dir->subdir, ent->name, (GCompareFunc) vfs_s_entry_compare);
+        if (link != NULL)
+        {
+            g_hash_table_insert (dir->subdir_index, ((struct vfs_s_entry *) link->data)->name,
+                                 link);
+            dir->subdir_hidden--;
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 /* We were asked to create entries automagically */
 
 static struct vfs_s_entry *
@@ -191,7 +287,7 @@ vfs_s_find_entry_tree (struct vfs_class *me, struct vfs_s_inode *root,
 
     while (root != NULL)
     {
-        GList *iter;
+        char c;
 
         while (IS_PATH_SEP (*path))     /* Strip leading '/' */
             path++;
@@ -205,15 +301,10 @@ vfs_s_find_entry_tree (struct vfs_class *me, struct vfs_s_inode *root,
         for (pseg = 0; path[pseg] != '\0' && !IS_PATH_SEP (path[pseg]); pseg++)
             ;
 
-        for (iter = root->subdir; iter != NULL; iter = g_list_next (iter))
-        {
-            ent = (struct vfs_s_entry *) iter->data;
-            if (strlen (ent->name) == pseg && strncmp (ent->name, path, pseg) == 0)
-                /* FOUND! */
-                break;
-        }
-
-        ent = iter != NULL ? (struct vfs_s_entry *) iter->data : NULL;
+        c = path[pseg];
+        path[pseg] = '\0';
+        ent = vfs_s_subdir_find (root, path);
+        path[pseg] = c;
 
         if (ent == NULL && (flags & (FL_MKFILE | FL_MKDIR)) != 0)
             ent = vfs_s_automake (me, root, path, flags);
@@ -245,7 +336,6 @@ vfs_s_find_entry_linear (struct vfs_class *me, struct vfs_s_inode *root,
 {
     struct vfs_s_entry *ent = NULL;
     char *const path = g_strdup (a_path);
-    GList *iter;
 
     if (root->super->root != root)
         vfs_die ("We have to use _real_ root. Always. Sorry.");
@@ -268,8 +358,7 @@ vfs_s_find_entry_linear (struct vfs_class *me, struct vfs_s_inode *root,
         return ent;
     }
 
-    iter = g_list_find_custom (root->subdir, path, (GCompareFunc) vfs_s_entry_compare);
-    ent = iter != NULL ? (struct vfs_s_entry *) iter->data : NULL;
+    ent = vfs_s_subdir_find (root, path);
 
     if (ent != NULL && !MEDATA->dir_uptodate (me, ent->ino))
     {
@@ -295,8 +384,7 @@ vfs_s_find_entry_linear (struct vfs_class *me, struct vfs_s_inode *root,
 
         vfs_s_insert_entry (me, root, ent);
 
-        iter = g_list_find_custom (root->subdir, path, (GCompareFunc) vfs_s_entry_compare);
-        ent = iter != NULL ? (struct vfs_s_entry *) iter->data : NULL;
+        ent = vfs_s_subdir_find (root, path);
     }
     if (ent == NULL)
         vfs_die ("find_linear: success but directory is not there\n");
@@ -417,14 +505,14 @@ vfs_s_opendir (const vfs_path_t * vpath)
 
     dir->st.st_nlink++;
 #if 0
-    if (dir->subdir == NULL)    /* This can actually happen if we allow empty directories */
+    if (g_queue_is_empty (dir->subdir)) /* This can actually happen if we allow empty directories */
     {
         path_element->class->verrno = EAGAIN;
         return NULL;
     }
 #endif
     info = g_new (struct dirhandle, 1);
-    info->cur = dir->subdir;
+    info->cur = g_queue_peek_head_link (dir->subdir);
     info->dir = dir;
 
     return info;
@@ -555,6 +643,74 @@ vfs_s_readlink (const vfs_path_t * vpath, char *buf, size_t size)
     return len;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Read-ahead function: receive data of the linear transfer in the read-ahead thread */
+
+static ssize_t
+vfs_s_linear_recv (void *fh, void *buffer, size_t count)
+{
+    struct vfs_class *me = FH_SUPER->me;
+
+    return MEDATA->linear_recv (me, FH, buffer, count);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start the linear transfer. If the subclass can receive data in another thread, the data
+ * is read ahead while the previous data is being written or processed by the reader.
+ */
+
+static gboolean
+vfs_s_linear_start (struct vfs_class *me, vfs_file_handler_t * fh, off_t from)
+{
+    if (!MEDATA->linear_start (me, fh, from))
+        return FALSE;
+
+    if (MEDATA->linear_recv != NULL)
+        fh->readahead = vfs_readahead_new (vfs_s_linear_recv, fh);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+vfs_s_linear_read (struct vfs_class *me, vfs_file_handler_t * fh, void *buffer, size_t count)
+{
+    ssize_t n;
+
+    if (fh->readahead == NULL)
+        return MEDATA->linear_read (me, fh, buffer, count);
+
+    n = vfs_readahead_read (fh->readahead, buffer, count);
+    if (n < 0)
+        me->verrno = errno;
+    else if (n == 0)
+    {
+        /* all data is received, let the subclass finish the transfer */
+        vfs_readahead_free (fh->readahead);
+        fh->readahead = NULL;
+        n = MEDATA->linear_read (me, fh, buffer, count);
+    }
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+vfs_s_linear_close (struct vfs_class *me, vfs_file_handler_t * fh)
+{
+    /* the subclass may read the rest of data to abort the transfer */
+    if (fh->readahead != NULL)
+    {
+        vfs_readahead_free (fh->readahead);
+        fh->readahead = NULL;
+    }
+
+    MEDATA->linear_close (me, fh);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static ssize_t
@@ -564,7 +720,7 @@ vfs_s_read (void *fh, char *buffer, size_t count)
 
     if (FH->linear == LS_LINEAR_PREOPEN)
     {
-        if (!MEDATA->linear_start (me, FH, FH->pos))
+        if (!vfs_s_linear_start (me, FH, FH->pos))
             return -1;
     }
 
@@ -572,7 +728,18 @@ vfs_s_read (void *fh, char *buffer, size_t count)
         vfs_die ("linear_start() did not set linear_state!");
 
     if (FH->linear == LS_LINEAR_OPEN)
-        return MEDATA->linear_read (me, FH, buffer, count);
+    {
+        gboolean ahead = FH->readahead != NULL;
+        ssize_t n;
+
+        /* let the interrupt key break waiting for the read-ahead thread */
+        if (ahead)
+            tty_enable_interrupt_key ();
+        n = vfs_s_linear_read (me, FH, buffer, count);
+        if (ahead)
+            tty_disable_interrupt_key ();
+        return n;
+    }
 
     if (FH->handle != -1)
     {
@@ -665,7 +832,7 @@ vfs_s_close (void *fh)
         vfs_stamp_create (me, FH_SUPER);
 
     if (FH->linear == LS_LINEAR_OPEN)
-        MEDATA->linear_close (me, fh);
+        vfs_s_linear_close (me, FH);
     if (MEDATA->fh_close)
         res = MEDATA->fh_close (me, fh);
     if ((MEDATA->flags & VFS_S_USETMP) && FH->changed && MEDATA->file_store)
@@ -870,6 +1037,37 @@ vfs_s_dir_uptodate (struct vfs_class *me, struct vfs_s_inode *ino)
     return 0;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Add entries of the directory and of its subdirectories to the index */
+
+static void
+vfs_s_index_add_dir (vfs_index_t * index, GHashTable * inodes, struct vfs_s_inode *dir,
+                     guint dir_num)
+{
+    GList *iter;
+
+    for (iter = g_queue_peek_head_link (dir->subdir); iter != NULL; iter = g_list_next (iter))
+    {
+        struct vfs_s_entry *ent = (struct vfs_s_entry *) iter->data;
+        gpointer num;
+        gboolean is_new;
+
+        /* hardlinks share the inode */
+        is_new = !g_hash_table_lookup_extended (inodes, ent->ino, NULL, &num);
+        if (is_new)
+        {
+            num = GUINT_TO_POINTER (vfs_index_add_inode (index, &ent->ino->st, ent->ino->linkname,
+                                                         ent->ino->data_offset));
+            g_hash_table_insert (inodes, ent->ino, num);
+        }
+
+        vfs_index_add_entry (index, dir_num, GPOINTER_TO_UINT (num), ent->name);
+
+        if (is_new && S_ISDIR (ent->ino->st.st_mode))
+            vfs_s_index_add_dir (index, inodes, ent->ino, GPOINTER_TO_UINT (num));
+    }
+}
+
 
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
@@ -887,6 +1085,7 @@ vfs_s_new_inode (struct vfs_class *me, struct vfs_s_super *super, struct stat *i
     if (initstat)
         ino->st = *initstat;
     ino->super = super;
+    ino->subdir = g_queue_new ();
     ino->st.st_nlink = 0;
     ino->st.st_ino = MEDATA->inode_counter++;
     ino->st.st_dev = MEDATA->rdev;
@@ -914,8 +1113,11 @@ vfs_s_free_inode (struct vfs_class *me, struct vfs_s_inode *ino)
         return;
     }
 
-    while (ino->subdir != NULL)
-        vfs_s_free_entry (me, (struct vfs_s_entry *) ino->subdir->data);
+    /* entries are removed from the list head, no index is needed for that */
+    vfs_s_subdir_index_free (ino);
+    while (!g_queue_is_empty (ino->subdir))
+        vfs_s_free_entry (me, (struct vfs_s_entry *) g_queue_peek_head (ino->subdir));
+    g_queue_free (ino->subdir);
 
     CALL (free_inode) (me, ino);
     g_free (ino->linkname);
@@ -954,7 +1156,7 @@ void
 vfs_s_free_entry (struct vfs_class *me, struct vfs_s_entry *ent)
 {
     if (ent->dir != NULL)
-        ent->dir->subdir = g_list_remove (ent->dir->subdir, ent);
+        vfs_s_subdir_remove (ent->dir, ent);
 
     MC_PTR_FREE (ent->name);
 
@@ -978,7 +1180,16 @@ vfs_s_insert_entry (struct vfs_class *me, struct vfs_s_inode *dir, struct vfs_s_
     ent->dir = dir;
 
     ent->ino->st.st_nlink++;
-    dir->subdir = g_list_append (dir->subdir, ent);
+    g_queue_push_tail (dir->subdir, ent);
+
+    if (dir->subdir_index != NULL && ent->name != NULL)
+    {
+        if (g_hash_table_lookup (dir->subdir_index, ent->name) == NULL)
+            g_hash_table_insert (dir->subdir_index, ent->name,
+                                 g_queue_peek_tail_link (dir->subdir));
+        else
+            dir->subdir_hidden++;
+    }
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1283,6 +1494,7 @@ vfs_s_open (const vfs_path_t * vpath, int flags, mode_t mode)
     fh->handle = -1;
     fh->changed = was_changed;
     fh->linear = 0;
+    fh->readahead = NULL;
     fh->data = NULL;
 
     if (IS_LINEAR (flags))
@@ -1356,14 +1568,14 @@ vfs_s_retrieve_file (struct vfs_class *me, struct vfs_s_inode *ino)
         goto error_4;
     }
 
-    if (!MEDATA->linear_start (me, &fh, 0))
+    if (!vfs_s_linear_start (me, &fh, 0))
         goto error_3;
 
     /* Clear the interrupt status */
     tty_got_interrupt ();
     tty_enable_interrupt_key ();
 
-    while ((n = MEDATA->linear_read (me, &fh, buffer, sizeof (buffer))))
+    while ((n = vfs_s_linear_read (me, &fh, buffer, sizeof (buffer))))
     {
         int t;
         if (n < 0)
@@ -1383,7 +1595,7 @@ vfs_s_retrieve_file (struct vfs_class *me, struct vfs_s_inode *ino)
             goto error_1;
         }
     }
-    MEDATA->linear_close (me, &fh);
+    vfs_s_linear_close (me, &fh);
     close (handle);
 
     tty_disable_interrupt_key ();
@@ -1391,7 +1603,7 @@ vfs_s_retrieve_file (struct vfs_class *me, struct vfs_s_inode *ino)
     return 0;
 
   error_1:
-    MEDATA->linear_close (me, &fh);
+    vfs_s_linear_close (me, &fh);
   error_3:
     tty_disable_interrupt_key ();
     close (handle);
@@ -1402,6 +1614,86 @@ vfs_s_retrieve_file (struct vfs_class *me, struct vfs_s_inode *ino)
     return -1;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Build the directory tree of the archive from the index saved by vfs_s_save_index().
+ * The root inode of the archive must be created already.
+ *
+ * @param st stat of the archive file
+ *
+ * @return TRUE if the tree is loaded, FALSE if there is no valid index
+ */
+
+gboolean
+vfs_s_load_index (struct vfs_class *me, struct vfs_s_super *super, const struct stat *st)
+{
+    vfs_index_t *index;
+    struct vfs_s_inode **inodes;
+    guint i, count;
+
+    index = vfs_index_load (me->prefix, super->name, st);
+    if (index == NULL)
+        return FALSE;
+
+    inodes = g_new0 (struct vfs_s_inode *, vfs_index_get_inode_count (index));
+    inodes[0] = super->root;
+
+    count = vfs_index_get_entry_count (index);
+    for (i = 0; i < count; i++)
+    {
+        guint dir, ino;
+        const char *name;
+
+        /* directory of the entry is before the entry */
+        name = vfs_index_get_entry (index, i, &dir, &ino);
+        if (inodes[ino] == NULL)
+        {
+            struct stat ino_st;
+            off_t data_offset;
+            const char *linkname;
+
+            linkname = vfs_index_get_inode (index, ino, &ino_st, &data_offset);
+            inodes[ino] = vfs_s_new_inode (me, super, &ino_st);
+            inodes[ino]->linkname = g_strdup (linkname);
+            inodes[ino]->data_offset = data_offset;
+        }
+
+        vfs_s_insert_entry (me, inodes[dir], vfs_s_new_entry (me, name, inodes[ino]));
+    }
+
+    g_free (inodes);
+    vfs_index_free (index);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Save the directory tree of the archive to the cache, so the archive isn't read again
+ * while it isn't changed.
+ *
+ * @param st stat of the archive file
+ */
+
+void
+vfs_s_save_index (struct vfs_class *me, struct vfs_s_super *super, const struct stat *st)
+{
+    vfs_index_t *index;
+    GHashTable *inodes;
+    guint root;
+
+    index = vfs_index_new ();
+    inodes = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    root = vfs_index_add_inode (index, &super->root->st, NULL, super->root->data_offset);
+    g_hash_table_insert (inodes, super->root, GUINT_TO_POINTER (root));
+    vfs_s_index_add_dir (index, inodes, super->root, root);
+
+    g_hash_table_destroy (inodes);
+    vfs_index_save (index, me->prefix, super->name, st);
+    vfs_index_free (index);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /* ----------------------------- Stamping support -------------------------- */
 
@@ -1590,7 +1882,11 @@ vfs_s_normalize_filename_leading_spaces (struct vfs_s_inode *root_inode, size_t
 {
     GList *iter;
 
-    for (iter = root_inode->subdir; iter != NULL; iter = g_list_next (iter))
+    /* names are changed here, so index must be rebuilt */
+    vfs_s_subdir_index_free (root_inode);
+
+    for (iter = g_queue_peek_head_link (root_inode->subdir); iter != NULL;
+         iter = g_list_next (iter))
     {
         struct vfs_s_entry *entry = (struct vfs_s_entry *) iter->data;
         if ((size_t) entry->ino->data_offset > final_num_spaces)
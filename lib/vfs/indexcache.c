@@ -0,0 +1,626 @@
+/*
+   Virtual File System: cache of archive indexes
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: Virtual File System: cache of archive indexes
+ *
+ * The directory tree of an archive is saved to the cache directory after the archive is read,
+ * so the archive isn't read again when it is opened next time and it isn't changed.
+ *
+ * The index file consists of a header, a table of inodes, a table of entries and
+ * a string table. Numbers are in byte order of the host and records are aligned, so the
+ * file is mapped to memory and used as it is. Inode 0 is the root directory. An entry
+ * refers to its directory and to its inode by their numbers in the table of inodes;
+ * a directory is referred by an entry before the entries in it.
+ *
+ * The index is valid while the name, size, modification time and inode of the archive
+ * are the same as they were when the index was saved.
+ *
+ * Index files are touched when they are loaded. Files unused for VFS_INDEX_MAX_AGE are removed
+ * when an index is saved, and the least recently used ones are removed while the cache is
+ * larger than VFS_INDEX_MAX_SIZE.
+ */
+
+#include <config.h>
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "lib/global.h"
+#include "lib/fileloc.h"
+#include "lib/mcconfig.h"
+#include "lib/util.h"
+
+#include "indexcache.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#define VFS_INDEX_MAGIC "MCVFSIDX"
+#define VFS_INDEX_VERSION 1
+#define VFS_INDEX_BYTE_ORDER 0x01020304
+
+/* no string */
+#define VFS_INDEX_NONE G_MAXUINT32
+
+/* limits of the cache directory */
+#define VFS_INDEX_MAX_AGE (30 * 24 * 60 * 60)
+#define VFS_INDEX_MAX_SIZE (64 * 1024 * 1024)
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    char magic[8];
+    guint32 version;
+    guint32 byte_order;
+    /* the archive */
+    gint64 size;
+    gint64 mtime;
+    guint64 ino;
+    guint64 dev;
+    /* tables */
+    guint32 inode_count;
+    guint32 entry_count;
+    guint32 strings_size;
+    guint32 key;                /* string with prefix and name of the archive */
+} vfs_index_header_t;
+
+typedef struct
+{
+    gint64 size;
+    gint64 data_offset;
+    gint64 mtime;
+    gint64 atime;
+    gint64 ctime;
+    guint64 rdev;
+    guint32 mode;
+    guint32 uid;
+    guint32 gid;
+    guint32 linkname;
+} vfs_index_inode_t;
+
+typedef struct
+{
+    guint32 dir;
+    guint32 ino;
+    guint32 name;
+} vfs_index_entry_t;
+
+struct vfs_index_struct
+{
+    /* loaded index */
+    GMappedFile *file;
+    const vfs_index_inode_t *inodes;
+    const vfs_index_entry_t *entries;
+    const char *strings;
+    guint inode_count;
+    guint entry_count;
+
+    /* new index */
+    GArray *new_inodes;
+    GArray *new_entries;
+    GString *new_strings;
+};
+
+/* file of the cache directory */
+typedef struct
+{
+    char *path;
+    time_t mtime;
+    off_t size;
+} vfs_index_file_t;
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+vfs_index_key (const char *prefix, const char *name)
+{
+    return g_strconcat (prefix, "\n", name, (char *) NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Name of index file: the key could be too long for a file name */
+
+static char *
+vfs_index_filename (const char *key)
+{
+    char *checksum, *filename;
+
+    checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, key, -1);
+    filename = mc_build_filename (mc_config_get_cache_path (), MC_VFS_INDEX_DIR, checksum, NULL);
+    g_free (checksum);
+
+    return filename;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static guint32
+vfs_index_add_string (vfs_index_t * index, const char *str)
+{
+    guint32 offset;
+
+    if (str == NULL)
+        return VFS_INDEX_NONE;
+
+    offset = (guint32) index->new_strings->len;
+    g_string_append_len (index->new_strings, str, strlen (str) + 1);
+    return offset;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+vfs_index_set_header (vfs_index_header_t * header, const struct stat *st)
+{
+    memset (header, 0, sizeof (*header));
+    memcpy (header->magic, VFS_INDEX_MAGIC, sizeof (header->magic));
+    header->version = VFS_INDEX_VERSION;
+    header->byte_order = VFS_INDEX_BYTE_ORDER;
+    header->size = (gint64) st->st_size;
+    header->mtime = (gint64) st->st_mtime;
+    header->ino = (guint64) st->st_ino;
+    header->dev = (guint64) st->st_dev;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Check the tree: every entry is in a directory which is already in the tree */
+
+static gboolean
+vfs_index_check_tree (const vfs_index_t * index, guint32 strings_size)
+{
+    guint8 *in_tree;
+    guint i;
+    gboolean ok = TRUE;
+
+    for (i = 0; ok && i < index->inode_count; i++)
+        ok = (index->inodes[i].linkname == VFS_INDEX_NONE
+              || index->inodes[i].linkname < strings_size);
+
+    if (!ok || !S_ISDIR (index->inodes[0].mode))
+        return FALSE;
+
+    in_tree = g_new0 (guint8, index->inode_count);
+    in_tree[0] = 1;
+
+    for (i = 0; ok && i < index->entry_count; i++)
+    {
+        const vfs_index_entry_t *e = &index->entries[i];
+
+        ok = e->dir < index->inode_count && in_tree[e->dir] != 0
+            && S_ISDIR (index->inodes[e->dir].mode)
+            && e->ino != 0 && e->ino < index->inode_count
+            && e->name < strings_size && index->strings[e->name] != '\0'
+            && strchr (index->strings + e->name, PATH_SEP) == NULL;
+        if (ok)
+            in_tree[e->ino] = 1;
+    }
+
+    /* every inode is in the tree */
+    for (i = 0; ok && i < index->inode_count; i++)
+        ok = in_tree[i] != 0;
+
+    g_free (in_tree);
+    return ok;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+vfs_index_map (vfs_index_t * index, const char *key, const struct stat *st)
+{
+    const char *data;
+    guint64 length;
+    vfs_index_header_t header, expected;
+
+    data = g_mapped_file_get_contents (index->file);
+    length = g_mapped_file_get_length (index->file);
+
+    if (length < sizeof (header))
+        return FALSE;
+
+    memcpy (&header, data, sizeof (header));
+    vfs_index_set_header (&expected, st);
+    if (memcmp (header.magic, expected.magic, sizeof (header.magic)) != 0
+        || header.version != expected.version || header.byte_order != expected.byte_order
+        || header.size != expected.size || header.mtime != expected.mtime
+        || header.ino != expected.ino || header.dev != expected.dev)
+        return FALSE;
+
+    if (header.inode_count == 0 || header.strings_size == 0
+        || length != sizeof (header) + (guint64) header.inode_count * sizeof (vfs_index_inode_t)
+        + (guint64) header.entry_count * sizeof (vfs_index_entry_t) + header.strings_size)
+        return FALSE;
+
+    index->inodes = (const vfs_index_inode_t *) (data + sizeof (header));
+    index->inode_count = header.inode_count;
+    index->entries = (const vfs_index_entry_t *) (index->inodes + header.inode_count);
+    index->entry_count = header.entry_count;
+    index->strings = (const char *) (index->entries + header.entry_count);
+
+    /* strings are terminated, the key is the same */
+    if (index->strings[header.strings_size - 1] != '\0' || header.key >= header.strings_size
+        || strcmp (index->strings + header.key, key) != 0)
+        return FALSE;
+
+    return vfs_index_check_tree (index, header.strings_size);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+vfs_index_file_cmp (gconstpointer a, gconstpointer b)
+{
+    const vfs_index_file_t *fa = (const vfs_index_file_t *) a;
+    const vfs_index_file_t *fb = (const vfs_index_file_t *) b;
+
+    return fa->mtime < fb->mtime ? -1 : (fa->mtime > fb->mtime ? 1 : 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remove old index files from the cache directory and the least recently used ones while
+ * the cache is too large.
+ *
+ * @param dir the cache directory
+ * @param keep the file which isn't removed
+ */
+
+static void
+vfs_index_sweep (const char *dir, const char *keep)
+{
+    GDir *d;
+    const char *name;
+    GArray *files;
+    time_t now;
+    off_t total = 0;
+    guint i;
+
+    d = g_dir_open (dir, 0, NULL);
+    if (d == NULL)
+        return;
+
+    files = g_array_new (FALSE, FALSE, sizeof (vfs_index_file_t));
+    now = time (NULL);
+
+    while ((name = g_dir_read_name (d)) != NULL)
+    {
+        vfs_index_file_t f;
+        struct stat st;
+
+        f.path = g_build_filename (dir, name, (char *) NULL);
+        if (strcmp (f.path, keep) == 0 || stat (f.path, &st) != 0 || !S_ISREG (st.st_mode))
+            g_free (f.path);
+        else if (now - st.st_mtime > VFS_INDEX_MAX_AGE)
+        {
+            unlink (f.path);
+            g_free (f.path);
+        }
+        else
+        {
+            f.mtime = st.st_mtime;
+            f.size = st.st_size;
+            total += f.size;
+            g_array_append_val (files, f);
+        }
+    }
+
+    g_dir_close (d);
+
+    g_array_sort (files, vfs_index_file_cmp);
+
+    for (i = 0; i < files->len; i++)
+    {
+        vfs_index_file_t *f = &g_array_index (files, vfs_index_file_t, i);
+
+        if (total > VFS_INDEX_MAX_SIZE)
+        {
+            unlink (f->path);
+            total -= f->size;
+        }
+        g_free (f->path);
+    }
+
+    g_array_free (files, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create an empty index to be saved.
+ * The first inode added to the index must be the root directory.
+ */
+
+vfs_index_t *
+vfs_index_new (void)
+{
+    vfs_index_t *index;
+
+    index = g_new0 (vfs_index_t, 1);
+    index->new_inodes = g_array_new (FALSE, FALSE, sizeof (vfs_index_inode_t));
+    index->new_entries = g_array_new (FALSE, FALSE, sizeof (vfs_index_entry_t));
+    index->new_strings = g_string_new (NULL);
+
+    return index;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add an inode to the new index.
+ *
+ * @return number of the inode
+ */
+
+guint
+vfs_index_add_inode (vfs_index_t * index, const struct stat *st, const char *linkname,
+                     off_t data_offset)
+{
+    vfs_index_inode_t inode;
+
+    memset (&inode, 0, sizeof (inode));
+    inode.size = (gint64) st->st_size;
+    inode.data_offset = (gint64) data_offset;
+    inode.mtime = (gint64) st->st_mtime;
+    inode.atime = (gint64) st->st_atime;
+    inode.ctime = (gint64) st->st_ctime;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    inode.rdev = (guint64) st->st_rdev;
+#endif
+    inode.mode = (guint32) st->st_mode;
+    inode.uid = (guint32) st->st_uid;
+    inode.gid = (guint32) st->st_gid;
+    inode.linkname = vfs_index_add_string (index, linkname);
+
+    g_array_append_val (index->new_inodes, inode);
+    return index->new_inodes->len - 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add an entry to the new index.
+ *
+ * @param dir number of inode of the directory
+ * @param ino number of inode of the entry
+ * @param name name of the entry
+ */
+
+void
+vfs_index_add_entry (vfs_index_t * index, guint dir, guint ino, const char *name)
+{
+    vfs_index_entry_t entry;
+
+    entry.dir = dir;
+    entry.ino = ino;
+    entry.name = vfs_index_add_string (index, name);
+
+    g_array_append_val (index->new_entries, entry);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Write the new index to the cache directory. Unused old indexes are removed.
+ *
+ * @param prefix identifier of the filesystem
+ * @param name name of the archive
+ * @param st stat of the archive
+ *
+ * @return TRUE on success
+ */
+
+gboolean
+vfs_index_save (vfs_index_t * index, const char *prefix, const char *name, const struct stat *st)
+{
+    vfs_index_header_t header;
+    char *key, *dir, *filename;
+    gsize inodes_size, entries_size, length;
+    char *data;
+    gboolean ret = FALSE;
+
+    vfs_index_set_header (&header, st);
+
+    key = vfs_index_key (prefix, name);
+    header.key = vfs_index_add_string (index, key);
+
+    if (index->new_inodes->len == 0 || index->new_strings->len > G_MAXUINT32)
+    {
+        g_free (key);
+        return FALSE;
+    }
+
+    header.inode_count = index->new_inodes->len;
+    header.entry_count = index->new_entries->len;
+    header.strings_size = (guint32) index->new_strings->len;
+
+    inodes_size = index->new_inodes->len * sizeof (vfs_index_inode_t);
+    entries_size = index->new_entries->len * sizeof (vfs_index_entry_t);
+    length = sizeof (header) + inodes_size + entries_size + index->new_strings->len;
+
+    data = g_malloc (length);
+    memcpy (data, &header, sizeof (header));
+    memcpy (data + sizeof (header), index->new_inodes->data, inodes_size);
+    memcpy (data + sizeof (header) + inodes_size, index->new_entries->data, entries_size);
+    memcpy (data + sizeof (header) + inodes_size + entries_size, index->new_strings->str,
+            index->new_strings->len);
+
+    dir = mc_build_filename (mc_config_get_cache_path (), MC_VFS_INDEX_DIR, NULL);
+    if (g_mkdir_with_parents (dir, 0700) == 0)
+    {
+        filename = vfs_index_filename (key);
+        /* the file is replaced atomically */
+        ret = g_file_set_contents (filename, data, length, NULL);
+        vfs_index_sweep (dir, filename);
+        g_free (filename);
+    }
+
+    g_free (dir);
+    g_free (data);
+    g_free (key);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Load the index of the archive from the cache directory.
+ *
+ * @param prefix identifier of the filesystem
+ * @param name name of the archive
+ * @param st stat of the archive
+ *
+ * @return index or NULL if there is no valid index for the archive
+ */
+
+vfs_index_t *
+vfs_index_load (const char *prefix, const char *name, const struct stat *st)
+{
+    vfs_index_t *index = NULL;
+    char *key, *filename;
+    GMappedFile *file;
+
+    key = vfs_index_key (prefix, name);
+    filename = vfs_index_filename (key);
+    file = g_mapped_file_new (filename, FALSE, NULL);
+
+    if (file != NULL)
+    {
+        index = g_new0 (vfs_index_t, 1);
+        index->file = file;
+        if (!vfs_index_map (index, key, st))
+        {
+            vfs_index_free (index);
+            index = NULL;
+        }
+        else
+        {
+            /* the index is used, keep it in the cache */
+            (void) utime (filename, NULL);
+        }
+    }
+
+    g_free (filename);
+    g_free (key);
+    return index;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+guint
+vfs_index_get_inode_count (const vfs_index_t * index)
+{
+    return index->inode_count;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get an inode of the loaded index.
+ *
+ * @param ino number of the inode
+ * @param st stat of the inode. Only type, permissions, owner, size, times and device are set
+ * @param data_offset offset of data of the inode
+ *
+ * @return target of symlink or NULL
+ */
+
+const char *
+vfs_index_get_inode (const vfs_index_t * index, guint ino, struct stat *st, off_t * data_offset)
+{
+    const vfs_index_inode_t *inode = &index->inodes[ino];
+
+    memset (st, 0, sizeof (*st));
+    st->st_mode = (mode_t) inode->mode;
+    st->st_uid = (uid_t) inode->uid;
+    st->st_gid = (gid_t) inode->gid;
+    st->st_size = (off_t) inode->size;
+    st->st_mtime = (time_t) inode->mtime;
+    st->st_atime = (time_t) inode->atime;
+    st->st_ctime = (time_t) inode->ctime;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    st->st_rdev = (dev_t) inode->rdev;
+#endif
+    *data_offset = (off_t) inode->data_offset;
+
+    return inode->linkname == VFS_INDEX_NONE ? NULL : index->strings + inode->linkname;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+guint
+vfs_index_get_entry_count (const vfs_index_t * index)
+{
+    return index->entry_count;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get an entry of the loaded index. Entries are in the order they were added.
+ *
+ * @param i number of the entry
+ * @param dir number of inode of the directory
+ * @param ino number of inode of the entry
+ *
+ * @return name of the entry
+ */
+
+const char *
+vfs_index_get_entry (const vfs_index_t * index, guint i, guint * dir, guint * ino)
+{
+    const vfs_index_entry_t *entry = &index->entries[i];
+
+    *dir = entry->dir;
+    *ino = entry->ino;
+
+    return index->strings + entry->name;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_index_free (vfs_index_t * index)
+{
+    if (index == NULL)
+        return;
+
+    if (index->file != NULL)
+        g_mapped_file_unref (index->file);
+    if (index->new_inodes != NULL)
+        g_array_free (index->new_inodes, TRUE);
+    if (index->new_entries != NULL)
+        g_array_free (index->new_entries, TRUE);
+    if (index->new_strings != NULL)
+        g_string_free (index->new_strings, TRUE);
+
+    g_free (index);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,44 @@
+/**
+ * \file
+ * \brief Header: Virtual File System: cache of archive indexes
+ */
+
+#ifndef MC__VFS_INDEXCACHE_H
+#define MC__VFS_INDEXCACHE_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "lib/global.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+typedef struct vfs_index_struct vfs_index_t;
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+vfs_index_t *vfs_index_new (void);
+guint vfs_index_add_inode (vfs_index_t * index, const struct stat *st, const char *linkname,
+                           off_t data_offset);
+void vfs_index_add_entry (vfs_index_t * index, guint dir, guint ino, const char *name);
+gboolean vfs_index_save (vfs_index_t * index, const char *prefix, const char *name,
+                         const struct stat *st);
+
+vfs_index_t *vfs_index_load (const char *prefix, const char *name, const struct stat *st);
+guint vfs_index_get_inode_count (const vfs_index_t * index);
+const char *vfs_index_get_inode (const vfs_index_t * index, guint ino, struct stat *st,
+                                 off_t * data_offset);
+guint vfs_index_get_entry_count (const vfs_index_t * index);
+const char *vfs_index_get_entry (const vfs_index_t * index, guint i, guint * dir, guint * ino);
+
+void vfs_index_free (vfs_index_t * index);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__VFS_INDEXCACHE_H */
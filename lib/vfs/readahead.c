@@ -0,0 +1,302 @@
+/*
+   Virtual File System: read-ahead of linear transfers
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: Virtual File System: read-ahead of linear transfers
+ *
+ * Data of a remote file is received by a separate thread into a ring of buffers while the main
+ * thread writes the previous buffers to a local file or passes them to the reader. Full buffers
+ * go from the thread to the reader through one queue and are given back through another one,
+ * so the thread waits only if all buffers are full.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/tty/tty.h"        /* tty_got_interrupt() */
+
+#include "readahead.h"
+
+/*** global variables ****************************************************************************/
+
+/* size of read-ahead buffers of a transfer in KiB, 0 to read in the main thread */
+int vfs_readahead_size = 512;
+
+/*** file scope macro definitions ****************************************************************/
+
+#define READAHEAD_BUFFERS 8
+
+#define READAHEAD_MIN_BUFFER_SIZE (4 * 1024)
+
+/* how often the reader waiting for data checks for interrupt and the thread waiting for data
+   checks for the stop request, in microseconds */
+#define READAHEAD_POLL_INTERVAL (100 * 1000)
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    char *data;
+    size_t len;
+    /* result of the last read: > 0 if more data follows, 0 at the end of data, -1 on error */
+    ssize_t result;
+    int error;
+} readahead_buffer_t;
+
+struct vfs_readahead_struct
+{
+    vfs_readahead_func_t func;
+    void *data;
+    size_t buffer_size;
+    readahead_buffer_t buffers[READAHEAD_BUFFERS];
+
+    GThread *thread;
+    GAsyncQueue *free_buffers;
+    GAsyncQueue *full_buffers;
+    volatile gint stop;
+
+    /* owned by the reader */
+    readahead_buffer_t *current;
+    size_t pos;
+};
+
+/*** file scope variables ************************************************************************/
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Thread function: fill free buffers until the end of data or an error.
+ * A buffer is passed on before it is full if the reader is waiting for data.
+ * If no data comes for a while, the read function returns EAGAIN and the stop request is checked.
+ */
+
+static gpointer
+vfs_readahead_thread (gpointer data)
+{
+    vfs_readahead_t *ra = (vfs_readahead_t *) data;
+    ssize_t n = 1;
+
+    while (n > 0)
+    {
+        readahead_buffer_t *buf;
+
+        buf = (readahead_buffer_t *) g_async_queue_pop (ra->free_buffers);
+        if (g_atomic_int_get (&ra->stop) != 0)
+            break;
+
+        buf->len = 0;
+        buf->error = 0;
+
+        do
+        {
+            n = ra->func (ra->data, buf->data + buf->len, ra->buffer_size - buf->len);
+            if (n > 0)
+                buf->len += n;
+            else if (n < 0 && errno == EAGAIN)
+                n = 1;
+            else if (n < 0)
+                buf->error = errno;
+        }
+        while (n > 0 && buf->len < ra->buffer_size
+               && (buf->len == 0 || g_async_queue_length (ra->full_buffers) >= 0)
+               && g_atomic_int_get (&ra->stop) == 0);
+
+        buf->result = n;
+        g_async_queue_push (ra->full_buffers, buf);
+    }
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start reading data ahead in a new thread.
+ *
+ * @param func function reading the data, it is called in the read-ahead thread only
+ * @param data argument of @func
+ *
+ * @return read-ahead, or NULL if it is disabled or the thread can't be created
+ */
+
+vfs_readahead_t *
+vfs_readahead_new (vfs_readahead_func_t func, void *data)
+{
+    vfs_readahead_t *ra;
+    int i;
+
+    if (vfs_readahead_size <= 0)
+        return NULL;
+
+    ra = g_new0 (vfs_readahead_t, 1);
+    ra->func = func;
+    ra->data = data;
+    ra->buffer_size = (size_t) vfs_readahead_size * 1024 / READAHEAD_BUFFERS;
+    ra->buffer_size = MAX (ra->buffer_size, READAHEAD_MIN_BUFFER_SIZE);
+
+    ra->free_buffers = g_async_queue_new ();
+    ra->full_buffers = g_async_queue_new ();
+
+    for (i = 0; i < READAHEAD_BUFFERS; i++)
+    {
+        ra->buffers[i].data = g_malloc (ra->buffer_size);
+        g_async_queue_push (ra->free_buffers, &ra->buffers[i]);
+    }
+
+    ra->thread = g_thread_try_new ("vfs-readahead", vfs_readahead_thread, ra, NULL);
+    if (ra->thread == NULL)
+    {
+        vfs_readahead_free (ra);
+        ra = NULL;
+    }
+
+    return ra;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read data received by the read-ahead thread, waiting for it if necessary.
+ * The wait is broken by the interrupt key if it is enabled.
+ *
+ * @return number of bytes read, 0 at the end of data or -1 with errno set on error
+ */
+
+ssize_t
+vfs_readahead_read (vfs_readahead_t * ra, void *buffer, size_t count)
+{
+    size_t n;
+
+    while (ra->current == NULL || ra->pos == ra->current->len)
+    {
+        if (ra->current != NULL)
+        {
+            /* the end and errors are kept to be returned again */
+            if (ra->current->result <= 0)
+            {
+                errno = ra->current->error;
+                return ra->current->result;
+            }
+
+            g_async_queue_push (ra->free_buffers, ra->current);
+            ra->current = NULL;
+        }
+
+        while (ra->current == NULL)
+        {
+            ra->current = (readahead_buffer_t *) g_async_queue_timeout_pop (ra->full_buffers,
+                                                                            READAHEAD_POLL_INTERVAL);
+            if (ra->current == NULL && tty_got_interrupt ())
+            {
+                errno = EINTR;
+                return -1;
+            }
+        }
+
+        ra->pos = 0;
+    }
+
+    n = MIN (count, ra->current->len - ra->pos);
+    memcpy (buffer, ra->current->data + ra->pos, n);
+    ra->pos += n;
+
+    return (ssize_t) n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read function helper: read data from a descriptor, but wait for it no longer than the poll
+ * interval, so that a stopped read-ahead doesn't wait for a stalled connection.
+ *
+ * @return number of bytes read, 0 at the end of data or -1 with errno set on error;
+ *         EAGAIN if no data came in time
+ */
+
+ssize_t
+vfs_readahead_recv (int fd, void *buffer, size_t count)
+{
+    fd_set set;
+    struct timeval time_out;
+    int v;
+    ssize_t n;
+
+    time_out.tv_sec = 0;
+    time_out.tv_usec = READAHEAD_POLL_INTERVAL;
+    FD_ZERO (&set);
+    FD_SET (fd, &set);
+    v = select (fd + 1, &set, NULL, NULL, &time_out);
+    if (v == 0 || (v < 0 && errno == EINTR))
+    {
+        errno = EAGAIN;
+        return -1;
+    }
+    if (v < 0)
+        return -1;
+
+    while ((n = read (fd, buffer, count)) < 0 && errno == EINTR)
+        ;
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stop the read-ahead thread and free the buffers. Data not read yet is lost.
+ * If the thread is inside the read function, it is waited for, so the read function must not
+ * wait for data longer than a moment, see vfs_readahead_recv().
+ */
+
+void
+vfs_readahead_free (vfs_readahead_t * ra)
+{
+    int i;
+
+    if (ra->thread != NULL)
+    {
+        gpointer buf;
+
+        /* give all buffers back so that the thread wakes up and sees the stop request */
+        g_atomic_int_set (&ra->stop, 1);
+        if (ra->current != NULL)
+            g_async_queue_push (ra->free_buffers, ra->current);
+        while ((buf = g_async_queue_try_pop (ra->full_buffers)) != NULL)
+            g_async_queue_push (ra->free_buffers, buf);
+
+        g_thread_join (ra->thread);
+    }
+
+    g_async_queue_unref (ra->free_buffers);
+    g_async_queue_unref (ra->full_buffers);
+
+    for (i = 0; i < READAHEAD_BUFFERS; i++)
+        g_free (ra->buffers[i].data);
+    g_free (ra);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,42 @@
+/**
+ * \file
+ * \brief Header: Virtual File System: read-ahead of linear transfers
+ */
+
+#ifndef MC__VFS_READAHEAD_H
+#define MC__VFS_READAHEAD_H
+
+#include <sys/types.h>
+
+#include "lib/global.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+typedef struct vfs_readahead_struct vfs_readahead_t;
+
+/**
+ * Function reading the data in the read-ahead thread.
+ * Returns the number of bytes read, 0 at the end of data or -1 with errno set on error.
+ * EAGAIN means that no data came for a while, the function is called again unless the
+ * read-ahead is being stopped.
+ */
+typedef ssize_t (*vfs_readahead_func_t) (void *data, void *buffer, size_t count);
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+extern int vfs_readahead_size;
+
+/*** declarations of public functions ************************************************************/
+
+vfs_readahead_t *vfs_readahead_new (vfs_readahead_func_t func, void *data);
+ssize_t vfs_readahead_read (vfs_readahead_t * ra, void *buffer, size_t count);
+ssize_t vfs_readahead_recv (int fd, void *buffer, size_t count);
+void vfs_readahead_free (vfs_readahead_t * ra);
+
+/*** inline functions ****************************************************************************/
+
+#endif /* MC__VFS_READAHEAD_H */
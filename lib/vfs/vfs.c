@@ -44,6 +44,16 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_IOCTL_H
+#include <sys/ioctl.h>
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#ifdef HAVE_LINUX_FS_H
+#include <linux/fs.h>           /* FICLONE */
+#endif
 
 #include "lib/global.h"
 #include "lib/strutil.h"
@@ -237,6 +247,21 @@ vfs_class_data_find_by_handle (int handle)
     return h == NULL ? NULL : h->fsinfo;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Find OS file descriptor of file opened by local VFS class */
+
+int *
+vfs_local_fd_find_by_handle (int handle)
+{
+    struct vfs_openfile *h;
+
+    h = vfs_get_openfile (handle);
+    if (h == NULL || (h->vclass->flags & VFSF_LOCAL) == 0)
+        return NULL;
+
+    return (int *) h->fsinfo;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /** Find VFS class by file handle */
 
@@ -659,3 +684,112 @@ vfs_preallocate (int dest_vfs_fd, off_t src_fsize, off_t dest_fsize)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Make destination file share all data blocks of source file (reflink).
+ * Both files must reside on the same local filesystem which supports it.
+ *
+ * @param src_vfs_fd mc VFS handle of source file
+ * @param dest_vfs_fd mc VFS handle of destination file
+ *
+ * @return 0 if success and non-zero otherwise.
+ * Note: function doesn't touch errno global variable.
+ */
+
+int
+vfs_clone_local (int src_vfs_fd, int dest_vfs_fd)
+{
+#ifndef FICLONE
+    (void) src_vfs_fd;
+    (void) dest_vfs_fd;
+    return -1;
+
+#else /* FICLONE */
+    int *src_fd, *dest_fd;
+    int saved_errno;
+    int ret;
+
+    src_fd = vfs_local_fd_find_by_handle (src_vfs_fd);
+    dest_fd = vfs_local_fd_find_by_handle (dest_vfs_fd);
+    if (src_fd == NULL || dest_fd == NULL)
+        return -1;
+
+    saved_errno = errno;
+    ret = ioctl (*dest_fd, FICLONE, *src_fd);
+    errno = saved_errno;
+
+    return ret;
+
+#endif /* FICLONE */
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy data between two local files inside the kernel, without passing it
+ * through user space. Current file positions of both files are used and advanced.
+ *
+ * @param src_vfs_fd mc VFS handle of source file
+ * @param dest_vfs_fd mc VFS handle of destination file
+ * @param count maximum number of bytes to copy
+ *
+ * @return number of copied bytes, 0 at end of source file and -1 on error.
+ * If files cannot be copied in the kernel, errno is set to ENOSYS.
+ * Files of pseudo filesystems may return 0 before their end, so the caller should copy
+ * only files of known size and check that all of it is copied.
+ */
+
+ssize_t
+vfs_copy_local_chunk (int src_vfs_fd, int dest_vfs_fd, size_t count)
+{
+#if !defined(HAVE_COPY_FILE_RANGE) && !defined(HAVE_SENDFILE)
+    (void) src_vfs_fd;
+    (void) dest_vfs_fd;
+    (void) count;
+
+    errno = ENOSYS;
+    return -1;
+
+#else /* HAVE_COPY_FILE_RANGE || HAVE_SENDFILE */
+    int *src_fd, *dest_fd;
+    ssize_t ret;
+
+    src_fd = vfs_local_fd_find_by_handle (src_vfs_fd);
+    dest_fd = vfs_local_fd_find_by_handle (dest_vfs_fd);
+    if (src_fd == NULL || dest_fd == NULL)
+    {
+        errno = ENOSYS;
+        return -1;
+    }
+
+#ifdef HAVE_COPY_FILE_RANGE
+    {
+        /* set if running kernel doesn't have copy_file_range() at all */
+        static gboolean copy_file_range_missing = FALSE;
+
+        if (!copy_file_range_missing)
+        {
+            ret = copy_file_range (*src_fd, NULL, *dest_fd, NULL, count, 0);
+            if (ret >= 0)
+                return ret;
+            if (errno == ENOSYS)
+                copy_file_range_missing = TRUE;
+            else if (errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP)
+                return -1;
+        }
+    }
+#endif /* HAVE_COPY_FILE_RANGE */
+
+#ifdef HAVE_SENDFILE
+    ret = sendfile (*dest_fd, *src_fd, NULL, count);
+    if (ret < 0 && errno == EINVAL)
+        errno = ENOSYS;
+#else
+    errno = ENOSYS;
+    ret = -1;
+#endif /* HAVE_SENDFILE */
+
+    return ret;
+
+#endif /* HAVE_COPY_FILE_RANGE || HAVE_SENDFILE */
+}
+
+/* --------------------------------------------------------------------------------------------- */
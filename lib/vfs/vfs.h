@@ -120,6 +120,7 @@ enum
     VFS_SETCTL_RUN,
     VFS_SETCTL_LOGFILE,
     VFS_SETCTL_FLUSH,           /* invalidate directory cache */
+    VFS_SETCTL_PREFETCH,        /* fetch files before reading, arg is GPtrArray of names or NULL */
 
     /* Setting this makes vfs layer give out potentially incorrect data,
        but it also makes some operations much faster. Use with caution. */
@@ -269,12 +270,16 @@ struct vfs_class *vfs_class_find_by_handle (int handle);
 
 void *vfs_class_data_find_by_handle (int handle);
 
+int *vfs_local_fd_find_by_handle (int handle);
+
 void vfs_free_handle (int handle);
 
 void vfs_setup_cwd (void);
 char *_vfs_get_cwd (void);
 
 int vfs_preallocate (int dest_desc, off_t src_fsize, off_t dest_fsize);
+int vfs_clone_local (int src_desc, int dest_desc);
+ssize_t vfs_copy_local_chunk (int src_desc, int dest_desc, size_t count);
 
 /**
  * Interface functions described in interface.c
@@ -92,7 +92,9 @@ struct vfs_s_inode
     struct vfs_s_entry *ent;    /* Our entry in the parent directory -
                                    use only for directories because they
                                    cannot be hardlinked */
-    GList *subdir;              /* If this is a directory, its entry. List of vfs_s_entry */
+    GQueue *subdir;             /* If this is a directory, its entry. List of vfs_s_entry */
+    GHashTable *subdir_index;   /* Name -> link in subdir, built for large directories only */
+    guint subdir_hidden;        /* Number of entries not in subdir_index due to duplicated names */
     struct stat st;             /* Parameters of this inode */
     char *linkname;             /* Symlink's contents */
     char *localname;            /* Filename of local file, if we have one */
@@ -108,6 +110,7 @@ typedef struct
     int handle;                 /* This is for module's use, but if != -1, will be mc_close()d */
     int changed;                /* Did this file change? */
     int linear;                 /* Is that file open with O_LINEAR? */
+    struct vfs_readahead_struct *readahead;     /* Receiving thread of the linear transfer */
     void *data;                 /* This is for filesystem-specific use */
 } vfs_file_handler_t;
 
@@ -150,6 +153,8 @@ struct vfs_s_subclass
     int (*linear_start) (struct vfs_class * me, vfs_file_handler_t * fh, off_t from);
     ssize_t (*linear_read) (struct vfs_class * me, vfs_file_handler_t * fh, void *buf, size_t len);
     void (*linear_close) (struct vfs_class * me, vfs_file_handler_t * fh);
+    /* optional: read data of linear transfer in the read-ahead thread, see vfs_s_linear_start() */
+    ssize_t (*linear_recv) (struct vfs_class * me, vfs_file_handler_t * fh, void *buf, size_t len);
     /* *INDENT-ON* */
 };
 
@@ -190,6 +195,10 @@ int vfs_s_get_line_interruptible (struct vfs_class *me, char *buffer, int size,
 /* misc */
 int vfs_s_retrieve_file (struct vfs_class *me, struct vfs_s_inode *ino);
 
+/* cache of archive indexes */
+gboolean vfs_s_load_index (struct vfs_class *me, struct vfs_s_super *super, const struct stat *st);
+void vfs_s_save_index (struct vfs_class *me, struct vfs_s_super *super, const struct stat *st);
+
 void vfs_s_normalize_filename_leading_spaces (struct vfs_s_inode *root_inode, size_t final_filepos);
 
 /*** inline functions ****************************************************************************/
@@ -43,6 +43,8 @@ AC_DEFUN([AC_G_MODULE_SUPPORTED], [
                 lib=glib ;;
             x-lgmodule*)
                 lib=gmodule ;;
+            x-lgthread*)
+                lib=gthread ;;
             *)
                 lib=
                 add="$i" ;;
@@ -78,9 +80,9 @@ AC_DEFUN([AC_CHECK_GLIB], [
         AS_HELP_STRING([--with-glib-static], [Link glib statically @<:@no@:>@]))
 
     glib_found=no
-    PKG_CHECK_MODULES(GLIB, [glib-2.0 >= 2.26], [glib_found=yes], [:])
+    PKG_CHECK_MODULES(GLIB, [glib-2.0 >= 2.26 gthread-2.0 >= 2.26], [glib_found=yes], [:])
     if test x"$glib_found" = xno; then
-        AC_MSG_ERROR([glib-2.0 not found or version too old (must be >= 2.26)])
+        AC_MSG_ERROR([glib-2.0 or gthread-2.0 not found or version too old (must be >= 2.26)])
     fi
 
 ])
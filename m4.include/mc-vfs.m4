@@ -17,6 +17,7 @@ m4_include([m4.include/vfs/mc-vfs-fish.m4])
 m4_include([m4.include/vfs/mc-vfs-undelfs.m4])
 m4_include([m4.include/vfs/mc-vfs-tarfs.m4])
 m4_include([m4.include/vfs/mc-vfs-cpiofs.m4])
+m4_include([m4.include/vfs/mc-vfs-decompress.m4])
 m4_include([m4.include/vfs/mc-vfs-samba.m4])
 
 dnl MC_VFS_CHECKS
@@ -71,6 +72,7 @@ AC_DEFUN([AC_MC_VFS_CHECKS],
 
     AC_MC_VFS_CPIOFS
     AC_MC_VFS_TARFS
+    AC_MC_VFS_DECOMPRESS
     AC_MC_VFS_SFS
     AC_MC_VFS_EXTFS
     AC_MC_VFS_UNDELFS
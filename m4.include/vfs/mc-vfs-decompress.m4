@@ -0,0 +1,21 @@
+dnl Libraries used by tar and cpio filesystems to decompress archives without temporary files
+AC_DEFUN([AC_MC_VFS_DECOMPRESS],
+[
+    if test x"$enable_vfs_tar" = x"yes" -o x"$enable_vfs_cpio" = x"yes"; then
+        AC_CHECK_HEADER([zlib.h],
+            [AC_CHECK_LIB([z], [inflatePrime],
+                [AC_DEFINE([HAVE_ZLIB], [1], [Define to decompress gzip archives with zlib])
+                 MCLIBS="$MCLIBS -lz"])])
+
+        AC_CHECK_HEADER([bzlib.h],
+            [AC_CHECK_LIB([bz2], [BZ2_bzDecompressInit],
+                [AC_DEFINE([HAVE_BZLIB], [1], [Define to decompress bzip2 archives with libbz2])
+                 MCLIBS="$MCLIBS -lbz2"])])
+
+        PKG_CHECK_MODULES(LZMA, [liblzma >= 5.0], [found_lzma=yes], [:])
+        if test x"$found_lzma" = "xyes"; then
+            AC_DEFINE([HAVE_LZMA], [1], [Define to decompress xz archives with liblzma])
+            MCLIBS="$MCLIBS $LZMA_LIBS"
+        fi
+    fi
+])
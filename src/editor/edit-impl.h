@@ -42,6 +42,9 @@
 /* Initial size of the undo stack, in bytes */
 #define START_STACK_SIZE 32
 
+/* Limit of the text saved in the undo stack by block actions, in bytes */
+#define UNDO_TEXT_MAX (32 * 1024 * 1024)
+
 /* Some codes that may be pushed onto or returned from the undo stack */
 #define CURS_LEFT       601
 #define CURS_RIGHT      602
@@ -54,6 +57,7 @@
 #define COLUMN_OFF      609
 #define DELCHAR_BR      610
 #define BACKSPACE_BR    611
+#define BLOCK_ACTION    612
 #define MARK_1          1000
 #define MARK_2          500000000
 #define MARK_CURS       1000000000
@@ -176,14 +180,18 @@ int edit_block_delete_cmd (WEdit * edit);
 void edit_delete_line (WEdit * edit);
 
 int edit_delete (WEdit * edit, gboolean byte_delete);
+void edit_delete_block (WEdit * edit, off_t len);
 int edit_backspace (WEdit * edit, gboolean byte_delete);
+void edit_backspace_block (WEdit * edit, off_t len);
 void edit_insert (WEdit * edit, int c);
+void edit_insert_block (WEdit * edit, const char *block, size_t len);
 void edit_insert_over (WEdit * edit);
 void edit_cursor_move (WEdit * edit, off_t increment);
 void edit_push_undo_action (WEdit * edit, long c);
 void edit_push_redo_action (WEdit * edit, long c);
 void edit_push_key_press (WEdit * edit);
 void edit_insert_ahead (WEdit * edit, int c);
+void edit_insert_ahead_block (WEdit * edit, const char *block, size_t len);
 off_t edit_write_stream (WEdit * edit, FILE * f);
 char *edit_get_write_filter (const vfs_path_t * write_name_vpath,
                              const vfs_path_t * filename_vpath);
@@ -206,6 +214,8 @@ void edit_replace_cmd (WEdit * edit, int again);
 void edit_search_cmd (WEdit * edit, gboolean again);
 mc_search_cbret_t edit_search_cmd_callback (const void *user_data, gsize char_offset,
                                             int *current_char);
+mc_search_cbret_t edit_search_cmd_block_callback (const void *user_data, gsize char_offset,
+                                                  const char **block, gsize * block_len);
 mc_search_cbret_t edit_search_update_callback (const void *user_data, gsize char_offset);
 
 void edit_complete_word_cmd (WEdit * edit);
@@ -267,6 +277,7 @@ void edit_set_filename (WEdit * edit, const vfs_path_t * name_vpath);
 void edit_load_syntax (WEdit * edit, GPtrArray * pnames, const char *type);
 void edit_free_syntax_rules (WEdit * edit);
 int edit_get_syntax_color (WEdit * edit, off_t byte_index);
+void edit_syntax_changed (WEdit * edit, off_t offset, off_t len);
 
 void book_mark_insert (WEdit * edit, long line, int c);
 gboolean book_mark_query_color (WEdit * edit, long line, int c);
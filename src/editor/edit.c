@@ -112,10 +112,22 @@ const char VERTICAL_MAGIC[] = { '\1', '\1', '\1', '\1', '\n' };
 
 #define TEMP_BUF_LEN 1024
 
+/* length of blocks read by edit_insert_stream() and edit_insert_file() */
+#define INSERT_BUF_LEN (64 * 1024)
+
 #define space_width 1
 
 /*** file scope type declarations ****************************************************************/
 
+/* record of a BLOCK_ACTION in the undo or redo stack */
+typedef struct
+{
+    gboolean move;              /* move the cursor by len bytes, backward if len is negative */
+    gboolean insert;            /* insert the saved text if TRUE, delete len bytes otherwise */
+    gboolean ahead;             /* after the cursor if TRUE, before the cursor otherwise */
+    off_t len;
+} edit_undo_block_t;
+
 /*** file scope variables ************************************************************************/
 
 /* detecting an error on save is easy: just check if every byte has been written. */
@@ -267,14 +279,19 @@ edit_get_filter (const vfs_path_t * filename_vpath)
 static off_t
 edit_insert_stream (WEdit * edit, FILE * f)
 {
-    int c;
+    char *buf;
+    size_t n;
     off_t i = 0;
 
-    while ((c = fgetc (f)) >= 0)
+    buf = g_malloc (INSERT_BUF_LEN);
+
+    while ((n = fread (buf, 1, INSERT_BUF_LEN, f)) != 0)
     {
-        edit_insert (edit, c);
-        i++;
+        edit_insert_block (edit, buf, n);
+        i += (off_t) n;
     }
+
+    g_free (buf);
     return i;
 }
 
@@ -611,14 +628,289 @@ get_prev_undo_action (WEdit * edit)
 static void
 edit_modification (WEdit * edit)
 {
-    edit->caches_valid = FALSE;
-
     /* raise lock when file modified */
     if (!edit->modified && !edit->delete_file)
         edit->locked = lock_file (edit->filename_vpath);
     edit->modified = 1;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+static void
+edit_undo_blocks_init (edit_undo_blocks_t * blocks)
+{
+    blocks->records = g_array_new (FALSE, FALSE, sizeof (edit_undo_block_t));
+    blocks->text = g_byte_array_new ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+edit_undo_blocks_free (edit_undo_blocks_t * blocks)
+{
+    if (blocks->records != NULL)
+        g_array_free (blocks->records, TRUE);
+    if (blocks->text != NULL)
+        g_byte_array_free (blocks->text, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+edit_undo_blocks_clear (edit_undo_blocks_t * blocks)
+{
+    g_array_set_size (blocks->records, 0);
+    g_byte_array_set_size (blocks->text, 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Drop the records of block actions of the stack entry that is moved out of the stack bottom.
+ *
+ * @param blocks records of the stack
+ * @param stack undo or redo stack
+ * @param mask mask of the stack indexes
+ * @param i index of the entry
+ */
+
+static void
+edit_undo_blocks_drop (edit_undo_blocks_t * blocks, const long *stack, unsigned long mask,
+                       unsigned long i)
+{
+    long n = 0;
+    guint j;
+    gsize text_len = 0;
+
+    if (stack[i] == BLOCK_ACTION)
+        n = 1;
+    else if (stack[i] < 0 && stack[(i - 1) & mask] == BLOCK_ACTION)
+        n = -stack[i] - 1;      /* repeat count of BLOCK_ACTION */
+
+    n = min (n, (long) blocks->records->len);
+    if (n <= 0)
+        return;
+
+    for (j = 0; j < (guint) n; j++)
+    {
+        const edit_undo_block_t *r = &g_array_index (blocks->records, edit_undo_block_t, j);
+
+        if (r->insert)
+            text_len += (gsize) r->len;
+    }
+
+    g_array_remove_range (blocks->records, 0, (guint) n);
+    g_byte_array_remove_range (blocks->text, 0, (guint) text_len);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Get the place for the text of a new block action at the end of the current stack records */
+
+static char *
+edit_undo_block_text (WEdit * edit, off_t len)
+{
+    GByteArray *text;
+    guint old_len;
+
+    text = edit->undo_stack_disable ? edit->redo_blocks.text : edit->undo_blocks.text;
+    old_len = text->len;
+    g_byte_array_set_size (text, old_len + (guint) len);
+
+    return (char *) text->data + old_len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Drop the oldest key presses while the undo stack holds too much text.
+ * The current key press is never dropped: undoing a part of it would lose data.
+ */
+
+static void
+edit_undo_text_limit (WEdit * edit)
+{
+    unsigned long last_key;
+
+    if (edit->undo_blocks.text->len <= UNDO_TEXT_MAX
+        || edit->undo_stack_bottom == edit->undo_stack_pointer)
+        return;
+
+    /* find the start of the current key press */
+    last_key = (edit->undo_stack_pointer - 1) & edit->undo_stack_size_mask;
+    while (last_key != edit->undo_stack_bottom && edit->undo_stack[last_key] < KEY_PRESS)
+        last_key = (last_key - 1) & edit->undo_stack_size_mask;
+
+    while (edit->undo_blocks.text->len > UNDO_TEXT_MAX && edit->undo_stack_bottom != last_key)
+        do
+        {
+            edit_undo_blocks_drop (&edit->undo_blocks, edit->undo_stack,
+                                   edit->undo_stack_size_mask, edit->undo_stack_bottom);
+            edit->undo_stack_bottom = (edit->undo_stack_bottom + 1) & edit->undo_stack_size_mask;
+        }
+        while (edit->undo_stack[edit->undo_stack_bottom] < KEY_PRESS
+               && edit->undo_stack_bottom != last_key);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Push a BLOCK_ACTION with its record onto the undo stack.
+ * Records of adjacent actions of one key press are joined.
+ */
+
+static void
+edit_push_undo_record (WEdit * edit, const edit_undo_block_t * r)
+{
+    edit_undo_blocks_t *blocks;
+
+    blocks = edit->undo_stack_disable ? &edit->redo_blocks : &edit->undo_blocks;
+
+    /* the texts of backspaced blocks are saved in reverse order, they can't be joined */
+    if (!edit->undo_stack_disable && (r->move || !r->insert || r->ahead)
+        && blocks->records->len != 0 && get_prev_undo_action (edit) == BLOCK_ACTION)
+    {
+        edit_undo_block_t *last;
+
+        last = &g_array_index (blocks->records, edit_undo_block_t, blocks->records->len - 1);
+        if (last->move == r->move && last->insert == r->insert && last->ahead == r->ahead)
+        {
+            last->len += r->len;
+            edit_undo_text_limit (edit);
+            return;
+        }
+    }
+
+    g_array_append_val (blocks->records, *r);
+
+    edit_push_undo_action (edit, BLOCK_ACTION);
+
+    if (!edit->undo_stack_disable)
+        edit_undo_text_limit (edit);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Push the reverse of a block action onto the undo stack. The text of inserting record
+ * must be already placed by edit_undo_block_text().
+ *
+ * @param edit editor object
+ * @param insert TRUE if the saved text is inserted by undo, FALSE if len bytes are deleted
+ * @param ahead TRUE if undo inserts or deletes after the cursor, FALSE if before the cursor
+ * @param len length of the block
+ */
+
+static void
+edit_push_undo_block (WEdit * edit, gboolean insert, gboolean ahead, off_t len)
+{
+    edit_undo_block_t r;
+
+    r.move = FALSE;
+    r.insert = insert;
+    r.ahead = ahead;
+    r.len = len;
+    edit_push_undo_record (edit, &r);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Push the reverse of a cursor movement by many bytes onto the undo stack.
+ *
+ * @param edit editor object
+ * @param increment offset by which undo moves the cursor
+ */
+
+static void
+edit_push_undo_cursor (WEdit * edit, off_t increment)
+{
+    edit_undo_block_t r;
+
+    r.move = TRUE;
+    r.insert = FALSE;
+    r.ahead = FALSE;
+    r.len = increment;
+    edit_push_undo_record (edit, &r);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Undo or redo the last block action of the records */
+
+static void
+edit_do_block_action (WEdit * edit, edit_undo_blocks_t * blocks)
+{
+    edit_undo_block_t r;
+
+    if (blocks->records->len == 0)
+        return;
+
+    r = g_array_index (blocks->records, edit_undo_block_t, blocks->records->len - 1);
+    g_array_set_size (blocks->records, blocks->records->len - 1);
+
+    if (r.move)
+        edit_cursor_move (edit, r.len);
+    else if (r.insert)
+    {
+        const char *text;
+
+        text = (const char *) blocks->text->data + blocks->text->len - r.len;
+        if (r.ahead)
+            edit_insert_ahead_block (edit, text, (size_t) r.len);
+        else
+            edit_insert_block (edit, text, (size_t) r.len);
+        g_byte_array_set_size (blocks->text, blocks->text->len - (guint) r.len);
+    }
+    else if (r.ahead)
+        edit_delete_block (edit, r.len);
+    else
+        edit_backspace_block (edit, r.len);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Update the editor after a block was deleted.
+ *
+ * @param edit editor object
+ * @param base offset of the deleted block
+ * @param text deleted block
+ * @param len length of the deleted block
+ * @param lines number of newlines in the deleted block
+ */
+
+static void
+edit_block_deleted (WEdit * edit, off_t base, const char *text, off_t len, long lines)
+{
+    off_t mark1 = edit->mark1;
+
+    /* update markers */
+    if (edit->mark1 > base)
+        edit->mark1 = max (base, edit->mark1 - len);
+    edit->end_mark_curs -= mark1 - edit->mark1;
+    if (edit->mark2 > base)
+        edit->mark2 = max (base, edit->mark2 - len);
+    edit_syntax_changed (edit, base, -len);
+
+    edit->buffer.size -= len;
+    edit->buffer.lines -= lines;
+    if (lines != 0)
+        edit->force |= REDRAW_AFTER_CURSOR;
+
+    /* update the position of the display window */
+    if (edit->start_display > base)
+    {
+        if (edit->start_display - base >= len)
+        {
+            edit->start_display -= len;
+            edit->start_line -= lines;
+        }
+        else
+        {
+            const char *p, *end;
+
+            end = text + (edit->start_display - base);
+            for (p = text; (p = memchr (p, '\n', (size_t) (end - p))) != NULL; p++)
+                edit->start_line--;
+            edit->start_display = base;
+        }
+    }
+
+    edit_modification (edit);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /* high level cursor movement commands */
 /* --------------------------------------------------------------------------------------------- */
@@ -674,52 +966,7 @@ is_blank (const edit_buffer_t * buf, off_t offset)
 static off_t
 edit_find_line (WEdit * edit, long line)
 {
-    long i, j = 0;
-    long m = 2000000000;        /* what is the magic number? */
-
-    if (!edit->caches_valid)
-    {
-        memset (edit->line_numbers, 0, sizeof (edit->line_numbers));
-        memset (edit->line_offsets, 0, sizeof (edit->line_offsets));
-        /* three offsets that we *know* are line 0 at 0 and these two: */
-        edit->line_numbers[1] = edit->buffer.curs_line;
-        edit->line_offsets[1] = edit_buffer_get_current_bol (&edit->buffer);
-        edit->line_numbers[2] = edit->buffer.lines;
-        edit->line_offsets[2] = edit_buffer_get_bol (&edit->buffer, edit->buffer.size);
-        edit->caches_valid = TRUE;
-    }
-    if (line >= edit->buffer.lines)
-        return edit->line_offsets[2];
-    if (line <= 0)
-        return 0;
-    /* find the closest known point */
-    for (i = 0; i < N_LINE_CACHES; i++)
-    {
-        long n;
-
-        n = labs (edit->line_numbers[i] - line);
-        if (n < m)
-        {
-            m = n;
-            j = i;
-        }
-    }
-    if (m == 0)
-        return edit->line_offsets[j];   /* know the offset exactly */
-    if (m == 1 && j >= 3)
-        i = j;                  /* one line different - caller might be looping, so stay in this cache */
-    else
-        i = 3 + (rand () % (N_LINE_CACHES - 3));
-    if (line > edit->line_numbers[j])
-        edit->line_offsets[i] =
-            edit_buffer_move_forward (&edit->buffer, edit->line_offsets[j],
-                                      line - edit->line_numbers[j], 0);
-    else
-        edit->line_offsets[i] =
-            edit_buffer_move_backward (&edit->buffer, edit->line_offsets[j],
-                                       edit->line_numbers[j] - line);
-    edit->line_numbers[i] = line;
-    return edit->line_offsets[i];
+    return edit_buffer_get_line_offset (&edit->buffer, line);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1162,6 +1409,9 @@ edit_do_undo (WEdit * edit)
         case DELCHAR_BR:
             edit_delete (edit, TRUE);
             break;
+        case BLOCK_ACTION:
+            edit_do_block_action (edit, &edit->undo_blocks);
+            break;
         case COLUMN_ON:
             edit->column_highlight = 1;
             break;
@@ -1247,6 +1497,9 @@ edit_do_redo (WEdit * edit)
         case DELCHAR:
             edit_delete (edit, TRUE);
             break;
+        case BLOCK_ACTION:
+            edit_do_block_action (edit, &edit->redo_blocks);
+            break;
         case COLUMN_ON:
             edit->column_highlight = 1;
             break;
@@ -1993,7 +2246,7 @@ edit_insert_file (WEdit * edit, const vfs_path_t * filename_vpath)
         if (file == -1)
             return -1;
 
-        buf = g_malloc0 (TEMP_BUF_LEN);
+        buf = g_malloc0 (INSERT_BUF_LEN);
         blocklen = mc_read (file, buf, sizeof (VERTICAL_MAGIC));
         if (blocklen > 0)
         {
@@ -2022,13 +2275,8 @@ edit_insert_file (WEdit * edit, const vfs_path_t * filename_vpath)
         }
         else
         {
-            off_t i;
-
-            while ((blocklen = mc_read (file, (char *) buf, TEMP_BUF_LEN)) > 0)
-            {
-                for (i = 0; i < blocklen; i++)
-                    edit_insert (edit, buf[i]);
-            }
+            while ((blocklen = mc_read (file, (char *) buf, INSERT_BUF_LEN)) > 0)
+                edit_insert_block (edit, buf, (size_t) blocklen);
             /* highlight inserted text then not persistent blocks */
             if (!option_persistent_selections && edit->modified)
             {
@@ -2125,6 +2373,9 @@ edit_init (WEdit * edit, int y, int x, int lines, int cols, const vfs_path_t * f
     edit->redo_stack_size_mask = START_STACK_SIZE - 1;
     edit->redo_stack = g_malloc0 ((edit->redo_stack_size + 10) * sizeof (long));
 
+    edit_undo_blocks_init (&edit->undo_blocks);
+    edit_undo_blocks_init (&edit->redo_blocks);
+
 #ifdef HAVE_CHARSET
     edit->utf8 = FALSE;
     edit->converter = str_cnv_from_term;
@@ -2191,6 +2442,8 @@ edit_clean (WEdit * edit)
 
     g_free (edit->undo_stack);
     g_free (edit->redo_stack);
+    edit_undo_blocks_free (&edit->undo_blocks);
+    edit_undo_blocks_free (&edit->redo_blocks);
     vfs_path_free (edit->filename_vpath);
     vfs_path_free (edit->dir_vpath);
     mc_search_free (edit->search);
@@ -2313,6 +2566,10 @@ edit_set_codeset (WEdit * edit)
  * over KEY_PRESS. We then assign this number less KEY_PRESS to start_display. So undo
  * tracks scrolling and key actions exactly. (KEY_PRESS is about (2^31) * (2/3) = 1400'000'000)
  *
+ * Insertions and deletions of whole blocks, and cursor moves by more than one byte,
+ * push BLOCK_ACTION. Its record, with the deleted text if any, is kept in edit->undo_blocks
+ * (edit->redo_blocks for the redo stack) in the same order as BLOCK_ACTIONs in the stack.
+ *
  *
  *
  * @param edit editor object
@@ -2351,7 +2608,10 @@ edit_push_undo_action (WEdit * edit, long c)
     }
 
     if (edit->redo_stack_reset)
+    {
         edit->redo_stack_bottom = edit->redo_stack_pointer = 0;
+        edit_undo_blocks_clear (&edit->redo_blocks);
+    }
 
     if (edit->undo_stack_bottom != sp
         && spm1 != edit->undo_stack_bottom
@@ -2393,6 +2653,8 @@ edit_push_undo_action (WEdit * edit, long c)
         (((unsigned long) c + 1) & edit->undo_stack_size_mask) == edit->undo_stack_bottom)
         do
         {
+            edit_undo_blocks_drop (&edit->undo_blocks, edit->undo_stack,
+                                   edit->undo_stack_size_mask, edit->undo_stack_bottom);
             edit->undo_stack_bottom = (edit->undo_stack_bottom + 1) & edit->undo_stack_size_mask;
         }
         while (edit->undo_stack[edit->undo_stack_bottom] < KEY_PRESS
@@ -2403,6 +2665,7 @@ edit_push_undo_action (WEdit * edit, long c)
         && edit->undo_stack[edit->undo_stack_bottom] < KEY_PRESS)
     {
         edit->undo_stack_bottom = edit->undo_stack_pointer = 0;
+        edit_undo_blocks_clear (&edit->undo_blocks);
     }
 }
 
@@ -2472,6 +2735,8 @@ edit_push_redo_action (WEdit * edit, long c)
         (((unsigned long) c + 1) & edit->redo_stack_size_mask) == edit->redo_stack_bottom)
         do
         {
+            edit_undo_blocks_drop (&edit->redo_blocks, edit->redo_stack,
+                                   edit->redo_stack_size_mask, edit->redo_stack_bottom);
             edit->redo_stack_bottom = (edit->redo_stack_bottom + 1) & edit->redo_stack_size_mask;
         }
         while (edit->redo_stack[edit->redo_stack_bottom] < KEY_PRESS
@@ -2485,7 +2750,10 @@ edit_push_redo_action (WEdit * edit, long c)
 
     if (edit->redo_stack_pointer != edit->redo_stack_bottom
         && edit->redo_stack[edit->redo_stack_bottom] < KEY_PRESS)
+    {
         edit->redo_stack_bottom = edit->redo_stack_pointer = 0;
+        edit_undo_blocks_clear (&edit->redo_blocks);
+    }
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -2526,7 +2794,7 @@ edit_insert (WEdit * edit, int c)
     /* update markers */
     edit->mark1 += (edit->mark1 > edit->buffer.curs1) ? 1 : 0;
     edit->mark2 += (edit->mark2 > edit->buffer.curs1) ? 1 : 0;
-    edit->last_get_rule += (edit->last_get_rule > edit->buffer.curs1) ? 1 : 0;
+    edit_syntax_changed (edit, edit->buffer.curs1, 1);
 
     edit_buffer_insert (&edit->buffer, c);
 
@@ -2534,6 +2802,55 @@ edit_insert (WEdit * edit, int c)
     edit->buffer.size++;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** same as edit_insert for each byte of block, but the buffer is updated at once */
+
+void
+edit_insert_block (WEdit * edit, const char *block, size_t len)
+{
+    off_t curs1;
+    long lines, i;
+
+    if (len == 0)
+        return;
+
+    curs1 = edit->buffer.curs1;
+
+    /* Mark file as modified, unless the file hasn't been fully loaded */
+    if (edit->loading_done)
+        edit_modification (edit);
+
+    lines = edit_buffer_insert_block (&edit->buffer, block, len);
+
+    /* update the position of the display window */
+    if (curs1 < edit->start_display)
+    {
+        edit->start_display += (off_t) len;
+        edit->start_line += lines;
+    }
+
+    if (lines != 0)
+    {
+        for (i = 0; i < lines; i++)
+            book_mark_inc (edit, edit->buffer.curs_line + i);
+        edit->buffer.curs_line += lines;
+        edit->buffer.lines += lines;
+        edit->force |= REDRAW_LINE_ABOVE | REDRAW_AFTER_CURSOR;
+    }
+
+    /* update markers */
+    edit->mark1 += (edit->mark1 > curs1) ? (off_t) len : 0;
+    edit->mark2 += (edit->mark2 > curs1) ? (off_t) len : 0;
+    edit_syntax_changed (edit, curs1, (off_t) len);
+
+    /* update file length */
+    edit->buffer.size += (off_t) len;
+
+    /* save the reverse command onto the undo stack */
+    if (edit->loading_done)
+        edit_push_undo_block (edit, FALSE, FALSE, (off_t) len);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /** same as edit_insert and move left */
 
@@ -2561,13 +2878,54 @@ edit_insert_ahead (WEdit * edit, int c)
 
     edit->mark1 += (edit->mark1 >= edit->buffer.curs1) ? 1 : 0;
     edit->mark2 += (edit->mark2 >= edit->buffer.curs1) ? 1 : 0;
-    edit->last_get_rule += (edit->last_get_rule >= edit->buffer.curs1) ? 1 : 0;
+    edit_syntax_changed (edit, edit->buffer.curs1, 1);
 
     edit_buffer_insert_ahead (&edit->buffer, c);
 
     edit->buffer.size++;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** same as edit_insert_block and move left */
+
+void
+edit_insert_ahead_block (WEdit * edit, const char *block, size_t len)
+{
+    off_t curs1;
+    long lines, i;
+
+    if (len == 0)
+        return;
+
+    curs1 = edit->buffer.curs1;
+
+    edit_modification (edit);
+
+    lines = edit_buffer_insert_ahead_block (&edit->buffer, block, len);
+
+    if (curs1 < edit->start_display)
+    {
+        edit->start_display += (off_t) len;
+        edit->start_line += lines;
+    }
+
+    if (lines != 0)
+    {
+        for (i = 0; i < lines; i++)
+            book_mark_inc (edit, edit->buffer.curs_line);
+        edit->buffer.lines += lines;
+        edit->force |= REDRAW_AFTER_CURSOR;
+    }
+
+    edit->mark1 += (edit->mark1 >= curs1) ? (off_t) len : 0;
+    edit->mark2 += (edit->mark2 >= curs1) ? (off_t) len : 0;
+    edit_syntax_changed (edit, curs1, (off_t) len);
+
+    edit->buffer.size += (off_t) len;
+
+    edit_push_undo_block (edit, FALSE, TRUE, (off_t) len);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -2617,8 +2975,7 @@ edit_delete (WEdit * edit, gboolean byte_delete)
         }
         if (edit->mark2 > edit->buffer.curs1)
             edit->mark2--;
-        if (edit->last_get_rule > edit->buffer.curs1)
-            edit->last_get_rule--;
+        edit_syntax_changed (edit, edit->buffer.curs1, -1);
 
         p = edit_buffer_delete (&edit->buffer);
 
@@ -2643,6 +3000,32 @@ edit_delete (WEdit * edit, gboolean byte_delete)
     return p;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** same as edit_delete for each byte of block, but the buffer is updated at once */
+
+void
+edit_delete_block (WEdit * edit, off_t len)
+{
+    char *text;
+    long lines, i;
+
+    len = min (len, edit->buffer.curs2);
+    if (len <= 0)
+        return;
+
+    if (edit->mark2 != edit->mark1)
+        edit_push_markers (edit);
+
+    text = edit_undo_block_text (edit, len);
+    lines = edit_buffer_delete_block (&edit->buffer, text, (size_t) len);
+
+    for (i = 0; i < lines; i++)
+        book_mark_dec (edit, edit->buffer.curs_line);
+
+    edit_block_deleted (edit, edit->buffer.curs1, text, len, lines);
+    edit_push_undo_block (edit, TRUE, TRUE, len);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 int
@@ -2678,8 +3061,7 @@ edit_backspace (WEdit * edit, gboolean byte_delete)
         }
         if (edit->mark2 >= edit->buffer.curs1)
             edit->mark2--;
-        if (edit->last_get_rule >= edit->buffer.curs1)
-            edit->last_get_rule--;
+        edit_syntax_changed (edit, edit->buffer.curs1 - 1, -1);
 
         p = edit_buffer_backspace (&edit->buffer);
 
@@ -2706,46 +3088,60 @@ edit_backspace (WEdit * edit, gboolean byte_delete)
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/** moves the cursor right or left: increment positive or negative respectively */
+/** same as edit_backspace for each byte of block, but the buffer is updated at once */
 
 void
-edit_cursor_move (WEdit * edit, off_t increment)
+edit_backspace_block (WEdit * edit, off_t len)
 {
-    if (increment < 0)
-    {
-        for (; increment < 0 && edit->buffer.curs1 != 0; increment++)
-        {
-            int c;
+    char *text;
+    long lines, i;
 
-            edit_push_undo_action (edit, CURS_RIGHT);
+    len = min (len, edit->buffer.curs1);
+    if (len <= 0)
+        return;
 
-            c = edit_buffer_get_previous_byte (&edit->buffer);
-            edit_buffer_insert_ahead (&edit->buffer, c);
-            c = edit_buffer_backspace (&edit->buffer);
-            if (c == '\n')
-            {
-                edit->buffer.curs_line--;
-                edit->force |= REDRAW_LINE_BELOW;
-            }
-        }
-    }
-    else
+    if (edit->mark2 != edit->mark1)
+        edit_push_markers (edit);
+
+    text = edit_undo_block_text (edit, len);
+    lines = edit_buffer_backspace_block (&edit->buffer, text, (size_t) len);
+
+    for (i = 0; i < lines; i++)
     {
-        for (; increment > 0 && edit->buffer.curs2 != 0; increment--)
-        {
-            int c;
+        book_mark_dec (edit, edit->buffer.curs_line);
+        edit->buffer.curs_line--;
+    }
 
-            edit_push_undo_action (edit, CURS_LEFT);
+    edit_block_deleted (edit, edit->buffer.curs1, text, len, lines);
+    edit_push_undo_block (edit, TRUE, FALSE, len);
+}
 
-            c = edit_buffer_get_current_byte (&edit->buffer);
-            edit_buffer_insert (&edit->buffer, c);
-            c = edit_buffer_delete (&edit->buffer);
-            if (c == '\n')
-            {
-                edit->buffer.curs_line++;
-                edit->force |= REDRAW_LINE_ABOVE;
-            }
-        }
+/* --------------------------------------------------------------------------------------------- */
+/** moves the cursor right or left: increment positive or negative respectively */
+
+void
+edit_cursor_move (WEdit * edit, off_t increment)
+{
+    long lines;
+
+    if (increment < 0)
+        increment = max (increment, -edit->buffer.curs1);
+    else
+        increment = min (increment, edit->buffer.curs2);
+
+    if (increment == 1)
+        edit_push_undo_action (edit, CURS_LEFT);
+    else if (increment == -1)
+        edit_push_undo_action (edit, CURS_RIGHT);
+    else if (increment != 0)
+        /* block moves and copies move the cursor by the whole block */
+        edit_push_undo_cursor (edit, -increment);
+
+    lines = edit_buffer_move_cursor (&edit->buffer, increment);
+    if (lines != 0)
+    {
+        edit->buffer.curs_line += lines;
+        edit->force |= lines < 0 ? REDRAW_LINE_BELOW : REDRAW_LINE_ABOVE;
     }
 }
 
@@ -70,6 +70,11 @@
  *
  *
  * This is called a "gap buffer".
+ *
+ * The numbers of newlines in the buffers of b1 and b2 are kept in two Fenwick trees
+ * (b1_lines and b2_lines), so the offset of a line and the line of an offset are found
+ * in O(log n) time and only one buffer is scanned.
+ *
  * See also:
  * http://en.wikipedia.org/wiki/Gap_buffer
  * http://stackoverflow.com/questions/4199694/data-structure-for-text-editor
@@ -95,12 +100,190 @@
 /* Buffer mask (used to find cursor position relative to the buffer) */
 #define M_EDIT_BUF_SIZE (EDIT_BUF_SIZE - 1)
 
+/* Moves by more lines use the line index, shorter ones scan the data around the offset */
+#define EDIT_BUF_SCAN_LINES 64
+
 /*** file scope type declarations ****************************************************************/
 
 /*** file scope variables ************************************************************************/
 
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/** Count newlines in the block of data */
+
+static long
+edit_buffer_count_newlines (const char *block, size_t len)
+{
+    long lines = 0;
+    const char *p, *end;
+
+    end = block + len;
+    for (p = block; (p = memchr (p, '\n', (size_t) (end - p))) != NULL; p++)
+        lines++;
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add delta to the number of newlines in the buffer of the line index.
+ *
+ * The line index is a Fenwick tree: its element k (counting from 1) keeps the number of newlines
+ * in the buffers from k - (k & -k) to k - 1.
+ */
+
+static void
+edit_buffer_index_add (GArray * index, guint page, long delta)
+{
+    guint k;
+
+    for (k = page + 1; k <= index->len; k += k & -k)
+        g_array_index (index, long, k - 1) += delta;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Get number of newlines in the first pages of the line index */
+
+static long
+edit_buffer_index_sum (const GArray * index, guint pages)
+{
+    long lines = 0;
+    guint k;
+
+    for (k = MIN (pages, index->len); k > 0; k -= k & -k)
+        lines += g_array_index (index, long, k - 1);
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Add the buffer with specified number of newlines to the end of the line index */
+
+static void
+edit_buffer_index_append (GArray * index, long lines)
+{
+    guint k;
+
+    k = index->len + 1;
+    lines += edit_buffer_index_sum (index, k - 1) - edit_buffer_index_sum (index, k - (k & -k));
+    g_array_append_val (index, lines);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the buffer containing the newline with specified number.
+ *
+ * @param index line index
+ * @param lines number of newline counting from 1, must not be greater than the total number
+ * @param rest number of the newline inside the found buffer counting from 1
+ *
+ * @return index of buffer
+ */
+
+static guint
+edit_buffer_index_find (const GArray * index, long lines, long *rest)
+{
+    guint page = 0;
+    guint step;
+
+    for (step = 1; step <= index->len / 2; step <<= 1)
+        ;
+
+    for (; step != 0; step >>= 1)
+        if (page + step <= index->len && g_array_index (index, long, page + step - 1) < lines)
+        {
+            page += step;
+            lines -= g_array_index (index, long, page - 1);
+        }
+
+    *rest = lines;
+    return page;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Rebuild the line index of the buffers containing specified number of bytes */
+
+static void
+edit_buffer_index_build (GArray * index, const GPtrArray * pages, off_t size, gboolean from_end)
+{
+    guint k;
+
+    g_array_set_size (index, pages->len);
+
+    for (k = 0; k < pages->len; k++)
+    {
+        const char *b;
+        off_t n;
+
+        b = (const char *) g_ptr_array_index (pages, k);
+        n = min (size - ((off_t) k << S_EDIT_BUF_SIZE), EDIT_BUF_SIZE);
+        if (from_end)
+            b += EDIT_BUF_SIZE - n;
+        g_array_index (index, long, k) = edit_buffer_count_newlines (b, (size_t) n);
+    }
+
+    for (k = 1; k <= index->len; k++)
+    {
+        guint next;
+
+        next = k + (k & -k);
+        if (next <= index->len)
+            g_array_index (index, long, next - 1) += g_array_index (index, long, k - 1);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Find the newline with specified number counting from 1 in the block of data */
+
+static const char *
+edit_buffer_find_newline (const char *block, size_t len, long lines)
+{
+    const char *p, *end;
+
+    end = block + len;
+    for (p = block; (p = memchr (p, '\n', (size_t) (end - p))) != NULL && --lines != 0; p++)
+        ;
+
+    return p;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Count newlines before specified offset using the line index */
+
+static long
+edit_buffer_lines_before (const edit_buffer_t * buf, off_t offset)
+{
+    const char *b;
+    off_t n;
+    long lines;
+
+    if (offset <= buf->curs1)
+    {
+        lines = edit_buffer_index_sum (buf->b1_lines, (guint) (offset >> S_EDIT_BUF_SIZE));
+        n = offset & M_EDIT_BUF_SIZE;
+        if (n != 0)
+        {
+            b = (const char *) g_ptr_array_index (buf->b1, offset >> S_EDIT_BUF_SIZE);
+            lines += edit_buffer_count_newlines (b, (size_t) n);
+        }
+        return lines;
+    }
+
+    /* count newlines after offset from the end of file */
+    offset = buf->curs1 + buf->curs2 - offset;
+    lines = edit_buffer_index_sum (buf->b2_lines, (guint) (offset >> S_EDIT_BUF_SIZE));
+    n = offset & M_EDIT_BUF_SIZE;
+    if (n != 0)
+    {
+        b = (const char *) g_ptr_array_index (buf->b2, offset >> S_EDIT_BUF_SIZE);
+        lines += edit_buffer_count_newlines (b + EDIT_BUF_SIZE - n, (size_t) n);
+    }
+
+    return edit_buffer_index_sum (buf->b1_lines, buf->b1_lines->len)
+        + edit_buffer_index_sum (buf->b2_lines, buf->b2_lines->len) - lines;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
   * Get pointer to byte at specified index
@@ -145,6 +328,8 @@ edit_buffer_init (edit_buffer_t * buf, off_t size)
 {
     buf->b1 = g_ptr_array_sized_new (32);
     buf->b2 = g_ptr_array_sized_new (32);
+    buf->b1_lines = g_array_sized_new (FALSE, FALSE, sizeof (long), 32);
+    buf->b2_lines = g_array_sized_new (FALSE, FALSE, sizeof (long), 32);
 
     buf->curs1 = 0;
     buf->curs2 = 0;
@@ -174,6 +359,12 @@ edit_buffer_clean (edit_buffer_t * buf)
         g_ptr_array_foreach (buf->b2, (GFunc) g_free, NULL);
         g_ptr_array_free (buf->b2, TRUE);
     }
+
+    if (buf->b1_lines != NULL)
+        g_array_free (buf->b1_lines, TRUE);
+
+    if (buf->b2_lines != NULL)
+        g_array_free (buf->b2_lines, TRUE);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -196,6 +387,42 @@ edit_buffer_get_byte (const edit_buffer_t * buf, off_t byte_index)
     return (p != NULL) ? *(unsigned char *) p : '\n';
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+  * Get pointer to the contiguous bytes starting at specified index
+  *
+  * @param buf pointer to editor buffer
+  * @param byte_index byte index
+  * @param len length of data available by returned pointer
+  *
+  * @return NULL if byte_index is negative or larger than file size; pointer to data otherwise.
+  */
+
+const char *
+edit_buffer_get_block (const edit_buffer_t * buf, off_t byte_index, off_t * len)
+{
+    const char *p;
+
+    *len = 0;
+
+    p = edit_buffer_get_byte_ptr (buf, byte_index);
+    if (p == NULL)
+        return NULL;
+
+    if (byte_index >= buf->curs1)
+    {
+        /* b2 pages are filled from the end, so the bytes of a page are still in forward order */
+        *len = ((buf->curs1 + buf->curs2 - byte_index - 1) & M_EDIT_BUF_SIZE) + 1;
+    }
+    else
+    {
+        *len = EDIT_BUF_SIZE - (byte_index & M_EDIT_BUF_SIZE);
+        *len = MIN (*len, buf->curs1 - byte_index);
+    }
+
+    return p;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 #ifdef HAVE_CHARSET
@@ -328,16 +555,13 @@ edit_buffer_get_prev_utf (const edit_buffer_t * buf, off_t byte_index, int *char
 long
 edit_buffer_count_lines (const edit_buffer_t * buf, off_t first, off_t last)
 {
-    long lines = 0;
-
     first = max (first, 0);
     last = min (last, buf->size);
 
-    while (first < last)
-        if (edit_buffer_get_byte (buf, first++) == '\n')
-            lines++;
+    if (first >= last)
+        return 0;
 
-    return lines;
+    return edit_buffer_lines_before (buf, last) - edit_buffer_lines_before (buf, first);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -384,6 +608,54 @@ edit_buffer_get_eol (const edit_buffer_t * buf, off_t current)
     return current;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get offset of the line using the line index
+ *
+ * @param buf editor buffer
+ * @param line line number
+ *
+ * @return index of first char of line, of the last line if line is greater than number of lines
+ */
+
+off_t
+edit_buffer_get_line_offset (const edit_buffer_t * buf, long line)
+{
+    long b1_lines, b2_lines, rest, page_lines;
+    guint page;
+    off_t n;
+    const char *b, *p;
+
+    if (line <= 0)
+        return 0;
+
+    b1_lines = edit_buffer_index_sum (buf->b1_lines, buf->b1_lines->len);
+    if (line <= b1_lines)
+    {
+        page = edit_buffer_index_find (buf->b1_lines, line, &rest);
+        b = (const char *) g_ptr_array_index (buf->b1, page);
+        n = min (buf->curs1 - ((off_t) page << S_EDIT_BUF_SIZE), EDIT_BUF_SIZE);
+        p = edit_buffer_find_newline (b, (size_t) n, rest);
+        return ((off_t) page << S_EDIT_BUF_SIZE) + (p - b) + 1;
+    }
+
+    b2_lines = edit_buffer_index_sum (buf->b2_lines, buf->b2_lines->len);
+    line -= b1_lines;
+    if (line > b2_lines)
+        return edit_buffer_get_line_offset (buf, b1_lines + b2_lines);
+
+    /* b2 is indexed from the end of file */
+    page = edit_buffer_index_find (buf->b2_lines, b2_lines - line + 1, &rest);
+    page_lines = edit_buffer_index_sum (buf->b2_lines, page + 1)
+        - edit_buffer_index_sum (buf->b2_lines, page);
+    n = min (buf->curs2 - ((off_t) page << S_EDIT_BUF_SIZE), EDIT_BUF_SIZE);
+    b = (const char *) g_ptr_array_index (buf->b2, page) + EDIT_BUF_SIZE - n;
+    p = edit_buffer_find_newline (b, (size_t) n, page_lines - rest + 1);
+
+    /* bytes of a b2 page are in forward order */
+    return buf->curs1 + buf->curs2 - ((off_t) page << S_EDIT_BUF_SIZE) - (n - (p - b)) + 1;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Get word from specified offset.
@@ -449,16 +721,73 @@ edit_buffer_insert (edit_buffer_t * buf, int c)
 
     /* add a new buffer if we've reached the end of the last one */
     if (i == 0)
+    {
         g_ptr_array_add (buf->b1, g_malloc0 (EDIT_BUF_SIZE));
+        edit_buffer_index_append (buf->b1_lines, 0);
+    }
 
     /* perform the insertion */
     b = g_ptr_array_index (buf->b1, buf->curs1 >> S_EDIT_BUF_SIZE);
     *((unsigned char *) b + i) = (unsigned char) c;
 
+    if (c == '\n')
+        edit_buffer_index_add (buf->b1_lines, (guint) (buf->curs1 >> S_EDIT_BUF_SIZE), 1);
+
     /* update cursor position */
     buf->curs1++;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Insert a block of bytes at the cursor position and move right.
+ *
+ * @param buf pointer to editor buffer
+ * @param block bytes to insert
+ * @param len length of block
+ *
+ * @return number of newlines in the block
+ */
+
+long
+edit_buffer_insert_block (edit_buffer_t * buf, const char *block, size_t len)
+{
+    long lines = 0;
+
+    while (len != 0)
+    {
+        off_t i;
+        size_t n;
+        long page_lines;
+
+        i = buf->curs1 & M_EDIT_BUF_SIZE;
+
+        /* add a new buffer if we've reached the end of the last one */
+        if (i == 0)
+        {
+            g_ptr_array_add (buf->b1, g_malloc0 (EDIT_BUF_SIZE));
+            edit_buffer_index_append (buf->b1_lines, 0);
+        }
+
+        /* fill the rest of the buffer */
+        n = (size_t) min ((off_t) len, EDIT_BUF_SIZE - i);
+        memcpy ((char *) g_ptr_array_index (buf->b1, buf->curs1 >> S_EDIT_BUF_SIZE) + i, block, n);
+
+        page_lines = edit_buffer_count_newlines (block, n);
+        if (page_lines != 0)
+        {
+            edit_buffer_index_add (buf->b1_lines, (guint) (buf->curs1 >> S_EDIT_BUF_SIZE),
+                                   page_lines);
+            lines += page_lines;
+        }
+
+        block += n;
+        len -= n;
+        buf->curs1 += (off_t) n;
+    }
+
+    return lines;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Basic low level single character buffer alterations and movements at the cursor: insert character
@@ -478,16 +807,73 @@ edit_buffer_insert_ahead (edit_buffer_t * buf, int c)
 
     /* add a new buffer if we've reached the end of the last one */
     if (i == 0)
+    {
         g_ptr_array_add (buf->b2, g_malloc0 (EDIT_BUF_SIZE));
+        edit_buffer_index_append (buf->b2_lines, 0);
+    }
 
     /* perform the insertion */
     b = g_ptr_array_index (buf->b2, buf->curs2 >> S_EDIT_BUF_SIZE);
     *((unsigned char *) b + EDIT_BUF_SIZE - 1 - i) = (unsigned char) c;
 
+    if (c == '\n')
+        edit_buffer_index_add (buf->b2_lines, (guint) (buf->curs2 >> S_EDIT_BUF_SIZE), 1);
+
     /* update cursor position */
     buf->curs2++;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Insert a block of bytes at the cursor position, the cursor stays before the block.
+ *
+ * @param buf pointer to editor buffer
+ * @param block bytes to insert
+ * @param len length of block
+ *
+ * @return number of newlines in the block
+ */
+
+long
+edit_buffer_insert_ahead_block (edit_buffer_t * buf, const char *block, size_t len)
+{
+    long lines = 0;
+
+    /* b2 is filled from the end: copy the tail of block first */
+    while (len != 0)
+    {
+        off_t i;
+        size_t n;
+        long page_lines;
+
+        i = buf->curs2 & M_EDIT_BUF_SIZE;
+
+        /* add a new buffer if we've reached the end of the last one */
+        if (i == 0)
+        {
+            g_ptr_array_add (buf->b2, g_malloc0 (EDIT_BUF_SIZE));
+            edit_buffer_index_append (buf->b2_lines, 0);
+        }
+
+        n = (size_t) min ((off_t) len, EDIT_BUF_SIZE - i);
+        memcpy ((char *) g_ptr_array_index (buf->b2, buf->curs2 >> S_EDIT_BUF_SIZE) +
+                EDIT_BUF_SIZE - i - (off_t) n, block + len - n, n);
+
+        page_lines = edit_buffer_count_newlines (block + len - n, n);
+        if (page_lines != 0)
+        {
+            edit_buffer_index_add (buf->b2_lines, (guint) (buf->curs2 >> S_EDIT_BUF_SIZE),
+                                   page_lines);
+            lines += page_lines;
+        }
+
+        len -= n;
+        buf->curs2 += (off_t) n;
+    }
+
+    return lines;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Basic low level single character buffer alterations and movements at the cursor: delete character
@@ -511,12 +897,16 @@ edit_buffer_delete (edit_buffer_t * buf)
     i = prev & M_EDIT_BUF_SIZE;
     c = *((unsigned char *) b + EDIT_BUF_SIZE - 1 - i);
 
+    if (c == '\n')
+        edit_buffer_index_add (buf->b2_lines, (guint) (prev >> S_EDIT_BUF_SIZE), -1);
+
     if (i == 0)
     {
         i = buf->b2->len - 1;
         b = g_ptr_array_index (buf->b2, i);
         g_ptr_array_remove_index (buf->b2, i);
         g_free (b);
+        g_array_set_size (buf->b2_lines, (guint) i);
     }
 
     buf->curs2 = prev;
@@ -547,12 +937,16 @@ edit_buffer_backspace (edit_buffer_t * buf)
     i = prev & M_EDIT_BUF_SIZE;
     c = *((unsigned char *) b + i);
 
+    if (c == '\n')
+        edit_buffer_index_add (buf->b1_lines, (guint) (prev >> S_EDIT_BUF_SIZE), -1);
+
     if (i == 0)
     {
         i = buf->b1->len - 1;
         b = g_ptr_array_index (buf->b1, i);
         g_ptr_array_remove_index (buf->b1, i);
         g_free (b);
+        g_array_set_size (buf->b1_lines, (guint) i);
     }
 
     buf->curs1 = prev;
@@ -560,6 +954,181 @@ edit_buffer_backspace (edit_buffer_t * buf)
     return c;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Delete a block of bytes at the cursor position.
+ *
+ * @param buf pointer to editor buffer
+ * @param block buffer for deleted bytes
+ * @param len number of bytes to delete, must not be greater than buf->curs2
+ *
+ * @return number of newlines in the deleted block
+ */
+
+long
+edit_buffer_delete_block (edit_buffer_t * buf, char *block, size_t len)
+{
+    size_t done;
+    long lines = 0;
+
+    for (done = 0; done < len;)
+    {
+        off_t prev, i;
+        size_t n;
+        char *b;
+        long page_lines;
+
+        prev = buf->curs2 - 1;
+        i = prev & M_EDIT_BUF_SIZE;
+        b = g_ptr_array_index (buf->b2, prev >> S_EDIT_BUF_SIZE);
+
+        /* bytes of a b2 page are in forward order from the page offset of prev */
+        n = (size_t) min ((off_t) (len - done), i + 1);
+        memcpy (block + done, b + EDIT_BUF_SIZE - 1 - i, n);
+
+        page_lines = edit_buffer_count_newlines (block + done, n);
+        if (page_lines != 0)
+        {
+            edit_buffer_index_add (buf->b2_lines, (guint) (prev >> S_EDIT_BUF_SIZE), -page_lines);
+            lines += page_lines;
+        }
+
+        done += n;
+        buf->curs2 -= (off_t) n;
+
+        /* free the emptied buffer */
+        if ((buf->curs2 & M_EDIT_BUF_SIZE) == 0)
+        {
+            i = buf->b2->len - 1;
+            g_free (g_ptr_array_index (buf->b2, i));
+            g_ptr_array_remove_index (buf->b2, i);
+            g_array_set_size (buf->b2_lines, (guint) i);
+        }
+    }
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Delete a block of bytes before the cursor position and move left.
+ *
+ * @param buf pointer to editor buffer
+ * @param block buffer for deleted bytes
+ * @param len number of bytes to delete, must not be greater than buf->curs1
+ *
+ * @return number of newlines in the deleted block
+ */
+
+long
+edit_buffer_backspace_block (edit_buffer_t * buf, char *block, size_t len)
+{
+    size_t left;
+    long lines = 0;
+
+    for (left = len; left != 0;)
+    {
+        off_t prev, i;
+        size_t n;
+        long page_lines;
+
+        prev = buf->curs1 - 1;
+        i = prev & M_EDIT_BUF_SIZE;
+
+        n = (size_t) min ((off_t) left, i + 1);
+        memcpy (block + left - n,
+                (char *) g_ptr_array_index (buf->b1, prev >> S_EDIT_BUF_SIZE) + i + 1 - n, n);
+
+        page_lines = edit_buffer_count_newlines (block + left - n, n);
+        if (page_lines != 0)
+        {
+            edit_buffer_index_add (buf->b1_lines, (guint) (prev >> S_EDIT_BUF_SIZE), -page_lines);
+            lines += page_lines;
+        }
+
+        left -= n;
+        buf->curs1 -= (off_t) n;
+
+        /* free the emptied buffer */
+        if ((buf->curs1 & M_EDIT_BUF_SIZE) == 0)
+        {
+            i = buf->b1->len - 1;
+            g_free (g_ptr_array_index (buf->b1, i));
+            g_ptr_array_remove_index (buf->b1, i);
+            g_array_set_size (buf->b1_lines, (guint) i);
+        }
+    }
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move the cursor position moving the bytes between the buffers by blocks.
+ *
+ * @param buf pointer to editor buffer
+ * @param increment offset to move the cursor to, must be within the buffer
+ *
+ * @return difference of the line numbers of the new and old cursor positions
+ */
+
+long
+edit_buffer_move_cursor (edit_buffer_t * buf, off_t increment)
+{
+    char block[BUF_8K];
+    long lines = 0;
+
+    while (increment > 0)
+    {
+        size_t n;
+
+        n = (size_t) min (increment, (off_t) sizeof (block));
+        lines += edit_buffer_delete_block (buf, block, n);
+        edit_buffer_insert_block (buf, block, n);
+        increment -= (off_t) n;
+    }
+
+    while (increment < 0)
+    {
+        size_t n;
+
+        n = (size_t) min (-increment, (off_t) sizeof (block));
+        lines -= edit_buffer_backspace_block (buf, block, n);
+        edit_buffer_insert_ahead_block (buf, block, n);
+        increment += (off_t) n;
+    }
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy bytes of the buffer.
+ *
+ * @param buf pointer to editor buffer
+ * @param start offset of the first byte
+ * @param finish offset of the byte after the last one
+ * @param dest buffer for (finish - start) bytes
+ */
+
+void
+edit_buffer_copy_block (const edit_buffer_t * buf, off_t start, off_t finish, char *dest)
+{
+    while (start < finish)
+    {
+        const char *p;
+        off_t len;
+
+        p = edit_buffer_get_block (buf, start, &len);
+        if (p == NULL)
+            break;
+
+        len = min (len, finish - start);
+        memcpy (dest, p, (size_t) len);
+        dest += len;
+        start += len;
+    }
+}
 
 /* --------------------------------------------------------------------------------------------- */
 /**
@@ -583,14 +1152,29 @@ edit_buffer_move_forward (const edit_buffer_t * buf, off_t current, long lines,
 
     lines = max (lines, 0);
 
-    while (lines-- != 0)
+    if (lines <= EDIT_BUF_SCAN_LINES)
     {
-        long next;
+        while (lines-- != 0)
+        {
+            off_t next;
 
-        next = edit_buffer_get_eol (buf, current) + 1;
-        if (next > buf->size)
-            break;
-        current = next;
+            next = edit_buffer_get_eol (buf, current) + 1;
+            if (next > buf->size)
+                break;
+            current = next;
+        }
+    }
+    else
+    {
+        long line, last;
+
+        current = max (current, 0);
+        line = edit_buffer_lines_before (buf, min (current, buf->curs1 + buf->curs2));
+        last = edit_buffer_lines_before (buf, buf->curs1 + buf->curs2);
+
+        /* stay at the current offset if there is no next line */
+        if (line < last)
+            current = edit_buffer_get_line_offset (buf, min (line + lines, last));
     }
 
     return current;
@@ -610,13 +1194,26 @@ edit_buffer_move_forward (const edit_buffer_t * buf, off_t current, long lines,
 off_t
 edit_buffer_move_backward (const edit_buffer_t * buf, off_t current, long lines)
 {
+    long line;
+
+    if (current <= 0)
+        return 0;
+
     lines = max (lines, 0);
-    current = edit_buffer_get_bol (buf, current);
 
-    while (lines-- != 0 && current != 0)
-        current = edit_buffer_get_bol (buf, current - 1);
+    if (lines <= EDIT_BUF_SCAN_LINES)
+    {
+        current = edit_buffer_get_bol (buf, current);
+
+        while (lines-- != 0 && current != 0)
+            current = edit_buffer_get_bol (buf, current - 1);
 
-    return current;
+        return current;
+    }
+
+    line = edit_buffer_lines_before (buf, min (current, buf->curs1 + buf->curs2));
+
+    return edit_buffer_get_line_offset (buf, max (line - lines, 0));
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -635,7 +1232,7 @@ edit_buffer_read_file (edit_buffer_t * buf, int fd, off_t size,
                        edit_buffer_read_file_status_msg_t * sm, gboolean * aborted)
 {
     off_t ret = 0;
-    off_t i, j;
+    off_t i;
     off_t data_size;
     void *b;
     status_msg_t *s = STATUS_MSG (sm);
@@ -656,11 +1253,6 @@ edit_buffer_read_file (edit_buffer_t * buf, int fd, off_t size,
         b = (char *) b + EDIT_BUF_SIZE - data_size;
         ret = mc_read (fd, b, data_size);
 
-        /* count lines */
-        for (j = 0; j < ret; j++)
-            if (*((char *) b + j) == '\n')
-                buf->lines++;
-
         if (ret < 0 || ret != data_size)
             return ret;
     }
@@ -677,11 +1269,6 @@ edit_buffer_read_file (edit_buffer_t * buf, int fd, off_t size,
         if (sz >= 0)
             ret += sz;
 
-        /* count lines */
-        for (j = 0; j < sz; j++)
-            if (*((char *) b + j) == '\n')
-                buf->lines++;
-
         if (s != NULL && s->update != NULL)
         {
             update_cnt = (update_cnt + 1) & 0xf;
@@ -731,6 +1318,10 @@ edit_buffer_read_file (edit_buffer_t * buf, int fd, off_t size,
         }
     }
 
+    /* count lines */
+    edit_buffer_index_build (buf->b2_lines, buf->b2, buf->curs2, TRUE);
+    buf->lines = edit_buffer_index_sum (buf->b2_lines, buf->b2_lines->len);
+
     return ret;
 }
 
@@ -17,6 +17,8 @@ typedef struct edit_buffer_struct
     off_t curs2;                /* position from the end of the file */
     GPtrArray *b1;              /* all data up to curs1 */
     GPtrArray *b2;              /* all data from end of file down to curs2 */
+    GArray *b1_lines;           /* index of newlines in b1 buffers */
+    GArray *b2_lines;           /* index of newlines in b2 buffers */
     off_t size;                 /* file size */
     long lines;                 /* total lines in the file */
     long curs_line;             /* line number of the cursor. */
@@ -39,6 +41,7 @@ void edit_buffer_init (edit_buffer_t * buf, off_t size);
 void edit_buffer_clean (edit_buffer_t * buf);
 
 int edit_buffer_get_byte (const edit_buffer_t * buf, off_t byte_index);
+const char *edit_buffer_get_block (const edit_buffer_t * buf, off_t byte_index, off_t * len);
 #ifdef HAVE_CHARSET
 int edit_buffer_get_utf (const edit_buffer_t * buf, off_t byte_index, int *char_length);
 int edit_buffer_get_prev_utf (const edit_buffer_t * buf, off_t byte_index, int *char_length);
@@ -46,13 +49,20 @@ int edit_buffer_get_prev_utf (const edit_buffer_t * buf, off_t byte_index, int *
 long edit_buffer_count_lines (const edit_buffer_t * buf, off_t first, off_t last);
 off_t edit_buffer_get_bol (const edit_buffer_t * buf, off_t current);
 off_t edit_buffer_get_eol (const edit_buffer_t * buf, off_t current);
+off_t edit_buffer_get_line_offset (const edit_buffer_t * buf, long line);
 GString *edit_buffer_get_word_from_pos (const edit_buffer_t * buf, off_t start_pos, off_t * start,
                                         gsize * cut);
 
 void edit_buffer_insert (edit_buffer_t * buf, int c);
+long edit_buffer_insert_block (edit_buffer_t * buf, const char *block, size_t len);
 void edit_buffer_insert_ahead (edit_buffer_t * buf, int c);
+long edit_buffer_insert_ahead_block (edit_buffer_t * buf, const char *block, size_t len);
 int edit_buffer_delete (edit_buffer_t * buf);
+long edit_buffer_delete_block (edit_buffer_t * buf, char *block, size_t len);
 int edit_buffer_backspace (edit_buffer_t * buf);
+long edit_buffer_backspace_block (edit_buffer_t * buf, char *block, size_t len);
+long edit_buffer_move_cursor (edit_buffer_t * buf, off_t increment);
+void edit_buffer_copy_block (const edit_buffer_t * buf, off_t start, off_t finish, char *dest);
 
 off_t edit_buffer_move_forward (const edit_buffer_t * buf, off_t current, long lines, off_t upto);
 off_t edit_buffer_move_backward (const edit_buffer_t * buf, off_t current, long lines);
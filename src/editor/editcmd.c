@@ -588,7 +588,8 @@ edit_block_delete (WEdit * edit)
 
     if (edit->column_highlight && edit->mark2 < 0)
         edit_mark_cmd (edit, FALSE);
-    if ((end_mark - start_mark) > option_max_undo / 2)
+    /* column is deleted by bytes, other block is saved in the undo stack as a whole */
+    if ((end_mark - start_mark) > (edit->column_highlight ? option_max_undo / 2 : UNDO_TEXT_MAX))
     {
         /* Warning message with a query to continue or cancel the operation */
         if (edit_query_dialog2
@@ -633,12 +634,7 @@ edit_block_delete (WEdit * edit)
                 edit->over_col = curs_pos - line_width;
         }
         else
-        {
-            off_t count;
-
-            for (count = start_mark; count < end_mark; count++)
-                edit_delete (edit, TRUE);
-        }
+            edit_delete_block (edit, end_mark - start_mark);
     }
     edit_set_markers (edit, 0, 0, 0, 0);
     edit->force |= REDRAW_PAGE;
@@ -1042,6 +1038,130 @@ edit_search (WEdit * edit)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Append bytes of the editor buffer to another buffer */
+
+static void
+edit_replace_all_copy (const edit_buffer_t * buf, off_t start, off_t finish, edit_buffer_t * dest)
+{
+    while (start < finish)
+    {
+        const char *p;
+        off_t len;
+
+        p = edit_buffer_get_block (buf, start, &len);
+        if (p == NULL)
+            break;
+
+        len = min (len, finish - start);
+        edit_buffer_insert_block (dest, p, (size_t) len);
+        start += len;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Replace all matches from the search start forward in one pass.
+ *
+ * The buffer is scanned once and the text from the first to the last match is built with
+ * the replacements in a separate buffer. Then it is put into the editor buffer instead of
+ * the old text at once, so undo restores the whole text by one block action.
+ *
+ * @param edit editor object
+ * @param esm search status message
+ * @param replace replacement string
+ * @param once_found TRUE if something was already found by the current replace command
+ *
+ * @return number of replacements made
+ */
+
+static long
+edit_replace_all (WEdit * edit, edit_search_status_msg_t * esm, GString * replace,
+                  gboolean once_found)
+{
+    edit_buffer_t result;
+    off_t start = 0, copied = 0, last = 0;
+    gsize len = 0, last_len = 0, last_found_len = 0;
+    long count = 0;
+
+    edit_buffer_init (&result, 0);
+
+    while (edit->search_start < edit->buffer.size)
+    {
+        off_t found;
+        GString *repl_str;
+
+        if (!editcmd_find (esm, &len))
+        {
+            if (!(edit->search->error == MC_SEARCH_E_OK ||
+                  ((once_found || count != 0) && edit->search->error == MC_SEARCH_E_NOTFOUND)))
+                edit_query_dialog (_("Search"), edit->search->error_str);
+            break;
+        }
+
+        found = edit->search->normal_offset;
+        if (found < 0 || found >= edit->buffer.size)
+        {
+            if (!once_found && count == 0)
+                query_dialog (_("Replace"), _("Search string not found"), D_NORMAL, 1, _("&OK"));
+            break;
+        }
+
+        repl_str = mc_search_prepare_replace_str (edit->search, replace);
+        if (edit->search->error != MC_SEARCH_E_OK)
+        {
+            edit_error_dialog (_("Replace"), edit->search->error_str);
+            g_string_free (repl_str, TRUE);
+            break;
+        }
+
+        if (count == 0)
+            start = copied = found;
+
+        edit_replace_all_copy (&edit->buffer, copied, found, &result);
+        last = result.curs1;
+        last_len = repl_str->len;
+        edit_buffer_insert_block (&result, repl_str->str, repl_str->len);
+        g_string_free (repl_str, TRUE);
+
+        copied = found + (off_t) len;
+        last_found_len = len;
+        count++;
+
+        /* so that we don't find the same string again */
+        edit->search_start = copied + (len == 0 ? 1 : 0);
+    }
+
+    if (count != 0)
+    {
+        off_t offset;
+
+        edit_cursor_move (edit, start - edit->buffer.curs1);
+        edit_delete_block (edit, copied - start);
+
+        for (offset = 0; offset < result.curs1;)
+        {
+            const char *p;
+            off_t n;
+
+            p = edit_buffer_get_block (&result, offset, &n);
+            edit_insert_block (edit, p, (size_t) n);
+            offset += n;
+        }
+
+        edit->found_start = start + last;
+        edit->found_len = last_len;
+        edit->search_start = edit->found_start + last_len + (last_found_len == 0 ? 1 : 0);
+        edit->force |= REDRAW_PAGE;
+    }
+    else
+        edit->search_start = edit->buffer.curs1;
+
+    edit_buffer_clean (&result);
+
+    return count;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /** Return a null terminated length of text. Result must be g_free'd */
 
@@ -1074,8 +1194,8 @@ edit_get_block (WEdit * edit, off_t start, off_t finish, off_t * l)
     else
     {
         *l = finish - start;
-        while (start < finish)
-            *s++ = edit_buffer_get_byte (&edit->buffer, start++);
+        edit_buffer_copy_block (&edit->buffer, start, finish, (char *) s);
+        s += *l;
     }
     *s = '\0';
     return r;
@@ -1242,6 +1362,7 @@ edit_collect_completions (WEdit * edit, off_t word_start, gsize word_len,
     srch->search_type = MC_SEARCH_T_REGEX;
     srch->is_case_sensitive = TRUE;
     srch->search_fn = edit_search_cmd_callback;
+    srch->search_block_fn = edit_search_cmd_block_callback;
     srch->update_fn = edit_search_update_callback;
 
     esm.first = TRUE;
@@ -2355,14 +2476,11 @@ edit_block_copy_cmd (WEdit * edit)
     }
     else
     {
-        int size_orig = size;
-
-        while (size-- != 0)
-            edit_insert_ahead (edit, copy_buf[size]);
+        edit_insert_ahead_block (edit, (const char *) copy_buf, (size_t) size);
 
         /* Place cursor at the end of text selection */
         if (option_cursor_after_inserted_block)
-            edit_cursor_move (edit, size_orig);
+            edit_cursor_move (edit, size);
     }
 
     g_free (copy_buf);
@@ -2446,31 +2564,27 @@ edit_block_move_cmd (WEdit * edit)
     }
     else
     {
-        off_t count, count_orig;
+        off_t size;
 
         current = edit->buffer.curs1;
-        copy_buf = g_malloc0 (end_mark - start_mark);
+        copy_buf = edit_get_block (edit, start_mark, end_mark, &size);
         edit_cursor_move (edit, start_mark - edit->buffer.curs1);
         edit_scroll_screen_over_cursor (edit);
 
-        for (count = start_mark; count < end_mark; count++)
-            copy_buf[end_mark - count - 1] = edit_delete (edit, TRUE);
+        edit_delete_block (edit, size);
 
         edit_scroll_screen_over_cursor (edit);
         edit_cursor_move (edit,
                           current - edit->buffer.curs1 -
-                          (((current - edit->buffer.curs1) > 0) ? end_mark - start_mark : 0));
+                          (((current - edit->buffer.curs1) > 0) ? size : 0));
         edit_scroll_screen_over_cursor (edit);
-        count_orig = count;
-        while (count-- > start_mark)
-            edit_insert_ahead (edit, copy_buf[end_mark - count - 1]);
+        edit_insert_ahead_block (edit, (const char *) copy_buf, (size_t) size);
 
-        edit_set_markers (edit, edit->buffer.curs1, edit->buffer.curs1 + end_mark - start_mark, 0,
-                          0);
+        edit_set_markers (edit, edit->buffer.curs1, edit->buffer.curs1 + size, 0, 0);
 
         /* Place cursor at the end of text selection */
         if (option_cursor_after_inserted_block)
-            edit_cursor_move (edit, count_orig - start_mark);
+            edit_cursor_move (edit, size);
     }
 
     edit_scroll_screen_over_cursor (edit);
@@ -2583,6 +2697,7 @@ edit_replace_cmd (WEdit * edit, int again)
         edit->search->is_case_sensitive = edit_search_options.case_sens;
         edit->search->whole_words = edit_search_options.whole_words;
         edit->search->search_fn = edit_search_cmd_callback;
+        edit->search->search_block_fn = edit_search_cmd_block_callback;
         edit->search->update_fn = edit_search_update_callback;
         edit->search_line_type = edit_get_search_line_type (edit->search);
         edit_search_fix_search_start_if_selection (edit);
@@ -2607,6 +2722,12 @@ edit_replace_cmd (WEdit * edit, int again)
     {
         gsize len = 0;
 
+        if (edit->replace_mode == 1 && !edit_search_options.backwards)
+        {
+            times_replaced += edit_replace_all (edit, &esm, input2_str, once_found);
+            break;
+        }
+
         if (!editcmd_find (&esm, &len))
         {
             if (!(edit->search->error == MC_SEARCH_E_OK ||
@@ -2657,7 +2778,12 @@ edit_replace_cmd (WEdit * edit, int again)
                 g_free (disp2);
 
                 if (prompt == B_REPLACE_ALL)
+                {
                     edit->replace_mode = 1;
+                    /* replace this and the following matches at once */
+                    if (!edit_search_options.backwards)
+                        continue;       /* loop */
+                }
                 else if (prompt == B_SKIP_REPLACE)
                 {
                     if (edit_search_options.backwards)
@@ -2752,6 +2878,27 @@ edit_search_cmd_callback (const void *user_data, gsize char_offset, int *current
 
 /* --------------------------------------------------------------------------------------------- */
 
+mc_search_cbret_t
+edit_search_cmd_block_callback (const void *user_data, gsize char_offset, const char **block,
+                                gsize * block_len)
+{
+    WEdit *edit = ((edit_search_status_msg_t *) user_data)->edit;
+    off_t len;
+
+    *block = edit_buffer_get_block (&edit->buffer, (off_t) char_offset, &len);
+    if (*block == NULL)
+    {
+        /* stop search symbol, like edit_buffer_get_byte() returns beyond the buffer */
+        *block = "\n";
+        len = 1;
+    }
+
+    *block_len = (gsize) len;
+    return MC_SEARCH_CB_OK;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 mc_search_cbret_t
 edit_search_update_callback (const void *user_data, gsize char_offset)
 {
@@ -2808,6 +2955,7 @@ edit_search_cmd (WEdit * edit, gboolean again)
                 edit->search->is_case_sensitive = edit_search_options.case_sens;
                 edit->search->whole_words = edit_search_options.whole_words;
                 edit->search->search_fn = edit_search_cmd_callback;
+                edit->search->search_block_fn = edit_search_cmd_block_callback;
                 edit->search->update_fn = edit_search_update_callback;
                 edit->search_line_type = edit_get_search_line_type (edit->search);
                 edit_do_search (edit);
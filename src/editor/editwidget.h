@@ -13,8 +13,6 @@
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
-#define N_LINE_CACHES 32
-
 /*** enums ***************************************************************************************/
 
 /**
@@ -38,6 +36,13 @@ struct edit_book_mark_t
     edit_book_mark_t *prev;
 };
 
+/* records of block actions in the undo or redo stack */
+typedef struct
+{
+    GArray *records;            /* one record for each BLOCK_ACTION in the stack, oldest first */
+    GByteArray *text;           /* text saved by the records, in the same order */
+} edit_undo_blocks_t;
+
 typedef struct edit_syntax_rule_t edit_syntax_rule_t;
 struct edit_syntax_rule_t
 {
@@ -125,11 +130,6 @@ struct WEdit
     off_t bracket;              /* position of a matching bracket */
     off_t last_bracket;         /* previous position of a matching bracket */
 
-    /* cache speedup for line lookups */
-    gboolean caches_valid;
-    long line_numbers[N_LINE_CACHES];
-    off_t line_offsets[N_LINE_CACHES];
-
     edit_book_mark_t *book_mark;
     GArray *serialized_bookmarks;
 
@@ -140,6 +140,7 @@ struct WEdit
     unsigned long undo_stack_size_mask;
     unsigned long undo_stack_bottom;
     unsigned int undo_stack_disable:1;  /* If not 0, don't save events in the undo stack */
+    edit_undo_blocks_t undo_blocks;
 
     unsigned long redo_stack_pointer;
     long *redo_stack;
@@ -147,12 +148,14 @@ struct WEdit
     unsigned long redo_stack_size_mask;
     unsigned long redo_stack_bottom;
     unsigned int redo_stack_reset:1;    /* If 1, need clear redo stack */
+    edit_undo_blocks_t redo_blocks;
 
     struct stat stat1;          /* Result of mc_fstat() on the file */
     unsigned int skip_detach_prompt:1;  /* Do not prompt whether to detach a file anymore */
 
     /* syntax higlighting */
-    GSList *syntax_marker;
+    GArray *syntax_marker;      /* checkpoints of the syntax state, sorted by offset */
+    guint syntax_marker_valid;  /* number of checkpoints before the first changed one */
     GPtrArray *rules;
     off_t last_get_rule;
     edit_syntax_rule_t rule;
@@ -70,7 +70,7 @@ int option_auto_syntax = 1;
 
 /*** file scope macro definitions ****************************************************************/
 
-/* bytes */
+/* minimal distance between checkpoints of the syntax state, in bytes */
 #define SYNTAX_MARKER_DENSITY 512
 
 #define TRANSIENT_WORD_TIME_OUT 60
@@ -88,6 +88,9 @@ int option_auto_syntax = 1;
 #define SYNTAX_TOKEN_BRACKET    '\003'
 #define SYNTAX_TOKEN_BRACE      '\004'
 
+/* longest literal prefix of keyword stored in the keyword trie */
+#define KEYWORD_TRIE_DEPTH 32
+
 #define whiteness(x) ((x) == '\t' || (x) == '\n' || (x) == ' ')
 
 #define free_args(x)
@@ -97,6 +100,8 @@ int option_auto_syntax = 1;
 
 #define SYNTAX_KEYWORD(x) ((syntax_keyword_t *) (x))
 #define CONTEXT_RULE(x) ((context_rule_t *) (x))
+#define SYNTAX_MARKER(edit, i) (&g_array_index ((edit)->syntax_marker, syntax_marker_t, i))
+#define KEYWORD_TRIE_NODE(trie, i) (&g_array_index ((trie)->nodes, keyword_trie_node_t, i))
 
 /*** file scope type declarations ****************************************************************/
 
@@ -109,6 +114,28 @@ typedef struct
     int color;
 } syntax_keyword_t;
 
+/* node of the keyword trie */
+typedef struct
+{
+    unsigned char c;            /* character of the node */
+    guint child;                /* first child node, 0 if none */
+    guint next;                 /* next sibling node, 0 if none */
+    guint keyword;              /* first keyword with the literal prefix ending here, 0 if none */
+} keyword_trie_node_t;
+
+/*
+ * Keywords of a context compiled into a trie of their literal prefixes (up to the first
+ * wildcard token). The trie is shared by all contexts with the same keywords.
+ */
+typedef struct
+{
+    char *key;                  /* keywords separated by newlines */
+    int ref_count;
+    guint root[256];            /* nodes of the first characters */
+    GArray *nodes;              /* node 0 is the root: keywords starting with a wildcard */
+    guint *next_keyword;        /* next keyword with the same literal prefix, 0 if none */
+} keyword_trie_t;
+
 typedef struct
 {
     char *left;
@@ -120,22 +147,35 @@ typedef struct
     int between_delimiters;
     char *whole_word_chars_left;
     char *whole_word_chars_right;
-    char *keyword_first_chars;
+    keyword_trie_t *keyword_trie;
     gboolean spelling;
     /* first word is word[1] */
     GPtrArray *keyword;
 } context_rule_t;
 
+/* checkpoint of the syntax state at the beginning of a line */
 typedef struct
 {
     off_t offset;
-    edit_syntax_rule_t rule;
+    edit_syntax_rule_t rule;    /* state after the byte before offset */
 } syntax_marker_t;
 
+/* contiguous bytes of the editor buffer */
+typedef struct
+{
+    const WEdit *edit;
+    const unsigned char *data;
+    off_t start;
+    off_t end;
+} syntax_span_t;
+
 /*** file scope variables ************************************************************************/
 
 static char *error_file_name = NULL;
 
+/* keyword tries of all loaded syntax rules */
+static GHashTable *keyword_tries = NULL;
+
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -151,6 +191,146 @@ syntax_keyword_free (gpointer keyword)
     g_free (k);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Get child node of the trie node with the character, 0 if none */
+
+static inline guint
+keyword_trie_child (const keyword_trie_t * trie, guint n, int c)
+{
+    guint child;
+
+    if (n == 0)
+        return trie->root[c];
+
+    for (child = KEYWORD_TRIE_NODE (trie, n)->child;
+         child != 0 && KEYWORD_TRIE_NODE (trie, child)->c != c;
+         child = KEYWORD_TRIE_NODE (trie, child)->next)
+        ;
+
+    return child;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Add the literal prefix of keyword to the trie, return the node where it ends */
+
+static guint
+keyword_trie_add (keyword_trie_t * trie, const char *keyword)
+{
+    const unsigned char *p = (const unsigned char *) keyword;
+    guint n = 0;
+    int depth;
+
+    for (depth = 0; depth < KEYWORD_TRIE_DEPTH && p[depth] > SYNTAX_TOKEN_BRACE; depth++)
+    {
+        guint child;
+
+        child = keyword_trie_child (trie, n, p[depth]);
+        if (child == 0)
+        {
+            keyword_trie_node_t node;
+
+            node.c = p[depth];
+            node.child = 0;
+            node.next = n == 0 ? 0 : KEYWORD_TRIE_NODE (trie, n)->child;
+            node.keyword = 0;
+            child = trie->nodes->len;
+            g_array_append_val (trie->nodes, node);
+
+            if (n == 0)
+                trie->root[p[depth]] = child;
+            else
+                KEYWORD_TRIE_NODE (trie, n)->child = child;
+        }
+
+        n = child;
+    }
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get the trie of keywords of context. Tries are compiled once and shared between contexts
+ * with the same keywords, e.g. in editor windows with the same syntax.
+ */
+
+static keyword_trie_t *
+keyword_trie_get (const GPtrArray * keywords)
+{
+    keyword_trie_t *trie;
+    GString *key;
+    guint i, len;
+
+    key = g_string_sized_new (256);
+    for (i = 1; i < keywords->len; i++)
+    {
+        g_string_append (key, SYNTAX_KEYWORD (g_ptr_array_index (keywords, i))->keyword);
+        g_string_append_c (key, '\n');
+    }
+
+    if (keyword_tries == NULL)
+        keyword_tries = g_hash_table_new (g_str_hash, g_str_equal);
+
+    trie = (keyword_trie_t *) g_hash_table_lookup (keyword_tries, key->str);
+    if (trie != NULL)
+    {
+        g_string_free (key, TRUE);
+        trie->ref_count++;
+        return trie;
+    }
+
+    trie = g_new0 (keyword_trie_t, 1);
+    trie->key = g_string_free (key, FALSE);
+    trie->ref_count = 1;
+    trie->nodes = g_array_new (FALSE, TRUE, sizeof (keyword_trie_node_t));
+    g_array_set_size (trie->nodes, 1);
+    trie->next_keyword = g_new0 (guint, keywords->len);
+
+    /* keywords after an empty one were never matched */
+    for (len = 1; len < keywords->len; len++)
+        if (*SYNTAX_KEYWORD (g_ptr_array_index (keywords, len))->keyword == '\0')
+            break;
+
+    /* add keywords from the last one to keep the lists in order of the syntax file */
+    for (i = len - 1; i > 0; i--)
+    {
+        syntax_keyword_t *k = SYNTAX_KEYWORD (g_ptr_array_index (keywords, i));
+        keyword_trie_node_t *node;
+        guint n;
+
+        /* nodes can be reallocated by keyword_trie_add() */
+        n = keyword_trie_add (trie, k->keyword);
+        node = KEYWORD_TRIE_NODE (trie, n);
+        trie->next_keyword[i] = node->keyword;
+        node->keyword = i;
+    }
+
+    g_hash_table_insert (keyword_tries, trie->key, trie);
+
+    return trie;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+keyword_trie_unref (keyword_trie_t * trie)
+{
+    if (trie == NULL || --trie->ref_count != 0)
+        return;
+
+    g_hash_table_remove (keyword_tries, trie->key);
+    if (g_hash_table_size (keyword_tries) == 0)
+    {
+        g_hash_table_destroy (keyword_tries);
+        keyword_tries = NULL;
+    }
+
+    g_free (trie->key);
+    g_array_free (trie->nodes, TRUE);
+    g_free (trie->next_keyword);
+    g_free (trie);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static void
@@ -162,7 +342,7 @@ context_rule_free (gpointer rule)
     g_free (r->right);
     g_free (r->whole_word_chars_left);
     g_free (r->whole_word_chars_right);
-    g_free (r->keyword_first_chars);
+    keyword_trie_unref (r->keyword_trie);
 
     if (r->keyword != NULL)
     {
@@ -247,6 +427,32 @@ subst_defines (GTree * defines, char **argv, char **argv_end)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Get byte from the span, fetch the span containing the byte if it is outside the current one */
+
+static inline int
+syntax_span_get_byte (syntax_span_t * span, off_t i)
+{
+    if (i < span->start || i >= span->end)
+    {
+        off_t len;
+
+        span->data =
+            (const unsigned char *) edit_buffer_get_block (&span->edit->buffer, i, &len);
+        if (span->data == NULL)
+        {
+            /* like edit_buffer_get_byte() beyond the buffer */
+            span->start = span->end = 0;
+            return '\n';
+        }
+
+        span->start = i;
+        span->end = i + len;
+    }
+
+    return span->data[i - span->start];
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static off_t
@@ -255,11 +461,12 @@ compare_word_to_right (const WEdit * edit, off_t i, const char *text,
 {
     const unsigned char *p, *q;
     int c, d, j;
+    syntax_span_t span = { edit, NULL, 0, 0 };
 
     if (*text == '\0')
         return -1;
 
-    c = xx_tolower (edit, edit_buffer_get_byte (&edit->buffer, i - 1));
+    c = xx_tolower (edit, syntax_span_get_byte (&span, i - 1));
     if ((line_start != 0 && c != '\n') || (whole_left != NULL && strchr (whole_left, c) != NULL))
         return -1;
 
@@ -272,7 +479,7 @@ compare_word_to_right (const WEdit * edit, off_t i, const char *text,
                 return -1;
             while (TRUE)
             {
-                c = xx_tolower (edit, edit_buffer_get_byte (&edit->buffer, i));
+                c = xx_tolower (edit, syntax_span_get_byte (&span, i));
                 if (*p == '\0' && whole_right != NULL && strchr (whole_right, c) == NULL)
                     break;
                 if (c == *p)
@@ -288,7 +495,7 @@ compare_word_to_right (const WEdit * edit, off_t i, const char *text,
             j = 0;
             while (TRUE)
             {
-                c = xx_tolower (edit, edit_buffer_get_byte (&edit->buffer, i));
+                c = xx_tolower (edit, syntax_span_get_byte (&span, i));
                 if (c == *p)
                 {
                     j = i;
@@ -320,7 +527,7 @@ compare_word_to_right (const WEdit * edit, off_t i, const char *text,
             while (TRUE)
             {
                 d = c;
-                c = xx_tolower (edit, edit_buffer_get_byte (&edit->buffer, i));
+                c = xx_tolower (edit, syntax_span_get_byte (&span, i));
                 for (j = 0; p[j] != SYNTAX_TOKEN_BRACKET && p[j]; j++)
                     if (c == p[j])
                         goto found_char2;
@@ -339,7 +546,7 @@ compare_word_to_right (const WEdit * edit, off_t i, const char *text,
         case SYNTAX_TOKEN_BRACE:
             if (++p > q)
                 return -1;
-            c = xx_tolower (edit, edit_buffer_get_byte (&edit->buffer, i));
+            c = xx_tolower (edit, syntax_span_get_byte (&span, i));
             for (; *p != SYNTAX_TOKEN_BRACE && *p; p++)
                 if (c == *p)
                     goto found_char3;
@@ -349,24 +556,73 @@ compare_word_to_right (const WEdit * edit, off_t i, const char *text,
                 p++;
             break;
         default:
-            if (*p != xx_tolower (edit, edit_buffer_get_byte (&edit->buffer, i)))
+            if (*p != xx_tolower (edit, syntax_span_get_byte (&span, i)))
                 return -1;
         }
     }
     return (whole_right != NULL &&
             strchr (whole_right,
-                    xx_tolower (edit, edit_buffer_get_byte (&edit->buffer, i))) != NULL) ? -1 : i;
+                    xx_tolower (edit, syntax_span_get_byte (&span, i))) != NULL) ? -1 : i;
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the keyword of context starting at the byte.
+ *
+ * The trie selects keywords whose literal prefix matches the text, the rest of them (wildcards
+ * and whole word limits) is checked by compare_word_to_right(). Keywords are tried in order
+ * of the syntax file.
+ *
+ * @param end end of the keyword found
+ * @return index of the keyword, 0 if not found
+ */
 
-static const char *
-xx_strchr (const WEdit * edit, const unsigned char *s, int char_byte)
+static guint
+keyword_trie_find (const WEdit * edit, const context_rule_t * r, off_t i, off_t * end)
 {
-    while (*s >= '\005' && xx_tolower (edit, *s) != char_byte)
-        s++;
+    const keyword_trie_t *trie = r->keyword_trie;
+    guint heads[KEYWORD_TRIE_DEPTH + 1];
+    int depth = 0;
+    syntax_span_t span = { edit, NULL, 0, 0 };
+    guint n;
+    off_t j;
 
-    return (const char *) s;
+    /* keywords starting with a wildcard */
+    heads[depth++] = KEYWORD_TRIE_NODE (trie, 0)->keyword;
+
+    for (j = i, n = trie->root[xx_tolower (edit, syntax_span_get_byte (&span, j))]; n != 0;
+         n = keyword_trie_child (trie, n, xx_tolower (edit, syntax_span_get_byte (&span, ++j))))
+        heads[depth++] = KEYWORD_TRIE_NODE (trie, n)->keyword;
+
+    while (TRUE)
+    {
+        guint k = 0;
+        int d, first = 0;
+        syntax_keyword_t *kw;
+        off_t e;
+
+        /* merge lists of keywords of all prefixes */
+        for (d = 0; d < depth; d++)
+            if (heads[d] != 0 && (k == 0 || heads[d] < k))
+            {
+                k = heads[d];
+                first = d;
+            }
+
+        if (k == 0)
+            return 0;
+
+        heads[first] = trie->next_keyword[k];
+
+        kw = SYNTAX_KEYWORD (g_ptr_array_index (r->keyword, k));
+        e = compare_word_to_right (edit, i, kw->keyword, kw->whole_word_chars_left,
+                                   kw->whole_word_chars_right, kw->line_start);
+        if (e > 0)
+        {
+            *end = e;
+            return k;
+        }
+    }
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -437,31 +693,18 @@ apply_rules_going_right (WEdit * edit, off_t i)
     /* check to turn on a keyword */
     if (_rule.keyword == 0)
     {
-        const char *p;
+        guint count;
+        off_t e;
 
         r = CONTEXT_RULE (g_ptr_array_index (edit->rules, _rule.context));
-        p = r->keyword_first_chars;
-
-        if (p != NULL)
-            while (*(p = xx_strchr (edit, (unsigned char *) p + 1, c)) != '\0')
-            {
-                syntax_keyword_t *k;
-                int count;
-                off_t e;
-
-                count = p - r->keyword_first_chars;
-                k = SYNTAX_KEYWORD (g_ptr_array_index (r->keyword, count));
-                e = compare_word_to_right (edit, i, k->keyword, k->whole_word_chars_left,
-                                           k->whole_word_chars_right, k->line_start);
-                if (e > 0)
-                {
-                    end = e;
-                    _rule.end = e;
-                    _rule.keyword = count;
-                    keyword_foundright = TRUE;
-                    break;
-                }
-            }
+        count = r->keyword_trie != NULL ? keyword_trie_find (edit, r, i, &e) : 0;
+        if (count != 0)
+        {
+            end = e;
+            _rule.end = e;
+            _rule.keyword = count;
+            keyword_foundright = TRUE;
+        }
     }
 
     /* check to turn on a context */
@@ -539,27 +782,15 @@ apply_rules_going_right (WEdit * edit, off_t i)
     /* check again to turn on a keyword if the context switched */
     if (contextchanged && _rule.keyword == 0)
     {
-        const char *p;
+        guint count;
+        off_t e;
 
         r = CONTEXT_RULE (g_ptr_array_index (edit->rules, _rule.context));
-        p = r->keyword_first_chars;
-
-        while (*(p = xx_strchr (edit, (unsigned char *) p + 1, c)) != '\0')
+        count = keyword_trie_find (edit, r, i, &e);
+        if (count != 0)
         {
-            syntax_keyword_t *k;
-            int count;
-            off_t e;
-
-            count = p - r->keyword_first_chars;
-            k = SYNTAX_KEYWORD (g_ptr_array_index (r->keyword, count));
-            e = compare_word_to_right (edit, i, k->keyword, k->whole_word_chars_left,
-                                       k->whole_word_chars_right, k->line_start);
-            if (e > 0)
-            {
-                _rule.end = e;
-                _rule.keyword = count;
-                break;
-            }
+            _rule.end = e;
+            _rule.keyword = count;
         }
     }
 
@@ -568,61 +799,187 @@ apply_rules_going_right (WEdit * edit, off_t i)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Get number of valid checkpoints at or before the offset.
+ */
+
+static guint
+edit_syntax_marker_count (const WEdit * edit, off_t offset)
+{
+    guint lo = 0, hi;
+
+    if (edit->syntax_marker == NULL)
+        return 0;
+
+    hi = edit->syntax_marker_valid;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (SYNTAX_MARKER (edit, mid)->offset <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Restore the syntax state from the nearest checkpoint before byte_index if the current state
+ * is after byte_index or the checkpoint is closer.
+ */
+
 static void
-edit_get_rule (WEdit * edit, off_t byte_index)
+edit_syntax_restore (WEdit * edit, off_t byte_index)
 {
-    off_t i;
+    const syntax_marker_t *s = NULL;
+    guint n;
 
-    if (byte_index > edit->last_get_rule)
+    n = edit_syntax_marker_count (edit, byte_index + 1);
+    if (n != 0)
+        s = SYNTAX_MARKER (edit, n - 1);
+
+    if (byte_index < edit->last_get_rule)
     {
-        for (i = edit->last_get_rule + 1; i <= byte_index; i++)
+        if (s == NULL)
         {
-            off_t d = SYNTAX_MARKER_DENSITY;
+            /* start from the beginning of file */
+            memset (&edit->rule, 0, sizeof (edit->rule));
+            edit->last_get_rule = -2;
+            return;
+        }
+    }
+    else if (s == NULL || s->offset - 1 <= edit->last_get_rule)
+        return;
 
-            apply_rules_going_right (edit, i);
+    edit->rule = s->rule;
+    edit->last_get_rule = s->offset - 1;
+}
 
-            if (edit->syntax_marker != NULL)
-                d += ((syntax_marker_t *) edit->syntax_marker->data)->offset;
+/* --------------------------------------------------------------------------------------------- */
+/** Get offset where the next checkpoint can be set or an old one can be checked */
 
-            if (i > d)
-            {
-                syntax_marker_t *s;
+static off_t
+edit_syntax_next_marker (const WEdit * edit)
+{
+    off_t next = SYNTAX_MARKER_DENSITY;
+    guint valid;
 
-                s = g_new (syntax_marker_t, 1);
-                s->offset = i;
-                s->rule = edit->rule;
-                edit->syntax_marker = g_slist_prepend (edit->syntax_marker, s);
-            }
+    if (edit->syntax_marker == NULL)
+        return next;
+
+    valid = edit->syntax_marker_valid;
+    if (valid != 0)
+        next += SYNTAX_MARKER (edit, valid - 1)->offset;
+    if (valid < edit->syntax_marker->len)
+        next = min (next, SYNTAX_MARKER (edit, valid)->offset);
+
+    return next;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+edit_syntax_rule_equal (const edit_syntax_rule_t * r1, const edit_syntax_rule_t * r2, off_t offset)
+{
+    /* the end before the offset isn't used anymore */
+    return (r1->keyword == r2->keyword && r1->context == r2->context
+            && r1->_context == r2->_context && r1->border == r2->border
+            && (r1->end == r2->end || (r1->end < offset && r2->end < offset)));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Save the current state at the beginning of line after the valid checkpoints.
+ *
+ * @return TRUE if the state is the same as in the old checkpoint at this offset. The syntax
+ *         after the offset is the same as before the change, so all checkpoints are valid.
+ */
+
+static gboolean
+edit_syntax_checkpoint (WEdit * edit, off_t offset)
+{
+    GArray *markers;
+    syntax_marker_t *s;
+    guint valid;
+
+    if (edit->syntax_marker == NULL)
+        edit->syntax_marker = g_array_new (FALSE, FALSE, sizeof (syntax_marker_t));
+
+    markers = edit->syntax_marker;
+    valid = edit->syntax_marker_valid;
+
+    /* state is saved only after the valid checkpoints */
+    if (valid != 0 && offset <= SYNTAX_MARKER (edit, valid - 1)->offset)
+        return FALSE;
+
+    /* drop the old checkpoints which aren't at the beginning of line anymore */
+    while (valid < markers->len && SYNTAX_MARKER (edit, valid)->offset < offset)
+        g_array_remove_index (markers, valid);
+
+    if (valid < markers->len && SYNTAX_MARKER (edit, valid)->offset == offset)
+    {
+        s = SYNTAX_MARKER (edit, valid);
+        if (edit_syntax_rule_equal (&s->rule, &edit->rule, offset))
+        {
+            edit->syntax_marker_valid = markers->len;
+            return TRUE;
         }
+
+        s->rule = edit->rule;
+        edit->syntax_marker_valid++;
     }
-    else if (byte_index < edit->last_get_rule)
+    else if (valid == 0
+             || offset >= SYNTAX_MARKER (edit, valid - 1)->offset + SYNTAX_MARKER_DENSITY)
     {
-        while (TRUE)
-        {
-            syntax_marker_t *s;
+        syntax_marker_t m;
 
-            if (edit->syntax_marker == NULL)
-            {
-                memset (&edit->rule, 0, sizeof (edit->rule));
-                for (i = -1; i <= byte_index; i++)
-                    apply_rules_going_right (edit, i);
-                break;
-            }
+        m.offset = offset;
+        m.rule = edit->rule;
+        g_array_insert_val (markers, valid, m);
+        edit->syntax_marker_valid++;
+    }
 
-            s = (syntax_marker_t *) edit->syntax_marker->data;
+    return FALSE;
+}
 
-            if (byte_index >= s->offset)
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get the syntax state after the byte.
+ *
+ * The states at beginnings of lines are saved in checkpoints. When the text is changed, the
+ * checkpoints after the change are kept, and the re-highlighting stops to set checkpoints when
+ * the new state converges with an old checkpoint.
+ */
+
+static void
+edit_get_rule (WEdit * edit, off_t byte_index)
+{
+    off_t i, next;
+
+    edit_syntax_restore (edit, byte_index);
+    next = edit_syntax_next_marker (edit);
+
+    for (i = edit->last_get_rule + 1; i <= byte_index; i++)
+    {
+        if (i >= next && edit_buffer_get_byte (&edit->buffer, i - 1) == '\n')
+        {
+            if (edit_syntax_checkpoint (edit, i))
             {
-                edit->rule = s->rule;
-                for (i = s->offset + 1; i <= byte_index; i++)
-                    apply_rules_going_right (edit, i);
-                break;
+                /* skip to the last checkpoint before byte_index */
+                edit->last_get_rule = i - 1;
+                edit_syntax_restore (edit, byte_index);
+                i = edit->last_get_rule + 1;
             }
 
-            g_free (s);
-            edit->syntax_marker = g_slist_delete_link (edit->syntax_marker, edit->syntax_marker);
+            next = edit_syntax_next_marker (edit);
         }
+
+        apply_rules_going_right (edit, i);
     }
+
     edit->last_get_rule = byte_index;
 }
 
@@ -1217,34 +1574,16 @@ edit_read_syntax_rules (WEdit * edit, FILE * f, char **args, int args_size)
     if (result == 0)
     {
         size_t i;
-        GString *first_chars;
 
         if (edit->rules == NULL)
             return line;
 
-        first_chars = g_string_sized_new (32);
-
-        /* collect first character of keywords */
+        /* compile keywords */
         for (i = 0; i < edit->rules->len; i++)
         {
-            size_t j;
-
-            g_string_set_size (first_chars, 0);
             c = CONTEXT_RULE (g_ptr_array_index (edit->rules, i));
-
-            g_string_append_c (first_chars, (char) 1);
-            for (j = 1; j < c->keyword->len; j++)
-            {
-                syntax_keyword_t *k;
-
-                k = SYNTAX_KEYWORD (g_ptr_array_index (c->keyword, j));
-                g_string_append_c (first_chars, k->keyword[0]);
-            }
-
-            c->keyword_first_chars = g_strndup (first_chars->str, first_chars->len);
+            c->keyword_trie = keyword_trie_get (c->keyword);
         }
-
-        g_string_free (first_chars, TRUE);
     }
 
     return result;
@@ -1428,6 +1767,68 @@ edit_get_syntax_color (WEdit * edit, off_t byte_index)
     return EDITOR_NORMAL_COLOR;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Update the syntax checkpoints after the text is changed.
+ * The checkpoints after the change are kept until the new syntax state is compared with them.
+ *
+ * @param edit editor object
+ * @param offset offset of the change
+ * @param len number of inserted bytes if positive, number of deleted bytes if negative
+ */
+
+void
+edit_syntax_changed (WEdit * edit, off_t offset, off_t len)
+{
+    GArray *markers = edit->syntax_marker;
+
+    if (len == 0)
+        return;
+
+    if (markers != NULL)
+    {
+        guint lo = 0, hi = markers->len, first, k;
+
+        /* find the first checkpoint after the offset */
+        while (lo < hi)
+        {
+            guint mid = lo + (hi - lo) / 2;
+
+            if (SYNTAX_MARKER (edit, mid)->offset <= offset)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        first = lo;
+
+        /* remove checkpoints in the deleted text */
+        if (len < 0)
+        {
+            for (k = first; k < markers->len && SYNTAX_MARKER (edit, k)->offset <= offset - len;
+                 k++)
+                ;
+            g_array_remove_range (markers, first, k - first);
+        }
+
+        /* only one changed region is re-checked: drop the old checkpoints after another change.
+           Changes before the same checkpoint, like typing, are in one region */
+        if (edit->syntax_marker_valid < markers->len && first != edit->syntax_marker_valid)
+            g_array_set_size (markers, MAX (first, edit->syntax_marker_valid));
+
+        for (k = first; k < markers->len; k++)
+        {
+            SYNTAX_MARKER (edit, k)->offset += len;
+            SYNTAX_MARKER (edit, k)->rule.end += len;
+        }
+
+        edit->syntax_marker_valid = min (edit->syntax_marker_valid, first);
+    }
+
+    /* the current state is after the change */
+    if (edit->last_get_rule >= offset)
+        edit_syntax_restore (edit, offset - 1);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -1448,8 +1849,12 @@ edit_free_syntax_rules (WEdit * edit)
     g_ptr_array_foreach (edit->rules, (GFunc) context_rule_free, NULL);
     g_ptr_array_free (edit->rules, TRUE);
     edit->rules = NULL;
-    g_slist_free_full (edit->syntax_marker, g_free);
-    edit->syntax_marker = NULL;
+    if (edit->syntax_marker != NULL)
+    {
+        g_array_free (edit->syntax_marker, TRUE);
+        edit->syntax_marker = NULL;
+    }
+    edit->syntax_marker_valid = 0;
     tty_color_free_all_tmp ();
 }
 
@@ -104,6 +104,15 @@
 #define MAP_FILE 0
 #endif
 
+/* Number of threads comparing contents of files */
+#define COMPARE_THREADS 4
+
+/* Amount of data compared between checks of the abort flag */
+#define COMPARE_CHUNK_SIZE (1024 * 1024)
+
+/* Interval of progress updates in microseconds */
+#define COMPARE_UPDATE_INTERVAL (G_USEC_PER_SEC / 10)
+
 /*** file scope type declarations ****************************************************************/
 
 enum CompareMode
@@ -111,6 +120,28 @@ enum CompareMode
     compare_quick, compare_size_only, compare_thourough
 };
 
+/* Pair of files to compare byte by byte */
+typedef struct
+{
+    int index;                  /* index of the file in the panel */
+    vfs_path_t *src;
+    vfs_path_t *dst;
+    off_t size;
+    int result;                 /* result of compare_files() */
+} compare_job_t;
+
+/* Progress of the thorough comparison */
+typedef struct
+{
+    simple_status_msg_t status_msg;     /* base class */
+
+    int total;                  /* number of files to compare */
+    int done;                   /* number of compared files */
+    int different;              /* number of files found different */
+    volatile gint cancel;       /* set by main thread to stop the comparison */
+    GAsyncQueue *done_queue;    /* compared jobs */
+} compare_status_msg_t;
+
 /*** file scope variables ************************************************************************/
 
 #ifdef ENABLE_VFS_NET
@@ -204,9 +235,17 @@ set_panel_filter (WPanel * p)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare contents of two local files of the same size.
+ * Called from the threads of the compare pool, so it must not touch the UI.
+ *
+ * @param cancel flag to stop the comparison as soon as possible
+ * @return 0 if files are equal, non-zero if they differ or cannot be read
+ */
 
 static int
-compare_files (const vfs_path_t * vpath1, const vfs_path_t * vpath2, off_t size)
+compare_files (const vfs_path_t * vpath1, const vfs_path_t * vpath2, off_t size,
+               volatile gint * cancel)
 {
     int file1;
     int result = -1;            /* Different by default */
@@ -234,8 +273,14 @@ compare_files (const vfs_path_t * vpath1, const vfs_path_t * vpath2, off_t size)
                 data2 = mmap (0, size, PROT_READ, MAP_FILE | MAP_PRIVATE, file2, 0);
                 if (data2 != (char *) -1)
                 {
-                    rotate_dash (TRUE);
-                    result = memcmp (data1, data2, size);
+                    off_t offset;
+
+                    /* compare by chunks to be able to stop */
+                    for (offset = 0, result = 0;
+                         result == 0 && offset < size && g_atomic_int_get (cancel) == 0;
+                         offset += COMPARE_CHUNK_SIZE)
+                        result = memcmp (data1 + offset, data2 + offset,
+                                         (size_t) MIN (size - offset, COMPARE_CHUNK_SIZE));
                     munmap (data2, size);
                 }
                 munmap (data1, size);
@@ -244,20 +289,19 @@ compare_files (const vfs_path_t * vpath1, const vfs_path_t * vpath2, off_t size)
             /* Don't have mmap() :( Even more ugly :) */
             char buf1[BUFSIZ], buf2[BUFSIZ];
             int n1, n2;
-            rotate_dash (TRUE);
             do
             {
                 while ((n1 = read (file1, buf1, BUFSIZ)) == -1 && errno == EINTR);
                 while ((n2 = read (file2, buf2, BUFSIZ)) == -1 && errno == EINTR);
             }
-            while (n1 == n2 && n1 == BUFSIZ && !memcmp (buf1, buf2, BUFSIZ));
+            while (n1 == n2 && n1 == BUFSIZ && !memcmp (buf1, buf2, BUFSIZ)
+                   && g_atomic_int_get (cancel) == 0);
             result = (n1 != n2) || memcmp (buf1, buf2, n1);
 #endif /* !HAVE_MMAP */
             close (file2);
         }
         close (file1);
     }
-    rotate_dash (FALSE);
 
     return result;
 }
@@ -265,8 +309,123 @@ compare_files (const vfs_path_t * vpath1, const vfs_path_t * vpath2, off_t size)
 /* --------------------------------------------------------------------------------------------- */
 
 static void
+compare_job_free (compare_job_t * job)
+{
+    vfs_path_free (job->src);
+    vfs_path_free (job->dst);
+    g_free (job);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Thread pool function: compare files of the job and pass it back to the main thread */
+
+static void
+compare_job_run (gpointer data, gpointer user_data)
+{
+    compare_job_t *job = (compare_job_t *) data;
+    compare_status_msg_t *csm = (compare_status_msg_t *) user_data;
+
+    if (g_atomic_int_get (&csm->cancel) == 0)
+        job->result = compare_files (job->src, job->dst, job->size, &csm->cancel);
+
+    g_async_queue_push (csm->done_queue, job);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+compare_status_update_cb (status_msg_t * sm)
+{
+    simple_status_msg_t *ssm = SIMPLE_STATUS_MSG (sm);
+    compare_status_msg_t *csm = (compare_status_msg_t *) sm;
+
+    label_set_textv (ssm->label, _("Compared: %d of %d, different: %d"), csm->done, csm->total,
+                     csm->different);
+
+    return status_msg_common_update (sm);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare contents of files pairs on the thread pool and mark files which differ.
+ *
+ * @param jobs list of compare_job_t, is freed here
+ * @return FALSE if user has aborted the comparison, TRUE otherwise
+ */
+
+static gboolean
+compare_dir_contents (WPanel * panel, GPtrArray * jobs)
+{
+    compare_status_msg_t csm;
+    status_msg_t *sm = STATUS_MSG (&csm);
+    GThreadPool *pool;
+    gboolean aborted;
+    guint i;
+
+    csm.total = (int) jobs->len;
+    csm.done = 0;
+    csm.different = 0;
+    csm.cancel = 0;
+    csm.done_queue = g_async_queue_new ();
+
+    status_msg_init (sm, _("Compare directories"), 1.0, simple_status_msg_init_cb,
+                     compare_status_update_cb, NULL);
+
+    pool = g_thread_pool_new (compare_job_run, &csm, COMPARE_THREADS, TRUE, NULL);
+
+    for (i = 0; i < jobs->len; i++)
+        if (pool != NULL)
+            g_thread_pool_push (pool, g_ptr_array_index (jobs, i), NULL);
+        else
+            compare_job_run (g_ptr_array_index (jobs, i), &csm);
+
+    /* results come in any order, the pool is drained even if user has aborted the comparison */
+    while (csm.done < csm.total)
+    {
+        compare_job_t *job;
+
+        job = (compare_job_t *) g_async_queue_timeout_pop (csm.done_queue,
+                                                           COMPARE_UPDATE_INTERVAL);
+        if (job != NULL)
+        {
+            csm.done++;
+            if (job->result != 0 && g_atomic_int_get (&csm.cancel) == 0)
+            {
+                do_file_mark (panel, job->index, 1);
+                csm.different++;
+            }
+            compare_job_free (job);
+        }
+
+        if (g_atomic_int_get (&csm.cancel) == 0 && sm->update (sm) == B_CANCEL)
+            g_atomic_int_set (&csm.cancel, 1);
+    }
+
+    if (pool != NULL)
+        g_thread_pool_free (pool, FALSE, TRUE);
+
+    aborted = g_atomic_int_get (&csm.cancel) != 0;
+
+    status_msg_deinit (sm);
+    g_async_queue_unref (csm.done_queue);
+    g_ptr_array_free (jobs, TRUE);
+
+    return !aborted;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Mark files of the panel which are missing in the other panel or differ from their
+ * counterparts there.
+ *
+ * @return FALSE if user has aborted the comparison, TRUE otherwise
+ */
+
+static gboolean
 compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
 {
+    GHashTable *other_names;
+    GPtrArray *jobs = NULL;
     int i, j;
 
     /* No marks by default */
@@ -274,10 +433,20 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
     panel->total = 0;
     panel->dirs_marked = 0;
 
+    /* Index entries of the other panel by name, the first one wins */
+    other_names = g_hash_table_new (g_str_hash, g_str_equal);
+    for (j = 0; j < other->dir.len; j++)
+        if (!g_hash_table_lookup_extended (other_names, other->dir.list[j].fname, NULL, NULL))
+            g_hash_table_insert (other_names, other->dir.list[j].fname, GINT_TO_POINTER (j));
+
+    if (mode == compare_thourough)
+        jobs = g_ptr_array_new ();
+
     /* Handle all files in the panel */
     for (i = 0; i < panel->dir.len; i++)
     {
         file_entry_t *source = &panel->dir.list[i];
+        gpointer value;
 
         /* Default: unmarked */
         file_mark (panel, i, 0);
@@ -287,18 +456,14 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
             continue;
 
         /* Search the corresponding entry from the other panel */
-        for (j = 0; j < other->dir.len; j++)
-        {
-            if (strcmp (source->fname, other->dir.list[j].fname) == 0)
-                break;
-        }
-        if (j >= other->dir.len)
+        if (!g_hash_table_lookup_extended (other_names, source->fname, NULL, &value))
             /* Not found -> mark */
             do_file_mark (panel, i, 1);
         else
         {
             /* Found */
-            file_entry_t *target = &other->dir.list[j];
+            file_entry_t *target = &other->dir.list[GPOINTER_TO_INT (value)];
+            compare_job_t *job;
 
             if (mode != compare_size_only)
             {
@@ -328,19 +493,20 @@ compare_dir (WPanel * panel, WPanel * other, enum CompareMode mode)
                 continue;
             }
 
-            /* Thorough compare on, do byte-by-byte comparison */
-            {
-                vfs_path_t *src_name, *dst_name;
-
-                src_name = vfs_path_append_new (panel->cwd_vpath, source->fname, NULL);
-                dst_name = vfs_path_append_new (other->cwd_vpath, target->fname, NULL);
-                if (compare_files (src_name, dst_name, source->st.st_size))
-                    do_file_mark (panel, i, 1);
-                vfs_path_free (src_name);
-                vfs_path_free (dst_name);
-            }
+            /* Thorough compare on, do byte-by-byte comparison later */
+            job = g_new (compare_job_t, 1);
+            job->index = i;
+            job->src = vfs_path_append_new (panel->cwd_vpath, source->fname, NULL);
+            job->dst = vfs_path_append_new (other->cwd_vpath, target->fname, NULL);
+            job->size = source->st.st_size;
+            job->result = -1;
+            g_ptr_array_add (jobs, job);
         }
     }                           /* for (i ...) */
+
+    g_hash_table_destroy (other_names);
+
+    return (jobs == NULL || compare_dir_contents (panel, jobs));
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1168,8 +1334,8 @@ compare_dirs_cmd (void)
 
     if (get_current_type () == view_listing && get_other_type () == view_listing)
     {
-        compare_dir (current_panel, other_panel, thorough_flag);
-        compare_dir (other_panel, current_panel, thorough_flag);
+        if (compare_dir (current_panel, other_panel, thorough_flag))
+            compare_dir (other_panel, current_panel, thorough_flag);
     }
     else
     {
@@ -30,12 +30,17 @@
 
 #include <config.h>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "lib/global.h"
+#include "lib/logging.h"        /* mc_log() */
+#include "lib/timer.h"
 #include "lib/tty/tty.h"
 #include "lib/search.h"
 #include "lib/vfs/vfs.h"
@@ -44,7 +49,7 @@
 #include "lib/util.h"
 #include "lib/widget.h"         /* message() */
 
-#include "src/setup.h"          /* panels_options */
+#include "src/setup.h"          /* panels_options, dir_stat_threads, dir_sort_threads */
 
 #include "treestore.h"
 #include "dir.h"
@@ -59,8 +64,63 @@
         ? 1 \
         : ( (S_ISDIR (x->st.st_mode) || x->f.link_to_dir) ? 2 : 0) )
 
+/* Number of directory entries handled by one task of the stat thread pool */
+#define DIR_PREFETCH_BATCH 64
+
+/* Runs of this length and shorter are sorted by insertion */
+#define DIR_SORT_INSERTION_MAX 16
+
+/* Lists shorter than this are sorted without threads */
+#define DIR_SORT_PARALLEL_MIN 16384
+
 /*** file scope type declarations ****************************************************************/
 
+/* Directory entry which is stat()ed by the thread pool */
+typedef struct
+{
+    char *fname;
+    struct stat st;
+    gboolean link_to_dir;
+    gboolean stale_link;
+} dir_prefetch_entry_t;
+
+typedef struct
+{
+    int len;
+    dir_prefetch_entry_t entries[DIR_PREFETCH_BATCH];
+} dir_prefetch_batch_t;
+
+/* Panel filter compiled once per directory load */
+typedef struct
+{
+    mc_search_t *search;        /* compiled pattern if it isn't simple, NULL otherwise */
+    /* simple pattern: "head", "head*tail" or "*inner*" */
+    char *head;
+    size_t head_len;
+    char *tail;
+    size_t tail_len;
+    gboolean has_star;
+    gboolean inner;
+} dir_filter_t;
+
+/* Task of the sort thread pool */
+typedef struct
+{
+    file_entry_t **items;       /* part of the sorted array of entry pointers */
+    file_entry_t **tmp;         /* scratch space of the same length */
+    size_t len;
+    size_t half;                /* 0 to sort items, length of the first run to merge otherwise */
+} dir_sort_task_t;
+
+/* State of the parallel stat() of local directory entries */
+typedef struct
+{
+    int dir_fd;                 /* descriptor of the directory being loaded */
+    GThreadPool *pool;          /* created when the first batch is full */
+    GPtrArray *batches;         /* list of dir_prefetch_batch_t in readdir() order */
+    dir_prefetch_batch_t *current;      /* batch being filled */
+} dir_prefetch_t;
+
 /*** file scope variables ************************************************************************/
 
 /* Reverse flag */
@@ -139,6 +199,141 @@ clean_sort_keys (dir_list * list, int start, int count)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Prepare panel filter for matching of many file names.
+ * Patterns like "*.ext", "prefix*", "pre*suf" and "*part*" are matched
+ * without regular expressions.
+ *
+ * @param filter structure to initialize
+ * @param fltr shell pattern, may be NULL
+ * @return pointer to initialized filter or NULL if fltr is NULL
+ */
+
+static dir_filter_t *
+dir_filter_init (dir_filter_t * filter, const char *fltr)
+{
+    const char *star;
+
+    if (fltr == NULL)
+        return NULL;
+
+    memset (filter, 0, sizeof (*filter));
+
+    /* characters having special meaning in shell pattern (see lib/search/glob.c) */
+    if (strpbrk (fltr, "?[]{}\\|") == NULL)
+    {
+        size_t len;
+
+        len = strlen (fltr);
+        star = strchr (fltr, '*');
+
+        if (star == NULL)
+        {
+            filter->head = g_strdup (fltr);
+            filter->head_len = len;
+            return filter;
+        }
+
+        if (strchr (star + 1, '*') == NULL)
+        {
+            filter->has_star = TRUE;
+            filter->head_len = star - fltr;
+            filter->head = g_strndup (fltr, filter->head_len);
+            filter->tail = g_strdup (star + 1);
+            filter->tail_len = strlen (filter->tail);
+            return filter;
+        }
+
+        if (star == fltr && len > 1 && fltr[len - 1] == '*'
+            && memchr (fltr + 1, '*', len - 2) == NULL)
+        {
+            filter->has_star = TRUE;
+            filter->inner = TRUE;
+            filter->head = g_strndup (fltr + 1, len - 2);
+            filter->head_len = len - 2;
+            return filter;
+        }
+    }
+
+    filter->search = mc_search_new (fltr, -1, NULL);
+    if (filter->search != NULL)
+    {
+        filter->search->search_type = MC_SEARCH_T_GLOB;
+        filter->search->is_case_sensitive = TRUE;
+        filter->search->is_entire_line = TRUE;
+    }
+
+    return filter;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_filter_deinit (dir_filter_t * filter)
+{
+    if (filter == NULL)
+        return;
+
+    mc_search_free (filter->search);
+    g_free (filter->head);
+    g_free (filter->tail);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+dir_filter_match (const dir_filter_t * filter, const char *fname)
+{
+    size_t len;
+
+    if (filter->search != NULL)
+        return mc_search_run (filter->search, fname, 0, strlen (fname), NULL);
+
+    if (filter->inner)
+        return strstr (fname, filter->head) != NULL;
+
+    len = strlen (fname);
+
+    if (!filter->has_star)
+        return len == filter->head_len && memcmp (fname, filter->head, len) == 0;
+
+    return len >= filter->head_len + filter->tail_len
+        && strncmp (fname, filter->head, filter->head_len) == 0
+        && memcmp (fname + len - filter->tail_len, filter->tail, filter->tail_len) == 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether directory entry is hidden regardless of its type.
+ */
+
+static gboolean
+dir_entry_is_hidden (const char *fname)
+{
+    if (DIR_IS_DOT (fname) || DIR_IS_DOTDOT (fname))
+        return TRUE;
+    if (!panels_options.show_dot_files && (fname[0] == '.'))
+        return TRUE;
+    if (!panels_options.show_backups && fname[strlen (fname) - 1] == '~')
+        return TRUE;
+
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether stat()ed directory entry passes panel filter. Directories are never filtered out.
+ */
+
+static gboolean
+dir_entry_match_filter (const char *fname, const struct stat *st, gboolean link_to_dir,
+                        const dir_filter_t * filter)
+{
+    return (S_ISDIR (st->st_mode) || link_to_dir || filter == NULL
+            || dir_filter_match (filter, fname));
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * If you change handle_dirent then check also handle_path.
@@ -146,16 +341,12 @@ clean_sort_keys (dir_list * list, int start, int count)
  */
 
 static gboolean
-handle_dirent (struct dirent *dp, const char *fltr, struct stat *buf1, int *link_to_dir,
-               int *stale_link)
+handle_dirent (struct dirent *dp, const dir_filter_t * filter, struct stat *buf1,
+               int *link_to_dir, int *stale_link)
 {
     vfs_path_t *vpath;
 
-    if (DIR_IS_DOT (dp->d_name) || DIR_IS_DOTDOT (dp->d_name))
-        return FALSE;
-    if (!panels_options.show_dot_files && (dp->d_name[0] == '.'))
-        return FALSE;
-    if (!panels_options.show_backups && dp->d_name[strlen (dp->d_name) - 1] == '~')
+    if (dir_entry_is_hidden (dp->d_name))
         return FALSE;
 
     vpath = vfs_path_from_str (dp->d_name);
@@ -187,8 +378,233 @@ handle_dirent (struct dirent *dp, const char *fltr, struct stat *buf1, int *link
 
     vfs_path_free (vpath);
 
-    return (S_ISDIR (buf1->st_mode) || *link_to_dir != 0 || fltr == NULL
-            || mc_search (fltr, NULL, dp->d_name, MC_SEARCH_T_GLOB));
+    return dir_entry_match_filter (dp->d_name, buf1, *link_to_dir != 0, filter);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Thread pool function: stat() entries of one batch relative to the directory descriptor.
+ * Only system calls are made here, nothing of mc internals is touched.
+ */
+
+static void
+dir_prefetch_stat_batch (gpointer data, gpointer user_data)
+{
+    dir_prefetch_batch_t *batch = (dir_prefetch_batch_t *) data;
+    int dir_fd = GPOINTER_TO_INT (user_data);
+    int i;
+
+    for (i = 0; i < batch->len; i++)
+    {
+        dir_prefetch_entry_t *e = &batch->entries[i];
+
+#ifdef HAVE_FSTATAT
+        if (fstatat (dir_fd, e->fname, &e->st, AT_SYMLINK_NOFOLLOW) == -1)
+            memset (&e->st, 0, sizeof (e->st));
+
+        e->link_to_dir = FALSE;
+        e->stale_link = FALSE;
+        if (S_ISLNK (e->st.st_mode))
+        {
+            struct stat st2;
+
+            if (fstatat (dir_fd, e->fname, &st2, 0) == 0)
+                e->link_to_dir = S_ISDIR (st2.st_mode);
+            else
+                e->stale_link = TRUE;
+        }
+#else
+        (void) dir_fd;
+        memset (&e->st, 0, sizeof (e->st));
+#endif /* HAVE_FSTATAT */
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start parallel stat() of entries of local directory.
+ * @return FALSE if directory entries should be stat()ed serially through VFS
+ */
+
+static gboolean
+dir_prefetch_init (dir_prefetch_t * pf, const vfs_path_t * vpath)
+{
+#ifdef HAVE_FSTATAT
+    if (dir_stat_threads <= 0 || !vfs_file_is_local (vpath))
+        return FALSE;
+
+    pf->dir_fd = open (vfs_path_get_by_index (vpath, -1)->path, O_RDONLY);
+    if (pf->dir_fd == -1)
+        return FALSE;
+
+    pf->pool = NULL;
+    pf->batches = g_ptr_array_new ();
+    pf->current = NULL;
+
+    return TRUE;
+#else
+    (void) pf;
+    (void) vpath;
+
+    return FALSE;
+#endif /* HAVE_FSTATAT */
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_prefetch_push (dir_prefetch_t * pf)
+{
+    if (pf->pool == NULL)
+        pf->pool = g_thread_pool_new (dir_prefetch_stat_batch, GINT_TO_POINTER (pf->dir_fd),
+                                      dir_stat_threads, FALSE, NULL);
+
+    if (pf->pool != NULL)
+        g_thread_pool_push (pf->pool, pf->current, NULL);
+    else
+        dir_prefetch_stat_batch (pf->current, GINT_TO_POINTER (pf->dir_fd));
+
+    pf->current = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Queue directory entry to stat(). Full batches are handled by thread pool
+ * while directory is being read further.
+ */
+
+static void
+dir_prefetch_add (dir_prefetch_t * pf, const char *fname)
+{
+    if (pf->current == NULL)
+    {
+        pf->current = g_new (dir_prefetch_batch_t, 1);
+        pf->current->len = 0;
+        g_ptr_array_add (pf->batches, pf->current);
+    }
+
+    pf->current->entries[pf->current->len++].fname = g_strdup (fname);
+
+    if (pf->current->len == DIR_PREFETCH_BATCH)
+        dir_prefetch_push (pf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait for all stat() calls to finish. Small directories which don't fill
+ * the first batch are stat()ed in the current thread.
+ */
+
+static void
+dir_prefetch_wait (dir_prefetch_t * pf)
+{
+    if (pf->current != NULL)
+    {
+        if (pf->pool != NULL)
+            dir_prefetch_push (pf);
+        else
+        {
+            dir_prefetch_stat_batch (pf->current, GINT_TO_POINTER (pf->dir_fd));
+            pf->current = NULL;
+        }
+    }
+
+    if (pf->pool != NULL)
+    {
+        g_thread_pool_free (pf->pool, FALSE, TRUE);
+        pf->pool = NULL;
+    }
+
+    close (pf->dir_fd);
+    pf->dir_fd = -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_prefetch_free (dir_prefetch_t * pf)
+{
+    guint i;
+
+    for (i = 0; i < pf->batches->len; i++)
+    {
+        dir_prefetch_batch_t *batch;
+        int j;
+
+        batch = (dir_prefetch_batch_t *) g_ptr_array_index (pf->batches, i);
+        for (j = 0; j < batch->len; j++)
+            g_free (batch->entries[j].fname);
+        g_free (batch);
+    }
+
+    g_ptr_array_free (pf->batches, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Restore mark of reloaded file if it was marked before reload.
+ */
+
+static void
+dir_list_restore_mark (dir_list * list, GHashTable * marked_files, int *marked_cnt)
+{
+    file_entry_t *fentry;
+
+    fentry = &list->list[list->len - 1];
+    fentry->f.marked = 0;
+
+    /*
+     * If we have marked files in the copy, scan through the copy
+     * to find matching file.  Decrease number of remaining marks if
+     * we copied one.
+     */
+    if (*marked_cnt > 0 && g_hash_table_lookup (marked_files, fentry->fname) != NULL)
+    {
+        fentry->f.marked = 1;
+        (*marked_cnt)--;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Append stat()ed entries to the list in readdir() order.
+ *
+ * @param marked_files if not NULL, marks of reloaded files are restored
+ * @return FALSE if list cannot be enlarged
+ */
+
+static gboolean
+dir_prefetch_join (dir_prefetch_t * pf, dir_list * list, const dir_filter_t * filter,
+                   GHashTable * marked_files, int *marked_cnt)
+{
+    guint i;
+
+    for (i = 0; i < pf->batches->len; i++)
+    {
+        dir_prefetch_batch_t *batch;
+        int j;
+
+        batch = (dir_prefetch_batch_t *) g_ptr_array_index (pf->batches, i);
+
+        for (j = 0; j < batch->len; j++)
+        {
+            dir_prefetch_entry_t *e = &batch->entries[j];
+
+            if (S_ISDIR (e->st.st_mode))
+                tree_store_mark_checked (e->fname);
+
+            if (!dir_entry_match_filter (e->fname, &e->st, e->link_to_dir, filter))
+                continue;
+
+            if (!dir_list_append (list, e->fname, &e->st, e->link_to_dir, e->stale_link))
+                return FALSE;
+
+            if (marked_files != NULL)
+                dir_list_restore_mark (list, marked_files, marked_cnt);
+        }
+    }
+
+    return TRUE;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -244,6 +660,187 @@ alloc_dir_copy (int size)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create collation keys of entries before sorting.  Comparison functions create missing keys
+ * themselves, but doing it once per entry keeps them free of side effects, so that parts of
+ * the list can be sorted in parallel.
+ */
+
+static void
+dir_sort_create_keys (dir_list * list, int start, int count, GCompareFunc sort)
+{
+    int i;
+
+    /* these don't compare file names by keys */
+    if (sort == (GCompareFunc) sort_vers || sort == (GCompareFunc) sort_inode)
+        return;
+
+    for (i = start; i < start + count; i++)
+    {
+        file_entry_t *fentry = &list->list[i];
+
+        if (fentry->sort_key == NULL)
+            fentry->sort_key = str_create_key_for_filename (fentry->fname, case_sensitive);
+        if (sort == (GCompareFunc) sort_ext && fentry->second_sort_key == NULL)
+            fentry->second_sort_key = str_create_key (extension (fentry->fname), case_sensitive);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Merge two sorted runs items[0, half) and items[half, len) in place.
+ * Entries of the first run go first if they are equal, so sorting is stable.
+ */
+
+static void
+dir_sort_merge (file_entry_t ** items, file_entry_t ** tmp, size_t len, size_t half,
+                GCompareFunc sort)
+{
+    file_entry_t **a, **a_end, **b, **b_end;
+
+    /* runs are already in order */
+    if (sort (items[half - 1], items[half]) <= 0)
+        return;
+
+    memcpy (tmp, items, len * sizeof (file_entry_t *));
+
+    a = tmp;
+    a_end = tmp + half;
+    b = a_end;
+    b_end = tmp + len;
+
+    while (a < a_end && b < b_end)
+        *items++ = sort (*b, *a) < 0 ? *b++ : *a++;
+
+    while (a < a_end)
+        *items++ = *a++;
+    while (b < b_end)
+        *items++ = *b++;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Stable merge sort of array of entry pointers */
+
+static void
+dir_sort_range (file_entry_t ** items, file_entry_t ** tmp, size_t len, GCompareFunc sort)
+{
+    size_t half;
+
+    if (len <= DIR_SORT_INSERTION_MAX)
+    {
+        size_t i;
+
+        for (i = 1; i < len; i++)
+        {
+            file_entry_t *item = items[i];
+            size_t j;
+
+            for (j = i; j > 0 && sort (item, items[j - 1]) < 0; j--)
+                items[j] = items[j - 1];
+            items[j] = item;
+        }
+
+        return;
+    }
+
+    half = len / 2;
+    dir_sort_range (items, tmp, half, sort);
+    dir_sort_range (items + half, tmp + half, len - half, sort);
+    dir_sort_merge (items, tmp, len, half, sort);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_sort_task_run (gpointer data, gpointer user_data)
+{
+    dir_sort_task_t *task = (dir_sort_task_t *) data;
+    GCompareFunc sort = (GCompareFunc) user_data;
+
+    if (task->half == 0)
+        dir_sort_range (task->items, task->tmp, task->len, sort);
+    else
+        dir_sort_merge (task->items, task->tmp, task->len, task->half, sort);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Run independent sort tasks in a thread pool and wait for them.
+ * If the pool cannot be created, tasks are run in the current thread.
+ */
+
+static void
+dir_sort_tasks_run (dir_sort_task_t * tasks, size_t count, GCompareFunc sort)
+{
+    GThreadPool *pool;
+    size_t i;
+
+    pool = g_thread_pool_new (dir_sort_task_run, (gpointer) sort, (gint) count, TRUE, NULL);
+
+    for (i = 0; i < count; i++)
+        if (pool != NULL)
+            g_thread_pool_push (pool, &tasks[i], NULL);
+        else
+            dir_sort_task_run (&tasks[i], (gpointer) sort);
+
+    if (pool != NULL)
+        g_thread_pool_free (pool, FALSE, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Sort array of entry pointers using several threads.  The array is split into @threads runs
+ * which are sorted in parallel, then neighbour runs are merged pairwise, also in parallel,
+ * until a single run is left.
+ */
+
+static void
+dir_sort_parallel (file_entry_t ** items, file_entry_t ** tmp, size_t len, GCompareFunc sort,
+                   size_t threads)
+{
+    dir_sort_task_t *tasks;
+    size_t *bounds;
+    size_t i, width;
+
+    bounds = g_new (size_t, threads + 1);
+    tasks = g_new (dir_sort_task_t, threads);
+
+    for (i = 0; i <= threads; i++)
+        bounds[i] = len * i / threads;
+
+    for (i = 0; i < threads; i++)
+    {
+        tasks[i].items = items + bounds[i];
+        tasks[i].tmp = tmp + bounds[i];
+        tasks[i].len = bounds[i + 1] - bounds[i];
+        tasks[i].half = 0;
+    }
+
+    dir_sort_tasks_run (tasks, threads, sort);
+
+    for (width = 1; width < threads; width *= 2)
+    {
+        size_t count = 0;
+
+        for (i = 0; i + width < threads; i += 2 * width)
+        {
+            size_t end = MIN (i + 2 * width, threads);
+
+            tasks[count].items = items + bounds[i];
+            tasks[count].tmp = tmp + bounds[i];
+            tasks[count].len = bounds[end] - bounds[i];
+            tasks[count].half = bounds[i + width] - bounds[i];
+            count++;
+        }
+
+        dir_sort_tasks_run (tasks, count, sort);
+    }
+
+    g_free (tasks);
+    g_free (bounds);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -506,7 +1103,10 @@ void
 dir_list_sort (dir_list * list, GCompareFunc sort, const dir_sort_options_t * sort_op)
 {
     file_entry_t *fentry;
+    file_entry_t *entries, **items, **tmp;
     int dot_dot_found = 0;
+    int count, i;
+    size_t threads;
 
     if (list->len < 2 || sort == (GCompareFunc) unsorted)
         return;
@@ -520,9 +1120,33 @@ dir_list_sort (dir_list * list, GCompareFunc sort, const dir_sort_options_t * so
     reverse = sort_op->reverse ? -1 : 1;
     case_sensitive = sort_op->case_sensitive ? 1 : 0;
     exec_first = sort_op->exec_first;
-    qsort (&(list->list)[dot_dot_found], list->len - dot_dot_found, sizeof (file_entry_t), sort);
 
-    clean_sort_keys (list, dot_dot_found, list->len - dot_dot_found);
+    count = list->len - dot_dot_found;
+    dir_sort_create_keys (list, dot_dot_found, count, sort);
+
+    /* sort pointers rather than moving whole entries on every step */
+    entries = g_new (file_entry_t, count);
+    memcpy (entries, &list->list[dot_dot_found], count * sizeof (file_entry_t));
+    items = g_new (file_entry_t *, count);
+    tmp = g_new (file_entry_t *, count);
+    for (i = 0; i < count; i++)
+        items[i] = &entries[i];
+
+    threads = dir_sort_threads > 0 ? (size_t) dir_sort_threads : 0;
+    threads = MIN (threads, (size_t) count / (DIR_SORT_PARALLEL_MIN / 2));
+    if (count >= DIR_SORT_PARALLEL_MIN && threads > 1)
+        dir_sort_parallel (items, tmp, count, sort, threads);
+    else
+        dir_sort_range (items, tmp, count, sort);
+
+    for (i = 0; i < count; i++)
+        list->list[dot_dot_found + i] = *items[i];
+
+    g_free (tmp);
+    g_free (items);
+    g_free (entries);
+
+    clean_sort_keys (list, dot_dot_found, count);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -630,6 +1254,13 @@ dir_list_load (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
     struct stat st;
     file_entry_t *fentry;
     const char *vpath_str;
+    dir_filter_t filter_buf;
+    dir_filter_t *filter;
+    dir_prefetch_t pf;
+    gboolean prefetch;
+    guint64 start_time;
+
+    start_time = mc_timer_elapsed (mc_global.timer);
 
     /* ".." (if any) must be the first entry in the list */
     if (!dir_list_init (list))
@@ -653,9 +1284,19 @@ dir_list_load (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
     if (IS_PATH_SEP (vpath_str[0]) && vpath_str[1] == '\0')
         dir_list_clean (list);
 
+    filter = dir_filter_init (&filter_buf, fltr);
+    prefetch = dir_prefetch_init (&pf, vpath);
+
     while ((dp = mc_readdir (dirp)) != NULL)
     {
-        if (!handle_dirent (dp, fltr, &st, &link_to_dir, &stale_link))
+        if (prefetch)
+        {
+            if (!dir_entry_is_hidden (dp->d_name))
+                dir_prefetch_add (&pf, dp->d_name);
+            continue;
+        }
+
+        if (!handle_dirent (dp, filter, &st, &link_to_dir, &stale_link))
             continue;
 
         if (!dir_list_append (list, dp->d_name, &st, link_to_dir != 0, stale_link != 0))
@@ -665,12 +1306,27 @@ dir_list_load (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
             rotate_dash (TRUE);
     }
 
+    if (prefetch)
+    {
+        gboolean ok;
+
+        dir_prefetch_wait (&pf);
+        ok = dir_prefetch_join (&pf, list, filter, NULL, NULL);
+        dir_prefetch_free (&pf);
+        if (!ok)
+            goto ret;
+    }
+
     dir_list_sort (list, sort, sort_op);
 
   ret:
+    dir_filter_deinit (filter);
     mc_closedir (dirp);
     tree_store_end_check ();
     rotate_dash (FALSE);
+
+    mc_log ("dir_list_load: %s: %d entries in %" G_GUINT64_FORMAT " us\n", vpath_str, list->len,
+            mc_timer_elapsed (mc_global.timer) - start_time);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -699,6 +1355,13 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
     int marked_cnt;
     GHashTable *marked_files;
     const char *tmp_path;
+    dir_filter_t filter_buf;
+    dir_filter_t *filter;
+    dir_prefetch_t pf;
+    gboolean prefetch;
+    guint64 start_time;
+
+    start_time = mc_timer_elapsed (mc_global.timer);
 
     dirp = mc_opendir (vpath);
     if (dirp == NULL)
@@ -764,11 +1427,19 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
         }
     }
 
+    filter = dir_filter_init (&filter_buf, fltr);
+    prefetch = dir_prefetch_init (&pf, vpath);
+
     while ((dp = mc_readdir (dirp)) != NULL)
     {
-        file_entry_t *fentry;
+        if (prefetch)
+        {
+            if (!dir_entry_is_hidden (dp->d_name))
+                dir_prefetch_add (&pf, dp->d_name);
+            continue;
+        }
 
-        if (!handle_dirent (dp, fltr, &st, &link_to_dir, &stale_link))
+        if (!handle_dirent (dp, filter, &st, &link_to_dir, &stale_link))
             continue;
 
         if (!dir_list_append (list, dp->d_name, &st, link_to_dir != 0, stale_link != 0))
@@ -786,34 +1457,46 @@ dir_list_reload (dir_list * list, const vfs_path_t * vpath, GCompareFunc sort,
              */
             tree_store_end_check ();
             g_hash_table_destroy (marked_files);
+            dir_filter_deinit (filter);
             return;
         }
-        fentry = &list->list[list->len - 1];
 
-        fentry->f.marked = 0;
-
-        /*
-         * If we have marked files in the copy, scan through the copy
-         * to find matching file.  Decrease number of remaining marks if
-         * we copied one.
-         */
-        if (marked_cnt > 0 && g_hash_table_lookup (marked_files, dp->d_name) != NULL)
-        {
-            fentry->f.marked = 1;
-            marked_cnt--;
-        }
+        dir_list_restore_mark (list, marked_files, &marked_cnt);
 
         if ((list->len & 15) == 0)
             rotate_dash (TRUE);
     }
+
+    if (prefetch)
+    {
+        gboolean ok;
+
+        dir_prefetch_wait (&pf);
+        ok = dir_prefetch_join (&pf, list, filter, marked_files, &marked_cnt);
+        dir_prefetch_free (&pf);
+        if (!ok)
+        {
+            /* see the comment about memory leak above */
+            mc_closedir (dirp);
+            tree_store_end_check ();
+            g_hash_table_destroy (marked_files);
+            dir_filter_deinit (filter);
+            return;
+        }
+    }
+
     mc_closedir (dirp);
     tree_store_end_check ();
     g_hash_table_destroy (marked_files);
+    dir_filter_deinit (filter);
 
     dir_list_sort (list, sort, sort_op);
 
     dir_list_clean (&dir_copy);
     rotate_dash (FALSE);
+
+    mc_log ("dir_list_reload: %s: %d entries in %" G_GUINT64_FORMAT " us\n",
+            vfs_path_as_str (vpath), list->len, mc_timer_elapsed (mc_global.timer) - start_time);
 }
 
 /* --------------------------------------------------------------------------------------------- */
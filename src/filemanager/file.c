@@ -104,6 +104,13 @@ const char *op_names[3] = {
 #define FILEOP_UPDATE_INTERVAL 2
 #define FILEOP_STALLING_INTERVAL 4
 
+/* Limits of the adaptive copy buffer */
+#define FILEOP_COPY_BUF_MIN BUF_8K
+#define FILEOP_COPY_BUF_MAX (4 * 1024 * 1024)
+
+/* Number of marked files fetched by one VFS_SETCTL_PREFETCH request */
+#define FILEOP_PREFETCH_FILES 64
+
 /*** file scope type declarations ****************************************************************/
 
 /* This is a hard link cache */
@@ -1369,6 +1376,59 @@ panel_operate_init_totals (const WPanel * panel, const char *source, file_op_con
     return status;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Let the VFS of the panel fetch the next files of the operation at once before they are read,
+ * e.g. extfs extracts them from the archive with one run of the helper.
+ *
+ * Marked files are fetched in batches of FILEOP_PREFETCH_FILES from the progress loop, so the
+ * dialog is updated and the operation can be aborted between runs, and files behind an abort
+ * are not extracted at all.
+ *
+ * @param ctx file operation context with the progress dialog
+ * @param panel source panel
+ * @param source the only file of the operation or NULL to fetch marked files
+ * @param first index of the first marked file to fetch
+ *
+ * @return index of the first marked file which is not fetched yet
+ */
+
+static int
+panel_operate_prefetch (file_op_context_t * ctx, const WPanel * panel, const char *source,
+                        int first)
+{
+    GPtrArray *names;
+    int i;
+
+    if (panel->is_panelized || vfs_file_is_local (panel->cwd_vpath))
+        return panel->dir.len;
+
+    names = g_ptr_array_new ();
+
+    if (source != NULL)
+    {
+        g_ptr_array_add (names, (gpointer) source);
+        i = panel->dir.len;
+    }
+    else
+        for (i = first; i < panel->dir.len && names->len < FILEOP_PREFETCH_FILES; i++)
+            if (panel->dir.list[i].f.marked)
+                g_ptr_array_add (names, panel->dir.list[i].fname);
+
+    if (names->len != 0)
+    {
+        file_progress_show_source (ctx, panel->cwd_vpath);
+        file_progress_show_target (ctx, NULL);
+        mc_refresh ();
+
+        mc_setctl (panel->cwd_vpath, VFS_SETCTL_PREFETCH, names);
+    }
+
+    g_ptr_array_free (names, TRUE);
+
+    return i;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Generate user prompt for panel operation.
@@ -1488,7 +1548,7 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
     mode_t src_mode = 0;        /* The mode of the source file */
     struct stat sb, sb2;
     struct utimbuf utb;
-    gboolean dst_exists = FALSE, appending = FALSE;
+    gboolean dst_exists = FALSE, appending = FALSE, cloned = FALSE;
     off_t file_size = -1;
     FileProgressStatus return_status, temp_status;
     struct timeval tv_transfer_start;
@@ -1737,8 +1797,13 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
         goto ret;
     }
 
+    /* try to share data blocks of source file if both files are on the same local filesystem */
+    if (!appending && file_size > 0)
+        cloned = vfs_clone_local (src_desc, dest_desc) == 0;
+
     /* try preallocate space; if fail, try copy anyway */
-    while (vfs_preallocate (dest_desc, file_size, ctx->do_append != 0 ? sb.st_size : 0) != 0)
+    while (!cloned
+           && vfs_preallocate (dest_desc, file_size, ctx->do_append != 0 ? sb.st_size : 0) != 0)
     {
         if (ctx->skip_all)
         {
@@ -1790,26 +1855,50 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
         struct timeval tv_current, tv_last_update, tv_last_input;
         int secs, update_secs;
         const char *stalled_msg = "";
+        char *buf = NULL;
+        size_t buf_size = FILEOP_COPY_BUF_MIN;
+        gboolean kernel_copy;
 
         tv_last_update = tv_transfer_start;
 
-        while (TRUE)
-        {
-            char buf[BUF_8K];
+        /* if both files are local, let the kernel copy data without passing it through our buffer.
+           Files of pseudo filesystems like /proc have zero size and can be read only */
+        kernel_copy = !cloned && file_size > 0;
 
+        while (!cloned)
+        {
             /* src_read */
             if (mc_ctl (src_desc, VFS_CTL_IS_NOTREADY, 0))
                 n_read = -1;
-            else
-                while ((n_read = mc_read (src_desc, buf, sizeof (buf))) < 0 && !ctx->skip_all)
+            else if (kernel_copy
+                     && (n_read = vfs_copy_local_chunk (src_desc, dest_desc, buf_size)) < 0)
+            {
+                /* fall back to read/write which reports errors of each side separately */
+                kernel_copy = FALSE;
+                continue;
+            }
+            else if (kernel_copy && n_read == 0 && n_read_total + ctx->do_reget < file_size)
+            {
+                /* the kernel can't copy the rest, don't take it for the end of file */
+                kernel_copy = FALSE;
+                continue;
+            }
+            else if (!kernel_copy)
+            {
+                if (buf == NULL)
+                    buf = g_malloc (buf_size);
+
+                while ((n_read = mc_read (src_desc, buf, buf_size)) < 0 && !ctx->skip_all)
                 {
                     return_status = file_error (_("Cannot read source file\"%s\"\n%s"), src_path);
                     if (return_status == FILE_RETRY)
                         continue;
                     if (return_status == FILE_SKIPALL)
                         ctx->skip_all = TRUE;
+                    g_free (buf);
                     goto ret;
                 }
+            }
             if (n_read == 0)
                 break;
 
@@ -1829,7 +1918,7 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
                 gettimeofday (&tv_last_input, NULL);
 
                 /* dst_write */
-                while ((n_written = mc_write (dest_desc, t, n_read)) < n_read)
+                while (!kernel_copy && (n_written = mc_write (dest_desc, t, n_read)) < n_read)
                 {
                     gboolean write_errno_nospace;
 
@@ -1851,17 +1940,35 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
                     if (return_status == FILE_SKIP)
                     {
                         if (write_errno_nospace)
+                        {
+                            g_free (buf);
                             goto ret;
+                        }
                         break;
                     }
                     if (return_status == FILE_SKIPALL)
                     {
                         ctx->skip_all = TRUE;
                         if (write_errno_nospace)
+                        {
+                            g_free (buf);
                             goto ret;
+                        }
                     }
                     if (return_status != FILE_RETRY)
+                    {
+                        g_free (buf);
                         goto ret;
+                    }
+                }
+
+                /* large file: enlarge buffer to reduce number of syscalls and progress updates */
+                if ((size_t) n_read_total >= buf_size * 4 && buf_size < FILEOP_COPY_BUF_MAX
+                    && (off_t) buf_size < file_size / 16)
+                {
+                    buf_size *= 2;
+                    g_free (buf);
+                    buf = NULL;
                 }
             }
 
@@ -1906,9 +2013,18 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
             if (return_status != FILE_CONT)
             {
                 mc_refresh ();
+                g_free (buf);
                 goto ret;
             }
         }
+
+        g_free (buf);
+
+        if (cloned)
+        {
+            tctx->copied_bytes = tctx->progress_bytes + file_size;
+            file_progress_show (ctx, file_size, file_size, "", TRUE);
+        }
     }
 
     dst_status = DEST_FULL;     /* copy successful, don't remove target file */
@@ -1927,8 +2043,14 @@ copy_file_file (file_op_total_context_t * tctx, file_op_context_t * ctx,
         break;
     }
 
-    while (dest_desc != -1 && mc_close (dest_desc) < 0 && !ctx->skip_all)
+    while (dest_desc != -1 && mc_close (dest_desc) < 0)
     {
+        /* the file system may have failed to store data written behind */
+        if (dst_status == DEST_FULL)
+            dst_status = DEST_SHORT;
+        if (ctx->skip_all)
+            break;
+
         temp_status = file_error (_("Cannot close target file \"%s\"\n%s"), dst_path);
         if (temp_status == FILE_RETRY)
             continue;
@@ -2606,7 +2728,7 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
     char *save_cwd = NULL, *save_dest = NULL;
     struct stat src_stat;
     gboolean ret_val = TRUE;
-    int i;
+    int i, prefetched = 0;
     FileProgressStatus value;
     file_op_context_t *ctx;
     file_op_total_context_t *tctx;
@@ -2849,6 +2971,8 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
             }
             else
             {
+                panel_operate_prefetch (ctx, panel, source, 0);
+
                 temp = transform_source (ctx, source_with_vpath);
                 if (temp == NULL)
                     value = transform_error;
@@ -2939,6 +3063,9 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
                 if (!panel->dir.list[i].f.marked)
                     continue;   /* Skip the unmarked ones */
 
+                if (operation != OP_DELETE && i >= prefetched)
+                    prefetched = panel_operate_prefetch (ctx, panel, NULL, i);
+
                 source2 = panel->dir.list[i].fname;
                 src_stat = panel->dir.list[i].st;
 
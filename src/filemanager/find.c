@@ -32,11 +32,15 @@
 #include <config.h>
 
 #include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 #include "lib/global.h"
 
@@ -68,6 +72,19 @@
 #define MAX_REFRESH_INTERVAL (G_USEC_PER_SEC / 20)      /* 50 ms */
 #define MIN_REFRESH_FILE_SIZE (256 * 1024)      /* 256 KB */
 
+/* Number of threads searching contents of local files */
+#define FIND_THREADS 4
+/* Initial size of read buffer of a content search thread */
+#define FIND_BUFFER_SIZE (1024 * 1024)
+/* Maximum number of files waiting for the content search threads */
+#define FIND_QUEUE_MAX 1024
+/* Pause of suspended search threads */
+#define FIND_SUSPEND_SLEEP (G_USEC_PER_SEC / 20)        /* 50 ms */
+/* Time to wait for results of search threads on idle event */
+#define FIND_POLL_INTERVAL (G_USEC_PER_SEC / 50)        /* 20 ms */
+/* Maximum number of results shown on one idle event */
+#define FIND_RESULTS_PER_IDLE 64
+
 /*** file scope type declarations ****************************************************************/
 
 /* A couple of extra messages we need */
@@ -118,6 +135,45 @@ typedef struct
     gsize end;
 } find_match_location_t;
 
+typedef enum
+{
+    FIND_RESULT_MATCH = 0,
+    FIND_RESULT_STATUS,
+    FIND_RESULT_DONE
+} find_result_type_t;
+
+/* Message from search threads to the dialog */
+typedef struct
+{
+    find_result_type_t type;
+    char *dir;                  /* directory of found file or directory being read */
+    char *file;                 /* "line:name" of found file */
+    gsize start;
+    gsize end;
+} find_result_t;
+
+/* File which name matches, to be searched by content search threads */
+typedef struct
+{
+    char *dir;
+    char *name;
+} find_file_task_t;
+
+/* Content search in local directories: one thread reads directories, the thread pool
+   searches contents of files, the dialog shows results on idle events */
+typedef struct
+{
+    char *start_dir;
+    GThread *walker;            /* thread reading directories */
+    GThreadPool *pool;          /* threads searching contents of files */
+    GAsyncQueue *handles;       /* content search handles not used by any thread now */
+    GAsyncQueue *results;       /* find_result_t for the dialog */
+    mc_search_t *file_handle;   /* file name search handle of the walker */
+    size_t ignore_count;        /* number of ignored directories, updated by the walker */
+    volatile gint suspend;
+    volatile gint cancel;
+} find_engine_t;
+
 /*** file scope variables ************************************************************************/
 
 /* button callbacks */
@@ -216,6 +272,8 @@ static char *in_start_dir = INPUT_LAST_TEXT;
 static mc_search_t *search_file_handle = NULL;
 static mc_search_t *search_content_handle = NULL;
 
+static find_engine_t *find_engine = NULL;
+
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -1213,6 +1271,526 @@ find_rotate_dash (const WDialog * h, gboolean show)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static void
+find_search_finished (WDialog * h)
+{
+    running = FALSE;
+    if (ignore_count == 0)
+        status_update (_("Finished"));
+    else
+    {
+        char msg[BUF_SMALL];
+        g_snprintf (msg, sizeof (msg),
+                    ngettext ("Finished (ignored %zd directory)",
+                              "Finished (ignored %zd directories)", ignore_count), ignore_count);
+        status_update (msg);
+    }
+    find_rotate_dash (h, FALSE);
+    stop_idle (h);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static mc_search_t *
+find_content_search_new (void)
+{
+    mc_search_t *search;
+
+    search = mc_search_new (content_pattern, -1, NULL);
+    if (search != NULL)
+    {
+        search->search_type = options.content_regexp ? MC_SEARCH_T_REGEX : MC_SEARCH_T_NORMAL;
+        search->is_case_sensitive = options.content_case_sens;
+        search->whole_words = options.content_whole_words;
+#ifdef HAVE_CHARSET
+        search->is_all_charsets = options.content_all_charsets;
+#endif
+    }
+
+    return search;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static mc_search_t *
+find_file_search_new (void)
+{
+    mc_search_t *search;
+
+    search = mc_search_new (find_pattern, -1, NULL);
+    search->search_type = options.file_pattern ? MC_SEARCH_T_GLOB : MC_SEARCH_T_REGEX;
+    search->is_case_sensitive = options.file_case_sens;
+#ifdef HAVE_CHARSET
+    search->is_all_charsets = options.file_all_charsets;
+#endif
+    search->is_entire_line = options.file_pattern;
+
+    return search;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+find_result_free (find_result_t * res)
+{
+    g_free (res->dir);
+    g_free (res->file);
+    g_free (res);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Pass message from search threads to the dialog */
+
+static void
+find_engine_post (find_engine_t * fe, find_result_type_t type, const char *dir, char *file,
+                  gsize start, gsize end)
+{
+    find_result_t *res;
+
+    res = g_new (find_result_t, 1);
+    res->type = type;
+    res->dir = g_strdup (dir);
+    res->file = file;
+    res->start = start;
+    res->end = end;
+    g_async_queue_push (fe->results, res);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Block search thread while the search is suspended */
+
+static void
+find_engine_wait (find_engine_t * fe)
+{
+    while (g_atomic_int_get (&fe->suspend) != 0 && g_atomic_int_get (&fe->cancel) == 0)
+        g_usleep (FIND_SUSPEND_SLEEP);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Find end of line: first newline or zero character in [start, end) */
+
+static char *
+find_line_end (char *start, char *end)
+{
+    char *nl, *zero;
+
+    nl = memchr (start, '\n', end - start);
+    if (nl != NULL)
+        end = nl;
+
+    zero = memchr (start, '\0', end - start);
+
+    return (zero != NULL ? zero : end);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Search contents of local file in search thread.  Lines are searched in place in a large
+ * buffer, the same way as search_content() does: a zero byte splits a line, and a binary line
+ * is matched only once.
+ */
+
+static void
+find_engine_grep (find_engine_t * fe, mc_search_t * search, const char *dir, const char *name)
+{
+    char *path;
+    struct stat s;
+    int fd;
+    char *buf;
+    size_t size = FIND_BUFFER_SIZE;
+    size_t len = 0;             /* number of bytes in buf */
+    size_t pos = 0;             /* start of the current line in buf */
+    off_t off = 0;              /* file offset corresponding to buf[0] */
+    int line = 1;
+    gboolean found = FALSE;
+    gboolean eof = FALSE;
+
+    path = mc_build_filename (dir, name, (char *) NULL);
+    fd = (stat (path, &s) == 0 && S_ISREG (s.st_mode)) ? open (path, O_RDONLY) : -1;
+    g_free (path);
+
+    if (fd == -1)
+        return;
+
+    /* one more byte to terminate the line in place */
+    buf = g_malloc (size + 1);
+
+    while (g_atomic_int_get (&fe->cancel) == 0)
+    {
+        char *start, *end;
+
+        start = buf + pos;
+        end = find_line_end (start, buf + len);
+
+        if (end == buf + len && !eof)
+        {
+            /* line is incomplete: move it to the beginning of buffer and read more */
+            ssize_t n_read;
+
+            if (pos != 0)
+            {
+                memmove (buf, start, len - pos);
+                off += pos;
+                len -= pos;
+                pos = 0;
+            }
+            else if (len == size)
+            {
+                size *= 2;
+                buf = g_realloc (buf, size + 1);
+            }
+
+            find_engine_wait (fe);
+
+            while ((n_read = read (fd, buf + len, size - len)) == -1 && errno == EINTR)
+                ;
+            if (n_read <= 0)
+                eof = TRUE;
+            else
+                len += (size_t) n_read;
+            continue;
+        }
+
+        if (end == start)
+        {
+            if (end == buf + len)
+                break;
+
+            /* do not search in empty strings, skip possible leading zero(s) */
+            if (*end == '\n')
+            {
+                found = FALSE;
+                line++;
+            }
+            pos++;
+            continue;
+        }
+
+        /* Search in binary line once */
+        if (!found)
+        {
+            char term = *end;
+            gsize found_len;
+
+            *end = '\0';
+            if (mc_search_run (search, (const void *) start, 0, end - start, &found_len))
+            {
+                gsize found_start;
+
+                /* off by one: ticket 3280 */
+                found_start = off + pos + search->normal_offset + 1;
+                find_engine_post (fe, FIND_RESULT_MATCH, dir,
+                                  g_strdup_printf ("%d:%s", line, name), found_start,
+                                  found_start + found_len);
+                found = TRUE;
+            }
+            *end = term;
+        }
+
+        if (found && options.content_first_hit)
+            break;
+
+        if (end == buf + len)
+            pos = len;
+        else
+        {
+            if (*end == '\n')
+            {
+                found = FALSE;
+                line++;
+            }
+            pos = end - buf + 1;
+        }
+    }
+
+    g_free (buf);
+    close (fd);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Thread pool function: search contents of one file */
+
+static void
+find_engine_search_file (gpointer data, gpointer user_data)
+{
+    find_file_task_t *task = (find_file_task_t *) data;
+    find_engine_t *fe = (find_engine_t *) user_data;
+
+    if (g_atomic_int_get (&fe->cancel) == 0)
+    {
+        mc_search_t *search;
+
+        /* handles aren't thread safe, borrow one which isn't used by other threads */
+        search = (mc_search_t *) g_async_queue_pop (fe->handles);
+        find_engine_grep (fe, search, task->dir, task->name);
+        g_async_queue_push (fe->handles, search);
+    }
+
+    g_free (task->dir);
+    g_free (task->name);
+    g_free (task);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Directory walker thread.  Reads directories in the same order as do_search() does and
+ * passes files with matching names to the content search threads.
+ */
+
+static gpointer
+find_engine_walk (gpointer data)
+{
+    find_engine_t *fe = (find_engine_t *) data;
+    GQueue dirs = G_QUEUE_INIT;
+    char *directory;
+
+    g_queue_push_head (&dirs, g_strdup (fe->start_dir));
+
+    while (g_atomic_int_get (&fe->cancel) == 0
+           && (directory = (char *) g_queue_pop_tail (&dirs)) != NULL)
+    {
+        DIR *dirp;
+
+        /* handle absolute ignore dirs here */
+        if (find_ignore_dir_search (directory))
+        {
+            fe->ignore_count++;
+            g_free (directory);
+            continue;
+        }
+
+        find_engine_post (fe, FIND_RESULT_STATUS, directory, NULL, 0, 0);
+
+        dirp = opendir (directory);
+        if (dirp != NULL)
+        {
+            struct dirent *dp;
+
+            while (g_atomic_int_get (&fe->cancel) == 0 && (dp = readdir (dirp)) != NULL)
+            {
+                gsize bytes_found;
+
+                /* don't let the queue of files grow too much */
+                while ((g_atomic_int_get (&fe->suspend) != 0
+                        || g_thread_pool_unprocessed (fe->pool) > FIND_QUEUE_MAX)
+                       && g_atomic_int_get (&fe->cancel) == 0)
+                    g_usleep (FIND_SUSPEND_SLEEP);
+
+                /* skip invalid filenames */
+                if (!str_is_valid_string (dp->d_name) || DIR_IS_DOT (dp->d_name)
+                    || DIR_IS_DOTDOT (dp->d_name))
+                    continue;
+
+                if (options.skip_hidden && dp->d_name[0] == '.')
+                    continue;
+
+                if (options.find_recurs)
+                {
+                    /* handle relative ignore dirs here */
+                    if (options.ignore_dirs_enable && find_ignore_dir_search (dp->d_name))
+                        fe->ignore_count++;
+                    else
+                    {
+                        char *path;
+                        struct stat tmp_stat;
+
+                        path = mc_build_filename (directory, dp->d_name, (char *) NULL);
+                        if (lstat (path, &tmp_stat) == 0 && S_ISDIR (tmp_stat.st_mode))
+                            g_queue_push_head (&dirs, path);
+                        else
+                            g_free (path);
+                    }
+                }
+
+                if (mc_search_run (fe->file_handle, dp->d_name, 0, strlen (dp->d_name),
+                                   &bytes_found))
+                {
+                    find_file_task_t *task;
+
+                    task = g_new (find_file_task_t, 1);
+                    task->dir = g_strdup (directory);
+                    task->name = g_strdup (dp->d_name);
+                    g_thread_pool_push (fe->pool, task, NULL);
+                }
+            }
+
+            closedir (dirp);
+        }
+
+        g_free (directory);
+    }
+
+    g_queue_foreach (&dirs, (GFunc) g_free, NULL);
+    g_queue_clear (&dirs);
+
+    /* wait for the content search threads */
+    g_thread_pool_free (fe->pool, FALSE, TRUE);
+    fe->pool = NULL;
+
+    find_engine_post (fe, FIND_RESULT_DONE, NULL, NULL, 0, 0);
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+find_engine_free (find_engine_t * fe)
+{
+    gpointer data;
+
+    while ((data = g_async_queue_try_pop (fe->handles)) != NULL)
+        mc_search_free ((mc_search_t *) data);
+    g_async_queue_unref (fe->handles);
+
+    while ((data = g_async_queue_try_pop (fe->results)) != NULL)
+        find_result_free ((find_result_t *) data);
+    g_async_queue_unref (fe->results);
+
+    mc_search_free (fe->file_handle);
+    g_free (fe->start_dir);
+    g_free (fe);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start parallel content search if the search is started in a local directory.
+ * Otherwise files are searched by do_search() on the idle events of the dialog.
+ *
+ * @return TRUE if search threads are started, FALSE otherwise
+ */
+
+static gboolean
+find_engine_start (void)
+{
+    const vfs_path_t *start_vpath;
+    find_engine_t *fe;
+    int i;
+
+    if (content_pattern == NULL || g_queue_get_length (&dir_queue) != 1)
+        return FALSE;
+
+#ifdef HAVE_CHARSET
+    /* recoding of search patterns isn't thread safe */
+    if (options.file_all_charsets || options.content_all_charsets)
+        return FALSE;
+#endif
+
+    start_vpath = (const vfs_path_t *) g_queue_peek_tail (&dir_queue);
+    if (!vfs_file_is_local (start_vpath))
+        return FALSE;
+
+    fe = g_new0 (find_engine_t, 1);
+    fe->start_dir = g_strdup (vfs_path_as_str (start_vpath));
+    fe->results = g_async_queue_new ();
+    fe->handles = g_async_queue_new ();
+
+    /* compile patterns here, in the main thread */
+    fe->file_handle = find_file_search_new ();
+    if (!mc_search_prepare (fe->file_handle))
+    {
+        find_engine_free (fe);
+        return FALSE;
+    }
+
+    for (i = 0; i < FIND_THREADS; i++)
+    {
+        mc_search_t *search;
+
+        search = find_content_search_new ();
+        if (search == NULL || !mc_search_prepare (search))
+        {
+            mc_search_free (search);
+            find_engine_free (fe);
+            return FALSE;
+        }
+        g_async_queue_push (fe->handles, search);
+    }
+
+    fe->pool = g_thread_pool_new (find_engine_search_file, fe, FIND_THREADS, TRUE, NULL);
+    if (fe->pool != NULL)
+        fe->walker = g_thread_try_new ("find", find_engine_walk, fe, NULL);
+
+    if (fe->walker == NULL)
+    {
+        if (fe->pool != NULL)
+            g_thread_pool_free (fe->pool, TRUE, TRUE);
+        find_engine_free (fe);
+        return FALSE;
+    }
+
+    /* start directory is handled by the walker */
+    clear_stack ();
+    find_engine = fe;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+find_engine_stop (void)
+{
+    if (find_engine == NULL)
+        return;
+
+    g_atomic_int_set (&find_engine->cancel, 1);
+    g_thread_join (find_engine->walker);
+    find_engine_free (find_engine);
+    find_engine = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Show results of the search threads, called on the idle events of the dialog */
+
+static int
+find_engine_poll (WDialog * h)
+{
+    find_result_t *res;
+    int count = 0;
+    gboolean done = FALSE;
+
+    res = (find_result_t *) g_async_queue_timeout_pop (find_engine->results, FIND_POLL_INTERVAL);
+
+    while (res != NULL)
+    {
+        switch (res->type)
+        {
+        case FIND_RESULT_MATCH:
+            find_add_match (res->dir, res->file, res->start, res->end);
+            break;
+        case FIND_RESULT_STATUS:
+            if (verbose)
+                status_update (str_trunc (res->dir, WIDGET (h)->cols - 8));
+            break;
+        default:
+            done = TRUE;
+            break;
+        }
+
+        find_result_free (res);
+
+        if (done || ++count >= FIND_RESULTS_PER_IDLE)
+            break;
+
+        res = (find_result_t *) g_async_queue_try_pop (find_engine->results);
+    }
+
+    if (done)
+    {
+        ignore_count = find_engine->ignore_count;
+        find_engine_stop ();
+        find_search_finished (h);
+        return 0;
+    }
+
+    find_rotate_dash (h, TRUE);
+
+    return 1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static int
 do_search (WDialog * h)
 {
@@ -1225,6 +1803,7 @@ do_search (WDialog * h)
 
     if (h == NULL)
     {                           /* someone forces me to close dirp */
+        find_engine_stop ();
         if (dirp != NULL)
         {
             mc_closedir (dirp);
@@ -1235,6 +1814,9 @@ do_search (WDialog * h)
         return 1;
     }
 
+    if (find_engine != NULL)
+        return find_engine_poll (h);
+
     for (count = 0; count < 32; count++)
     {
         while (dp == NULL)
@@ -1256,20 +1838,7 @@ do_search (WDialog * h)
                     tmp_vpath = pop_directory ();
                     if (tmp_vpath == NULL)
                     {
-                        running = FALSE;
-                        if (ignore_count == 0)
-                            status_update (_("Finished"));
-                        else
-                        {
-                            char msg[BUF_SMALL];
-                            g_snprintf (msg, sizeof (msg),
-                                        ngettext ("Finished (ignored %zd directory)",
-                                                  "Finished (ignored %zd directories)",
-                                                  ignore_count), ignore_count);
-                            status_update (msg);
-                        }
-                        find_rotate_dash (h, FALSE);
-                        stop_idle (h);
+                        find_search_finished (h);
                         return 0;
                     }
 
@@ -1509,6 +2078,8 @@ start_stop (WButton * button, int action)
 
     running = is_start;
     widget_want_idle (WIDGET (find_dlg), running);
+    if (find_engine != NULL)
+        g_atomic_int_set (&find_engine->suspend, running ? 0 : 1);
     is_start = !is_start;
 
     status_update (is_start ? _("Stopped") : _("Searching"));
@@ -1623,30 +2194,18 @@ run_process (void)
 {
     int ret;
 
-    search_content_handle = mc_search_new (content_pattern, -1, NULL);
-    if (search_content_handle)
-    {
-        search_content_handle->search_type =
-            options.content_regexp ? MC_SEARCH_T_REGEX : MC_SEARCH_T_NORMAL;
-        search_content_handle->is_case_sensitive = options.content_case_sens;
-        search_content_handle->whole_words = options.content_whole_words;
-#ifdef HAVE_CHARSET
-        search_content_handle->is_all_charsets = options.content_all_charsets;
-#endif
-    }
-    search_file_handle = mc_search_new (find_pattern, -1, NULL);
-    search_file_handle->search_type = options.file_pattern ? MC_SEARCH_T_GLOB : MC_SEARCH_T_REGEX;
-    search_file_handle->is_case_sensitive = options.file_case_sens;
-#ifdef HAVE_CHARSET
-    search_file_handle->is_all_charsets = options.file_all_charsets;
-#endif
-    search_file_handle->is_entire_line = options.file_pattern;
+    search_content_handle = find_content_search_new ();
+    search_file_handle = find_file_search_new ();
 
     resuming = FALSE;
 
+    find_engine_start ();
+
     widget_want_idle (WIDGET (find_dlg), TRUE);
     ret = dlg_run (find_dlg);
 
+    find_engine_stop ();
+
     mc_search_free (search_file_handle);
     search_file_handle = NULL;
     mc_search_free (search_content_handle);
@@ -239,6 +239,12 @@ main (int argc, char *argv[])
     char *config_migrate_msg;
     int exit_code = EXIT_FAILURE;
 
+#if !GLIB_CHECK_VERSION (2, 32, 0)
+    /* some operations use thread pools */
+    if (!g_thread_supported ())
+        g_thread_init (NULL);
+#endif
+
     mc_global.timer = mc_timer_new ();
 
     /* We had LC_CTYPE before, LC_ALL includs LC_TYPE as well */
@@ -42,12 +42,18 @@
 #include "lib/util.h"
 #include "lib/widget.h"
 
+#ifdef ENABLE_VFS
+#include "lib/vfs/readahead.h"  /* vfs_readahead_size */
+#endif
 #ifdef ENABLE_VFS_FTP
 #include "src/vfs/ftpfs/ftpfs.h"
 #endif
 #ifdef ENABLE_VFS_FISH
 #include "src/vfs/fish/fish.h"
 #endif
+#ifdef ENABLE_VFS_SFTP
+#include "src/vfs/sftpfs/init.h"
+#endif
 
 #ifdef HAVE_CHARSET
 #include "lib/charsets.h"
@@ -175,6 +181,12 @@ int verbose = 1;
  */
 int file_op_compute_totals = 1;
 
+/* Number of threads used to stat() entries of local directories, 0 to stat() them serially */
+int dir_stat_threads = 8;
+
+/* Number of threads used to sort large panels, 0 or 1 to sort them in the main thread */
+int dir_sort_threads = 4;
+
 /* If true use the internal viewer */
 int use_internal_view = 1;
 /* If set, use the builtin editor */
@@ -315,9 +327,12 @@ static const struct
     { "xtree_mode", &xtree_mode },
     { "num_history_items_recorded", &num_history_items_recorded },
     { "file_op_compute_totals", &file_op_compute_totals },
+    { "dir_stat_threads", &dir_stat_threads },
+    { "dir_sort_threads", &dir_sort_threads },
     { "classic_progressbar", &classic_progressbar},
 #ifdef ENABLE_VFS
     { "vfs_timeout", &vfs_timeout },
+    { "vfs_readahead_size", &vfs_readahead_size },
 #ifdef ENABLE_VFS_FTP
     { "ftpfs_directory_timeout", &ftpfs_directory_timeout },
     { "use_netrc", &ftpfs_use_netrc },
@@ -331,6 +346,9 @@ static const struct
 #ifdef ENABLE_VFS_FISH
     { "fish_directory_timeout", &fish_directory_timeout },
 #endif /* ENABLE_VFS_FISH */
+#ifdef ENABLE_VFS_SFTP
+    { "sftpfs_window_size", &sftpfs_window_size },
+#endif /* ENABLE_VFS_SFTP */
 #endif /* ENABLE_VFS */
     /* option_tab_spacing is used in internal viewer */
     { "editor_tab_spacing", &option_tab_spacing },
@@ -362,6 +380,7 @@ static const struct
     { "editor_ask_filename_before_edit", &editor_ask_filename_before_edit },
     { "nice_rotating_dash", &nice_rotating_dash },
     { "mcview_remember_file_position", &mcview_remember_file_position },
+    { "mcview_use_mmap", &mcview_use_mmap },
     { "auto_fill_mkdir_name", &auto_fill_mkdir_name },
     { "copymove_persistent_attr", &setup_copymove_persistent_attr },
     { NULL, NULL }
@@ -45,6 +45,7 @@
 #include "lib/vfs/utilvfs.h"
 #include "lib/vfs/xdirentry.h"
 #include "lib/vfs/gc.h"         /* vfs_rmstamp */
+#include "lib/vfs/decompress.h"
 
 #include "cpio.h"
 
@@ -57,11 +58,11 @@
 /* #define CPIO_POS(super) (super)->u.arch.fd */
 
 #define CPIO_SEEK_SET(super, where) \
-        mc_lseek (((cpio_super_data_t *)(super)->data)->fd, \
-                  CPIO_POS(super) = (where), SEEK_SET)
+        cpio_archive_seek ((cpio_super_data_t *)(super)->data, \
+                           CPIO_POS(super) = (where))
 #define CPIO_SEEK_CUR(super, where) \
-        mc_lseek (((cpio_super_data_t *)(super)->data)->fd, \
-                  CPIO_POS(super) += (where), SEEK_SET)
+        cpio_archive_seek ((cpio_super_data_t *)(super)->data, \
+                           CPIO_POS(super) += (where))
 
 #define MAGIC_LENGTH (6)        /* How many bytes we have to read ahead */
 #define SEEKBACK CPIO_SEEK_CUR(super, ptr - top)
@@ -136,6 +137,7 @@ typedef struct
 typedef struct
 {
     int fd;
+    vfs_decompress_t *stream;   /* decompressor of compressed archive, or NULL */
     struct stat st;
     int type;                   /* Type of the archive */
     GSList *deferred;           /* List of inodes for which another entries may appear */
@@ -167,6 +169,30 @@ cpio_defer_find (const void *a, const void *b)
     return (a1->inumber == b1->inumber && a1->device == b1->device) ? 0 : 1;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Read uncompressed data of the archive */
+
+static ssize_t
+cpio_archive_read (cpio_super_data_t * arch, char *buffer, size_t count)
+{
+    if (arch->stream != NULL)
+        return vfs_decompress_read (arch->stream, buffer, count);
+
+    return mc_read (arch->fd, buffer, count);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Set position in uncompressed data of the archive */
+
+static off_t
+cpio_archive_seek (cpio_super_data_t * arch, off_t offset)
+{
+    if (arch->stream != NULL)
+        return vfs_decompress_seek (arch->stream, offset, SEEK_SET);
+
+    return mc_lseek (arch->fd, offset, SEEK_SET);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static ssize_t
@@ -200,6 +226,8 @@ cpio_free_archive (struct vfs_class *me, struct vfs_s_super *super)
     if (super->data == NULL)
         return;
 
+    vfs_decompress_close (arch->stream);
+    arch->stream = NULL;
     if (arch->fd != -1)
         mc_close (arch->fd);
     arch->fd = -1;
@@ -229,13 +257,17 @@ cpio_open_cpio_file (struct vfs_class *me, struct vfs_s_super *super, const vfs_
     super->data = g_new (cpio_super_data_t, 1);
     arch = (cpio_super_data_t *) super->data;
     arch->fd = -1;              /* for now */
+    arch->stream = NULL;
     mc_stat (vpath, &arch->st);
     arch->type = CPIO_UNKNOWN;
     arch->deferred = NULL;
 
     type = get_compression_type (fd, super->name);
     if (type != COMPRESSION_NONE)
+        arch->stream = vfs_decompress_open (fd, type);
+    if (type != COMPRESSION_NONE && arch->stream == NULL)
     {
+        /* decompress to temporary file */
         char *s;
         vfs_path_t *tmp_vpath;
 
@@ -306,7 +338,7 @@ cpio_find_head (struct vfs_class *me, struct vfs_s_super *super)
     ssize_t top;
     ssize_t tmp;
 
-    top = mc_read (arch->fd, buf, sizeof (buf));
+    top = cpio_archive_read (arch, buf, sizeof (buf));
     if (top > 0)
         CPIO_POS (super) += top;
 
@@ -320,7 +352,7 @@ cpio_find_head (struct vfs_class *me, struct vfs_s_super *super)
                 ptr -= top - sizeof (buf) / 2;
                 top = sizeof (buf) / 2;
             }
-            tmp = mc_read (arch->fd, buf, top);
+            tmp = cpio_archive_read (arch, buf, top);
             if (tmp == 0 || tmp == -1)
             {
                 message (D_ERROR, MSG_ERROR, _("Premature end of cpio archive\n%s"), super->name);
@@ -498,7 +530,7 @@ cpio_create_entry (struct vfs_class *me, struct vfs_s_super *super, struct stat
         {
             inode->linkname = g_malloc (st->st_size + 1);
 
-            if (mc_read (arch->fd, inode->linkname, st->st_size) < st->st_size)
+            if (cpio_archive_read (arch, inode->linkname, st->st_size) < st->st_size)
             {
                 inode->linkname[0] = '\0';
                 return STATUS_EOF;
@@ -529,7 +561,7 @@ cpio_read_bin_head (struct vfs_class *me, struct vfs_s_super *super)
     char *name;
     struct stat st;
 
-    len = mc_read (arch->fd, (char *) &u.buf, HEAD_LENGTH);
+    len = cpio_archive_read (arch, (char *) &u.buf, HEAD_LENGTH);
     if (len < HEAD_LENGTH)
         return STATUS_EOF;
     CPIO_POS (super) += len;
@@ -546,7 +578,7 @@ cpio_read_bin_head (struct vfs_class *me, struct vfs_s_super *super)
         return STATUS_FAIL;
     }
     name = g_malloc (u.buf.c_namesize);
-    len = mc_read (arch->fd, name, u.buf.c_namesize);
+    len = cpio_archive_read (arch, name, u.buf.c_namesize);
     if (len < u.buf.c_namesize)
     {
         g_free (name);
@@ -593,7 +625,7 @@ cpio_read_oldc_head (struct vfs_class *me, struct vfs_s_super *super)
     ssize_t len;
     char *name;
 
-    if (mc_read (arch->fd, u.buf, HEAD_LENGTH) != HEAD_LENGTH)
+    if (cpio_archive_read (arch, u.buf, HEAD_LENGTH) != HEAD_LENGTH)
         return STATUS_EOF;
     CPIO_POS (super) += HEAD_LENGTH;
     u.buf[HEAD_LENGTH] = 0;
@@ -613,7 +645,7 @@ cpio_read_oldc_head (struct vfs_class *me, struct vfs_s_super *super)
         return STATUS_FAIL;
     }
     name = g_malloc (hd.c_namesize);
-    len = mc_read (arch->fd, name, hd.c_namesize);
+    len = cpio_archive_read (arch, name, hd.c_namesize);
     if ((len == -1) || ((unsigned long) len < hd.c_namesize))
     {
         g_free (name);
@@ -660,7 +692,7 @@ cpio_read_crc_head (struct vfs_class *me, struct vfs_s_super *super)
     ssize_t len;
     char *name;
 
-    if (mc_read (arch->fd, u.buf, HEAD_LENGTH) != HEAD_LENGTH)
+    if (cpio_archive_read (arch, u.buf, HEAD_LENGTH) != HEAD_LENGTH)
         return STATUS_EOF;
 
     CPIO_POS (super) += HEAD_LENGTH;
@@ -688,7 +720,7 @@ cpio_read_crc_head (struct vfs_class *me, struct vfs_s_super *super)
     }
 
     name = g_malloc (hd.c_namesize);
-    len = mc_read (arch->fd, name, hd.c_namesize);
+    len = cpio_archive_read (arch, name, hd.c_namesize);
 
     if ((len == -1) || ((unsigned long) len < hd.c_namesize))
     {
@@ -725,11 +757,19 @@ static int
 cpio_open_archive (struct vfs_s_super *super, const vfs_path_t * vpath,
                    const vfs_path_element_t * vpath_element)
 {
+    /* the index is kept for local archives only: the stat of a remote file is not reliable */
+    const gboolean indexed = vfs_file_is_local (vpath);
+
     (void) vpath_element;
 
     if (cpio_open_cpio_file (vpath_element->class, super, vpath) == -1)
         return -1;
 
+    if (indexed
+        && vfs_s_load_index (vpath_element->class, super,
+                             &((cpio_super_data_t *) super->data)->st))
+        return 0;
+
     while (TRUE)
     {
         ssize_t status;
@@ -756,6 +796,8 @@ cpio_open_archive (struct vfs_s_super *super, const vfs_path_t * vpath,
         break;
     }
 
+    if (indexed)
+        vfs_s_save_index (vpath_element->class, super, &((cpio_super_data_t *) super->data)->st);
     return 0;
 }
 
@@ -805,16 +847,16 @@ static ssize_t
 cpio_read (void *fh, char *buffer, size_t count)
 {
     off_t begin = FH->ino->data_offset;
-    int fd = ((cpio_super_data_t *) FH_SUPER->data)->fd;
+    cpio_super_data_t *arch = (cpio_super_data_t *) FH_SUPER->data;
     struct vfs_class *me = FH_SUPER->me;
     ssize_t res;
 
-    if (mc_lseek (fd, begin + FH->pos, SEEK_SET) != begin + FH->pos)
+    if (cpio_archive_seek (arch, begin + FH->pos) != begin + FH->pos)
         ERRNOR (EIO, -1);
 
     count = MIN (count, (size_t) (FH->ino->st.st_size - FH->pos));
 
-    res = mc_read (fd, buffer, count);
+    res = cpio_archive_read (arch, buffer, count);
     if (res == -1)
         ERRNOR (errno, -1);
 
@@ -61,6 +61,7 @@
 #include "lib/vfs/vfs.h"
 #include "lib/vfs/utilvfs.h"
 #include "lib/vfs/gc.h"         /* vfs_rmstamp */
+#include "lib/vfs/indexcache.h"
 
 #include "extfs.h"
 
@@ -129,6 +130,7 @@ typedef struct
     char *path;
     char *prefix;
     gboolean need_archive;
+    gboolean copyout_many;      /* helper can extract many files at once */
 } extfs_plugin_info_t;
 
 /*** file scope variables ************************************************************************/
@@ -149,6 +151,7 @@ static void extfs_remove_entry (struct entry *e);
 static void extfs_free (vfsid id);
 static void extfs_free_entry (struct entry *e);
 static struct entry *extfs_resolve_symlinks_int (struct entry *entry, GSList * list);
+static void extfs_stat_move (struct stat *buf, const struct inode *inode);
 
 /* --------------------------------------------------------------------------------------------- */
 
@@ -389,17 +392,55 @@ extfs_free_archive (struct archive *archive)
 
 /* --------------------------------------------------------------------------------------------- */
 
+static struct archive *
+extfs_new_archive (int fstype, const char *name, const vfs_path_t * local_name_vpath,
+                   const struct stat *st)
+{
+    static dev_t archive_counter = 0;
+    mode_t mode;
+    struct archive *current_archive;
+    struct entry *root_entry;
+
+    current_archive = g_new (struct archive, 1);
+    current_archive->fstype = fstype;
+    current_archive->name = g_strdup (name);
+    current_archive->local_name = g_strdup (vfs_path_get_last_path_str (local_name_vpath));
+
+    if (local_name_vpath != NULL)
+        mc_stat (local_name_vpath, &current_archive->local_stat);
+    current_archive->inode_counter = 0;
+    current_archive->fd_usage = 0;
+    current_archive->rdev = archive_counter++;
+    current_archive->next = first_archive;
+    first_archive = current_archive;
+    mode = st->st_mode & 07777;
+    if (mode & 0400)
+        mode |= 0100;
+    if (mode & 0040)
+        mode |= 0010;
+    if (mode & 0004)
+        mode |= 0001;
+    mode |= S_IFDIR;
+    root_entry = extfs_generate_entry (current_archive, PATH_SEP_STR, NULL, mode);
+    root_entry->inode->uid = st->st_uid;
+    root_entry->inode->gid = st->st_gid;
+    root_entry->inode->atime = st->st_atime;
+    root_entry->inode->ctime = st->st_ctime;
+    root_entry->inode->mtime = st->st_mtime;
+    current_archive->root_entry = root_entry;
+
+    return current_archive;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static FILE *
 extfs_open_archive (int fstype, const char *name, struct archive **pparc)
 {
     const extfs_plugin_info_t *info;
-    static dev_t archive_counter = 0;
     FILE *result = NULL;
-    mode_t mode;
     char *cmd;
     struct stat mystat;
-    struct archive *current_archive;
-    struct entry *root_entry;
     char *tmp = NULL;
     vfs_path_t *local_name_vpath = NULL;
     vfs_path_t *name_vpath;
@@ -445,42 +486,231 @@ extfs_open_archive (int fstype, const char *name, struct archive **pparc)
     setvbuf (result, NULL, _IONBF, 0);
 #endif
 
-    current_archive = g_new (struct archive, 1);
-    current_archive->fstype = fstype;
-    current_archive->name = g_strdup (name);
-    current_archive->local_name = g_strdup (vfs_path_get_last_path_str (local_name_vpath));
+    *pparc = extfs_new_archive (fstype, name, local_name_vpath, &mystat);
+    vfs_path_free (local_name_vpath);
 
-    if (local_name_vpath != NULL)
+  ret:
+    vfs_path_free (name_vpath);
+    return result;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static struct inode *
+extfs_new_inode (struct archive *archive, const struct stat *st)
+{
+    struct inode *inode;
+
+    inode = g_new (struct inode, 1);
+    inode->local_filename = NULL;
+    inode->inode = (archive->inode_counter)++;
+    inode->nlink = 1;
+    inode->dev = archive->rdev;
+    inode->archive = archive;
+    inode->mode = st->st_mode;
+#ifdef HAVE_STRUCT_STAT_ST_RDEV
+    inode->rdev = st->st_rdev;
+#else
+    inode->rdev = 0;
+#endif
+    inode->uid = st->st_uid;
+    inode->gid = st->st_gid;
+    inode->size = st->st_size;
+    inode->mtime = st->st_mtime;
+    inode->atime = st->st_atime;
+    inode->ctime = st->st_ctime;
+    inode->first_in_subdir = NULL;
+    inode->last_in_subdir = NULL;
+    inode->linkname = NULL;
+
+    return inode;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get stat of the archive if its index can be cached: the helper lists a local file.
+ */
+
+static gboolean
+extfs_index_stat (int fstype, const char *name, struct stat *st)
+{
+    const extfs_plugin_info_t *info;
+    vfs_path_t *name_vpath;
+    gboolean ret;
+
+    info = &g_array_index (extfs_plugins, extfs_plugin_info_t, fstype);
+    if (!info->need_archive)
+        return FALSE;
+
+    name_vpath = vfs_path_from_str (name);
+    ret = vfs_file_is_local (name_vpath) && mc_stat (name_vpath, st) == 0;
+    vfs_path_free (name_vpath);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Identify indexes by the helper and its modification time, so an updated helper lists
+ * the archive again.
+ *
+ * @return newly allocated string, NULL if the helper can't be stat'ed
+ */
+
+static char *
+extfs_index_prefix (const extfs_plugin_info_t * info)
+{
+    char *helper;
+    char *prefix = NULL;
+    struct stat st;
+
+    helper = g_strconcat (info->path, info->prefix, (char *) NULL);
+    if (stat (helper, &st) == 0)
+        prefix = g_strdup_printf ("%s\n%ld", helper, (long) st.st_mtime);
+    g_free (helper);
+
+    return prefix;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Build the archive from the index saved by extfs_save_index() instead of running the helper.
+ */
+
+static gboolean
+extfs_load_index (int fstype, const char *name, const struct stat *st, struct archive **pparc)
+{
+    const extfs_plugin_info_t *info;
+    vfs_index_t *index;
+    struct archive *current_archive;
+    struct entry **entries;
+    char *prefix;
+    guint i, count;
+
+    info = &g_array_index (extfs_plugins, extfs_plugin_info_t, fstype);
+    prefix = extfs_index_prefix (info);
+    if (prefix == NULL)
+        return FALSE;
+
+    index = vfs_index_load (prefix, name, st);
+    g_free (prefix);
+    if (index == NULL)
+        return FALSE;
+
+    current_archive = extfs_new_archive (fstype, name, NULL, st);
+
+    /* entries which created inodes */
+    entries = g_new0 (struct entry *, vfs_index_get_inode_count (index));
+    entries[0] = current_archive->root_entry;
+
+    count = vfs_index_get_entry_count (index);
+    for (i = 0; i < count; i++)
     {
-        mc_stat (local_name_vpath, &current_archive->local_stat);
-        vfs_path_free (local_name_vpath);
+        struct entry *entry, *pent;
+        guint dir, ino;
+
+        entry = g_new (struct entry, 1);
+        entry->name = g_strdup (vfs_index_get_entry (index, i, &dir, &ino));
+        entry->next_in_dir = NULL;
+
+        /* directory of the entry is before the entry and it has the dot entries */
+        pent = entries[dir];
+        entry->dir = pent;
+        pent->inode->last_in_subdir->next_in_dir = entry;
+        pent->inode->last_in_subdir = entry;
+
+        if (entries[ino] != NULL)
+        {
+            entry->inode = entries[ino]->inode;
+            entry->inode->nlink++;
+        }
+        else
+        {
+            struct stat ino_st;
+            off_t data_offset;
+            const char *linkname;
+
+            linkname = vfs_index_get_inode (index, ino, &ino_st, &data_offset);
+            entry->inode = extfs_new_inode (current_archive, &ino_st);
+            entry->inode->linkname = g_strdup (linkname);
+            entries[ino] = entry;
+            if (S_ISDIR (ino_st.st_mode))
+                extfs_make_dots (entry);
+        }
     }
-    current_archive->inode_counter = 0;
-    current_archive->fd_usage = 0;
-    current_archive->rdev = archive_counter++;
-    current_archive->next = first_archive;
-    first_archive = current_archive;
-    mode = mystat.st_mode & 07777;
-    if (mode & 0400)
-        mode |= 0100;
-    if (mode & 0040)
-        mode |= 0010;
-    if (mode & 0004)
-        mode |= 0001;
-    mode |= S_IFDIR;
-    root_entry = extfs_generate_entry (current_archive, PATH_SEP_STR, NULL, mode);
-    root_entry->inode->uid = mystat.st_uid;
-    root_entry->inode->gid = mystat.st_gid;
-    root_entry->inode->atime = mystat.st_atime;
-    root_entry->inode->ctime = mystat.st_ctime;
-    root_entry->inode->mtime = mystat.st_mtime;
-    current_archive->root_entry = root_entry;
+
+    g_free (entries);
+    vfs_index_free (index);
 
     *pparc = current_archive;
+    return TRUE;
+}
 
-  ret:
-    vfs_path_free (name_vpath);
-    return result;
+/* --------------------------------------------------------------------------------------------- */
+/** Add entries of the directory and of its subdirectories to the index */
+
+static void
+extfs_index_add_dir (vfs_index_t * index, GHashTable * inodes, const struct entry *dir,
+                     guint dir_num)
+{
+    const struct entry *entry;
+
+    for (entry = dir->inode->first_in_subdir; entry != NULL; entry = entry->next_in_dir)
+    {
+        gpointer num;
+        gboolean is_new;
+
+        if (DIR_IS_DOT (entry->name) || DIR_IS_DOTDOT (entry->name))
+            continue;
+
+        /* hardlinks share the inode */
+        is_new = !g_hash_table_lookup_extended (inodes, entry->inode, NULL, &num);
+        if (is_new)
+        {
+            struct stat st;
+
+            extfs_stat_move (&st, entry->inode);
+            num = GUINT_TO_POINTER (vfs_index_add_inode (index, &st, entry->inode->linkname, 0));
+            g_hash_table_insert (inodes, entry->inode, num);
+        }
+
+        vfs_index_add_entry (index, dir_num, GPOINTER_TO_UINT (num), entry->name);
+
+        if (is_new && S_ISDIR (entry->inode->mode))
+            extfs_index_add_dir (index, inodes, entry, GPOINTER_TO_UINT (num));
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Save the archive tree, so the helper isn't run while the archive isn't changed */
+
+static void
+extfs_save_index (const struct archive *archive, const struct stat *st)
+{
+    const extfs_plugin_info_t *info;
+    vfs_index_t *index;
+    GHashTable *inodes;
+    struct stat root_st;
+    char *prefix;
+    guint root;
+
+    info = &g_array_index (extfs_plugins, extfs_plugin_info_t, archive->fstype);
+    prefix = extfs_index_prefix (info);
+    if (prefix == NULL)
+        return;
+
+    index = vfs_index_new ();
+    inodes = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    extfs_stat_move (&root_st, archive->root_entry->inode);
+    root = vfs_index_add_inode (index, &root_st, NULL, 0);
+    g_hash_table_insert (inodes, archive->root_entry->inode, GUINT_TO_POINTER (root));
+    extfs_index_add_dir (index, inodes, archive->root_entry, root);
+
+    g_hash_table_destroy (inodes);
+    vfs_index_save (index, prefix, archive->name, st);
+    vfs_index_free (index);
+    g_free (prefix);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -497,9 +727,15 @@ extfs_read_archive (int fstype, const char *name, struct archive **pparc)
     char *buffer;
     struct archive *current_archive;
     char *current_file_name, *current_link_name;
+    struct stat st;
+    gboolean use_index;
 
     info = &g_array_index (extfs_plugins, extfs_plugin_info_t, fstype);
 
+    use_index = extfs_index_stat (fstype, name, &st);
+    if (use_index && extfs_load_index (fstype, name, &st, pparc))
+        return 0;
+
     extfsd = extfs_open_archive (fstype, name, &current_archive);
 
     if (extfsd == NULL)
@@ -576,38 +812,15 @@ extfs_read_archive (int fstype, const char *name, struct archive **pparc)
                 }
                 else
                 {
-                    inode = g_new (struct inode, 1);
+                    inode = extfs_new_inode (current_archive, &hstat);
                     entry->inode = inode;
-                    inode->local_filename = NULL;
-                    inode->inode = (current_archive->inode_counter)++;
-                    inode->nlink = 1;
-                    inode->dev = current_archive->rdev;
-                    inode->archive = current_archive;
-                    inode->mode = hstat.st_mode;
-#ifdef HAVE_STRUCT_STAT_ST_RDEV
-                    inode->rdev = hstat.st_rdev;
-#else
-                    inode->rdev = 0;
-#endif
-                    inode->uid = hstat.st_uid;
-                    inode->gid = hstat.st_gid;
-                    inode->size = hstat.st_size;
-                    inode->mtime = hstat.st_mtime;
-                    inode->atime = hstat.st_atime;
-                    inode->ctime = hstat.st_ctime;
-                    inode->first_in_subdir = NULL;
-                    inode->last_in_subdir = NULL;
                     if (current_link_name != NULL && S_ISLNK (hstat.st_mode))
                     {
                         inode->linkname = current_link_name;
                         current_link_name = NULL;
                     }
-                    else
-                    {
-                        if (S_ISLNK (hstat.st_mode))
-                            inode->mode &= ~S_IFLNK;    /* You *DON'T* want to do this always */
-                        inode->linkname = NULL;
-                    }
+                    else if (S_ISLNK (hstat.st_mode))
+                        inode->mode &= ~S_IFLNK;        /* You *DON'T* want to do this always */
                     if (S_ISDIR (hstat.st_mode))
                         extfs_make_dots (entry);
                 }
@@ -628,6 +841,10 @@ extfs_read_archive (int fstype, const char *name, struct archive **pparc)
     }
 
     close_error_pipe (D_ERROR, NULL);
+
+    if (use_index)
+        extfs_save_index (current_archive, &st);
+
     *pparc = current_archive;
     return 0;
 }
@@ -854,6 +1071,206 @@ extfs_cmd (const char *str_extfs_cmd, struct archive *archive,
     return retval;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Extract many files with one run of the helper. The helper gets a manifest with the stored
+ * name and the local file name on separate lines for every file.
+ *
+ * Only files of the size stored in the archive are taken, others are left to copyout.
+ *
+ * @return TRUE if the files were extracted, FALSE if the helper failed or doesn't support it
+ */
+
+static gboolean
+extfs_cmd_copyout_many (struct archive *archive, GPtrArray * files)
+{
+    vfs_path_t *manifest_vpath;
+    const char *manifest;
+    char *quoted_manifest;
+    char *archive_name, *quoted_archive_name;
+    extfs_plugin_info_t *info;
+    char **local_filenames;
+    char *cmd;
+    FILE *f;
+    int fd;
+    guint i, extracted = 0, wrong = 0;
+    gboolean ok;
+
+    fd = vfs_mkstemps (&manifest_vpath, "extfs", "manifest");
+    if (fd == -1)
+        return FALSE;
+    manifest = vfs_path_get_by_index (manifest_vpath, -1)->path;
+
+    f = fdopen (fd, "w");
+    if (f == NULL)
+    {
+        close (fd);
+        unlink (manifest);
+        vfs_path_free (manifest_vpath);
+        return FALSE;
+    }
+
+    local_filenames = g_new0 (char *, files->len);
+
+    for (i = 0; i < files->len; i++)
+    {
+        struct entry *entry = (struct entry *) g_ptr_array_index (files, i);
+        vfs_path_t *local_filename_vpath;
+        char *file;
+        int local_handle;
+
+        file = extfs_get_path_from_entry (entry);
+        /* such names can't be written to the manifest, the file will be extracted alone */
+        if (strchr (file, '\n') == NULL)
+        {
+            local_handle = vfs_mkstemps (&local_filename_vpath, "extfs", entry->name);
+            if (local_handle != -1)
+            {
+                close (local_handle);
+                local_filenames[i] =
+                    g_strdup (vfs_path_get_by_index (local_filename_vpath, -1)->path);
+                vfs_path_free (local_filename_vpath);
+                fprintf (f, "%s\n%s\n", file, local_filenames[i]);
+            }
+        }
+        g_free (file);
+    }
+
+    ok = (fclose (f) == 0);
+
+    if (ok)
+    {
+        archive_name = extfs_get_archive_name (archive);
+        quoted_archive_name = name_quote (archive_name, FALSE);
+        g_free (archive_name);
+        quoted_manifest = name_quote (manifest, FALSE);
+        info = &g_array_index (extfs_plugins, extfs_plugin_info_t, archive->fstype);
+        cmd = g_strconcat (info->path, info->prefix, " copyout-many ",
+                           quoted_archive_name, " ", quoted_manifest, (char *) NULL);
+        g_free (quoted_manifest);
+        g_free (quoted_archive_name);
+
+        /* errors aren't shown: the files are extracted one by one with copyout then */
+        open_error_pipe ();
+        ok = (my_system (EXECUTE_AS_SHELL, mc_global.tty.shell, cmd) == 0);
+        g_free (cmd);
+        close_error_pipe (-1, NULL);
+
+    }
+
+    /* the exit code alone isn't trusted: files of wrong size are extracted with copyout later */
+    for (i = 0; i < files->len; i++)
+        if (local_filenames[i] != NULL)
+        {
+            struct entry *entry = (struct entry *) g_ptr_array_index (files, i);
+            struct stat st;
+
+            if (ok && stat (local_filenames[i], &st) == 0 && st.st_size == entry->inode->size)
+            {
+                entry->inode->local_filename = local_filenames[i];
+                extracted++;
+            }
+            else
+            {
+                if (ok)
+                    wrong++;
+                unlink (local_filenames[i]);
+                g_free (local_filenames[i]);
+            }
+        }
+
+    /* nothing came out right: the helper doesn't really support the command */
+    if (!ok || (extracted == 0 && wrong != 0))
+    {
+        info = &g_array_index (extfs_plugins, extfs_plugin_info_t, archive->fstype);
+        info->copyout_many = FALSE;
+        ok = FALSE;
+    }
+
+    g_free (local_filenames);
+    unlink (manifest);
+    vfs_path_free (manifest_vpath);
+
+    return ok;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Collect regular files under the entry which aren't extracted yet */
+
+static void
+extfs_prefetch_collect (struct entry *entry, GHashTable * inodes, GPtrArray * files)
+{
+    if (S_ISDIR (entry->inode->mode))
+    {
+        struct entry *e;
+
+        for (e = entry->inode->first_in_subdir; e != NULL; e = e->next_in_dir)
+            if (!DIR_IS_DOT (e->name) && !DIR_IS_DOTDOT (e->name))
+                extfs_prefetch_collect (e, inodes, files);
+    }
+    else if (S_ISREG (entry->inode->mode) && entry->inode->local_filename == NULL
+             && g_hash_table_lookup (inodes, entry->inode) == NULL)
+    {
+        /* hardlinks share the inode */
+        g_hash_table_insert (inodes, entry->inode, entry->inode);
+        g_ptr_array_add (files, entry);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Extract files which are going to be read, e.g. copied out of the archive, in one pass.
+ *
+ * @param vpath directory in the archive
+ * @param names names of files and directories in vpath, NULL for the whole vpath
+ */
+
+static void
+extfs_prefetch (const vfs_path_t * vpath, const GPtrArray * names)
+{
+    struct archive *archive = NULL;
+    struct entry *dir;
+    GHashTable *inodes;
+    GPtrArray *files;
+    char *q;
+
+    q = extfs_get_path (vpath, &archive, FALSE);
+    if (q == NULL)
+        return;
+    dir = extfs_find_entry (archive->root_entry, q, FALSE, FALSE);
+    g_free (q);
+    if (dir == NULL
+        || !g_array_index (extfs_plugins, extfs_plugin_info_t, archive->fstype).copyout_many)
+        return;
+
+    inodes = g_hash_table_new (g_direct_hash, g_direct_equal);
+    files = g_ptr_array_new ();
+
+    if (names == NULL)
+        extfs_prefetch_collect (dir, inodes, files);
+    else
+    {
+        guint i;
+
+        for (i = 0; i < names->len; i++)
+        {
+            struct entry *entry;
+
+            entry = extfs_find_entry (dir, (const char *) g_ptr_array_index (names, i), FALSE,
+                                      FALSE);
+            if (entry != NULL)
+                extfs_prefetch_collect (entry, inodes, files);
+        }
+    }
+
+    /* one file is extracted with copyout as well */
+    if (files->len > 1)
+        extfs_cmd_copyout_many (archive, files);
+
+    g_ptr_array_free (files, TRUE);
+    g_hash_table_destroy (inodes);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static void
@@ -1606,6 +2023,7 @@ extfs_get_plugins (const char *where, gboolean silent)
                  */
                 len = strlen (filename);
                 info.need_archive = (filename[len - 1] != '+');
+                info.copyout_many = TRUE;
                 info.path = g_strconcat (dirname, PATH_SEP_STR, (char *) NULL);
                 info.prefix = g_strdup (filename);
 
@@ -1702,14 +2120,17 @@ extfs_done (struct vfs_class *me)
 static int
 extfs_setctl (const vfs_path_t * vpath, int ctlop, void *arg)
 {
-    (void) arg;
-
-    if (ctlop == VFS_SETCTL_RUN)
+    switch (ctlop)
     {
+    case VFS_SETCTL_RUN:
         extfs_run (vpath);
         return 1;
+    case VFS_SETCTL_PREFETCH:
+        extfs_prefetch (vpath, (const GPtrArray *) arg);
+        return 1;
+    default:
+        return 0;
     }
-    return 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
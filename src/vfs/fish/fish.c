@@ -74,6 +74,7 @@
 #include "lib/vfs/netutil.h"
 #include "lib/vfs/xdirentry.h"
 #include "lib/vfs/gc.h"         /* vfs_stamp_create */
+#include "lib/vfs/readahead.h"  /* vfs_readahead_recv() */
 
 #include "fish.h"
 #include "fishdef.h"
@@ -1086,6 +1087,31 @@ fish_linear_read (struct vfs_class *me, vfs_file_handler_t * fh, void *buf, size
     ERRNOR (errno, n);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Receive data in the read-ahead thread. The reply of the remote side is read afterwards
+ * by fish_linear_read() in the main thread.
+ */
+
+static ssize_t
+fish_linear_recv (struct vfs_class *me, vfs_file_handler_t * fh, void *buf, size_t len)
+{
+    fish_fh_data_t *fish = (fish_fh_data_t *) fh->data;
+    struct vfs_s_super *super = FH_SUPER;
+    ssize_t n;
+
+    (void) me;
+
+    len = MIN ((size_t) (fish->total - fish->got), len);
+    if (len == 0)
+        return 0;
+
+    n = vfs_readahead_recv (SUP->sockr, buf, len);
+    if (n > 0)
+        fish->got += n;
+    return n;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static void
@@ -1617,6 +1643,7 @@ init_fish (void)
     fish_subclass.linear_start = fish_linear_start;
     fish_subclass.linear_read = fish_linear_read;
     fish_subclass.linear_close = fish_linear_close;
+    fish_subclass.linear_recv = fish_linear_recv;
 
     vfs_s_init_class (&vfs_fish_ops, &fish_subclass);
     vfs_fish_ops.name = "fish";
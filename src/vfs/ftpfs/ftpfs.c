@@ -109,6 +109,7 @@ What to do with this?
 #include "lib/vfs/netutil.h"
 #include "lib/vfs/xdirentry.h"
 #include "lib/vfs/gc.h"         /* vfs_stamp_create */
+#include "lib/vfs/readahead.h"  /* vfs_readahead_recv() */
 
 #include "ftpfs.h"
 
@@ -1940,6 +1941,20 @@ ftpfs_linear_read (struct vfs_class *me, vfs_file_handler_t * fh, void *buf, siz
     ERRNOR (errno, n);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Receive data in the read-ahead thread. The data connection is closed afterwards
+ * by ftpfs_linear_read() in the main thread.
+ */
+
+static ssize_t
+ftpfs_linear_recv (struct vfs_class *me, vfs_file_handler_t * fh, void *buf, size_t len)
+{
+    (void) me;
+
+    return vfs_readahead_recv (FH_SOCK, buf, len);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static void
@@ -2592,6 +2607,7 @@ init_ftpfs (void)
     ftpfs_subclass.linear_start = ftpfs_linear_start;
     ftpfs_subclass.linear_read = ftpfs_linear_read;
     ftpfs_subclass.linear_close = ftpfs_linear_close;
+    ftpfs_subclass.linear_recv = ftpfs_linear_recv;
 
     vfs_s_init_class (&vfs_ftpfs_ops, &ftpfs_subclass);
     vfs_ftpfs_ops.name = "ftpfs";
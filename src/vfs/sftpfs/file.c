@@ -33,23 +33,179 @@
 #include "lib/util.h"
 
 #include "internal.h"
+#include "init.h"
 
 /*** global variables ****************************************************************************/
 
+/* size of read-ahead and write-behind window of a file in KiB */
+int sftpfs_window_size = 1024;
+
 /*** file scope macro definitions ****************************************************************/
 
+/* a window smaller than one SFTP request wouldn't keep anything outstanding */
+#define SFTPFS_MIN_WINDOW_SIZE 32
+
 /*** file scope type declarations ****************************************************************/
 
+/*
+ * libssh2 keeps several SFTP requests outstanding if it's given a large buffer: reading asks for
+ * more data ahead, writing sends the whole buffer and returns the size of the acknowledged part.
+ * Small reads and writes of the caller go through a window of sftpfs_window_size KiB.
+ * Data read ahead is returned from it. Written data is collected in it and sent; the session is
+ * blocking, so libssh2 returns after the first acknowledgement and the rest stays outstanding.
+ * The acknowledged part is skipped and the rest is passed to libssh2 again. If the window is
+ * full, the writer waits until its first half is acknowledged.
+ *
+ * If the server fails to store the data, data of earlier writes which already succeeded is lost.
+ * So the error is kept: all following writes, stats and close of the file fail until the file
+ * is reopened.
+ */
 typedef struct
 {
     LIBSSH2_SFTP_HANDLE *handle;
     int flags;
     mode_t mode;
+
+    char *window;
+    size_t window_size;
+    size_t window_len;          /* data in window */
+    size_t window_pos;          /* data already returned to reader or acknowledged by server */
+    gboolean window_write;      /* window is used for writing */
+    gboolean window_failed;     /* data written to the window was lost */
 } sftpfs_file_handler_data_t;
 
 /*** file scope variables ************************************************************************/
 
 /*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Send data written to the window and take acknowledgements of the server.
+ *
+ * @param file_handler the file handler data
+ * @param keep         wait until no more than this number of bytes isn't acknowledged;
+ *                     at least one acknowledgement is waited for if data is outstanding
+ * @param mcerror      pointer to the error handler
+ * @return TRUE on success, FALSE otherwise. Data isn't kept after the error, and the window
+ *         fails until the file is reopened.
+ */
+
+static gboolean
+sftpfs_push_window (vfs_file_handler_t * file_handler, size_t keep, GError ** mcerror)
+{
+    sftpfs_file_handler_data_t *file_handler_data = file_handler->data;
+    sftpfs_super_data_t *super_data;
+    gboolean ret;
+
+    super_data = (sftpfs_super_data_t *) file_handler->ino->super->data;
+
+    if (file_handler_data->window_failed)
+    {
+        mc_propagate_error (mcerror, -1, "%s",
+                            _("sftp: Data written to the file earlier was not stored"));
+        return FALSE;
+    }
+
+    while (file_handler_data->window_pos != file_handler_data->window_len)
+    {
+        ssize_t rc;
+
+        rc = libssh2_sftp_write (file_handler_data->handle,
+                                 file_handler_data->window + file_handler_data->window_pos,
+                                 file_handler_data->window_len - file_handler_data->window_pos);
+        if (rc > 0)
+        {
+            /* the unacknowledged rest must be passed again */
+            file_handler_data->window_pos += rc;
+            if (file_handler_data->window_len - file_handler_data->window_pos <= keep)
+                return TRUE;
+            continue;
+        }
+
+        if (rc < 0 && rc != LIBSSH2_ERROR_EAGAIN)
+        {
+            sftpfs_ssherror_to_gliberror (super_data, rc, mcerror);
+            break;
+        }
+
+        if (file_handler_data->window_len - file_handler_data->window_pos <= keep)
+            return TRUE;
+
+        sftpfs_waitsocket (super_data, mcerror);
+        if (mcerror != NULL && *mcerror != NULL)
+            break;
+    }
+
+    ret = file_handler_data->window_pos == file_handler_data->window_len;
+    file_handler_data->window_failed = !ret;
+    file_handler_data->window_len = 0;
+    file_handler_data->window_pos = 0;
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Empty the window: send all written data to the server or drop data read ahead.
+ *
+ * @param file_handler the file handler data
+ * @param mcerror      pointer to the error handler
+ * @return TRUE on success, FALSE otherwise
+ */
+
+static gboolean
+sftpfs_sync_window (vfs_file_handler_t * file_handler, GError ** mcerror)
+{
+    sftpfs_file_handler_data_t *file_handler_data = file_handler->data;
+    gboolean ret = TRUE;
+
+    if (file_handler_data->window_write)
+        ret = sftpfs_push_window (file_handler, 0, mcerror);
+
+    file_handler_data->window_len = 0;
+    file_handler_data->window_pos = 0;
+    /* keep the failed window to fail the next writes */
+    file_handler_data->window_write = !ret;
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read data from the server. libssh2 asks for more data ahead of @count.
+ *
+ * @return number of bytes read, 0 at the end of file, -1 on error
+ */
+
+static ssize_t
+sftpfs_read_data (vfs_file_handler_t * file_handler, char *buffer, size_t count,
+                  GError ** mcerror)
+{
+    sftpfs_file_handler_data_t *file_handler_data = file_handler->data;
+    sftpfs_super_data_t *super_data;
+    ssize_t rc;
+
+    super_data = (sftpfs_super_data_t *) file_handler->ino->super->data;
+
+    do
+    {
+        rc = libssh2_sftp_read (file_handler_data->handle, buffer, count);
+        if (rc >= 0)
+            break;
+
+        if (rc != LIBSSH2_ERROR_EAGAIN)
+        {
+            sftpfs_ssherror_to_gliberror (super_data, rc, mcerror);
+            return -1;
+        }
+
+        sftpfs_waitsocket (super_data, mcerror);
+        mc_return_val_if_error (mcerror, -1);
+    }
+    while (rc == LIBSSH2_ERROR_EAGAIN);
+
+    return rc;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Reopen file by file handle.
@@ -149,6 +305,9 @@ sftpfs_open_file (vfs_file_handler_t * file_handler, int flags, mode_t mode, GEr
 
     file_handler_data->flags = flags;
     file_handler_data->mode = mode;
+    file_handler_data->window_size =
+        (size_t) MAX (sftpfs_window_size, SFTPFS_MIN_WINDOW_SIZE) * 1024;
+    file_handler_data->window = g_malloc (file_handler_data->window_size);
     file_handler->data = file_handler_data;
 
     if (do_append)
@@ -156,7 +315,10 @@ sftpfs_open_file (vfs_file_handler_t * file_handler, int flags, mode_t mode, GEr
         struct stat file_info;
 
         if (sftpfs_fstat (file_handler, &file_info, mcerror) == 0)
+        {
             libssh2_sftp_seek64 (file_handler_data->handle, file_info.st_size);
+            file_handler->pos = file_info.st_size;
+        }
     }
     return TRUE;
 }
@@ -186,6 +348,10 @@ sftpfs_fstat (void *data, struct stat *buf, GError ** mcerror)
     if (sftpfs_fh->handle == NULL)
         return -1;
 
+    /* the size must include data written */
+    if (sftpfs_fh->window_write && !sftpfs_push_window (fh, 0, mcerror))
+        return -1;
+
     do
     {
         res = libssh2_sftp_fstat_ex (sftpfs_fh->handle, &attrs, 0);
@@ -242,7 +408,6 @@ sftpfs_read_file (vfs_file_handler_t * file_handler, char *buffer, size_t count,
 {
     ssize_t rc;
     sftpfs_file_handler_data_t *file_handler_data;
-    sftpfs_super_data_t *super_data;
 
     mc_return_val_if_error (mcerror, -1);
 
@@ -254,26 +419,34 @@ sftpfs_read_file (vfs_file_handler_t * file_handler, char *buffer, size_t count,
     }
 
     file_handler_data = file_handler->data;
-    super_data = (sftpfs_super_data_t *) file_handler->ino->super->data;
 
-    do
-    {
-        rc = libssh2_sftp_read (file_handler_data->handle, buffer, count);
-        if (rc >= 0)
-            break;
+    if (file_handler_data->window_write && !sftpfs_sync_window (file_handler, mcerror))
+        return -1;
 
-        if (rc != LIBSSH2_ERROR_EAGAIN)
+    if (file_handler_data->window_pos == file_handler_data->window_len)
+    {
+        /* large reads don't need the window */
+        if (count >= file_handler_data->window_size)
         {
-            sftpfs_ssherror_to_gliberror (super_data, rc, mcerror);
-            return -1;
+            rc = sftpfs_read_data (file_handler, buffer, count, mcerror);
+            if (rc > 0)
+                file_handler->pos += rc;
+            return rc;
         }
 
-        sftpfs_waitsocket (super_data, mcerror);
-        mc_return_val_if_error (mcerror, -1);
+        rc = sftpfs_read_data (file_handler, file_handler_data->window,
+                               file_handler_data->window_size, mcerror);
+        if (rc <= 0)
+            return rc;
+
+        file_handler_data->window_len = (size_t) rc;
+        file_handler_data->window_pos = 0;
     }
-    while (rc == LIBSSH2_ERROR_EAGAIN);
 
-    file_handler->pos = (off_t) libssh2_sftp_tell64 (file_handler_data->handle);
+    rc = (ssize_t) MIN (count, file_handler_data->window_len - file_handler_data->window_pos);
+    memcpy (buffer, file_handler_data->window + file_handler_data->window_pos, (size_t) rc);
+    file_handler_data->window_pos += rc;
+    file_handler->pos += rc;
 
     return rc;
 }
@@ -295,35 +468,52 @@ ssize_t
 sftpfs_write_file (vfs_file_handler_t * file_handler, const char *buffer, size_t count,
                    GError ** mcerror)
 {
-    ssize_t rc;
     sftpfs_file_handler_data_t *file_handler_data;
-    sftpfs_super_data_t *super_data;
+    size_t written = 0;
 
     mc_return_val_if_error (mcerror, -1);
 
     file_handler_data = (sftpfs_file_handler_data_t *) file_handler->data;
-    super_data = (sftpfs_super_data_t *) file_handler->ino->super->data;
 
-    file_handler->pos = (off_t) libssh2_sftp_tell64 (file_handler_data->handle);
+    if (!file_handler_data->window_write)
+    {
+        /* drop data read ahead by libssh2 as well */
+        sftpfs_sync_window (file_handler, mcerror);
+        libssh2_sftp_seek64 (file_handler_data->handle, file_handler->pos);
+        file_handler_data->window_write = TRUE;
+    }
 
-    do
+    /* the data is acknowledged later, errors are reported by next writes or close */
+    while (written < count)
     {
-        rc = libssh2_sftp_write (file_handler_data->handle, buffer, count);
-        if (rc >= 0)
-            break;
+        size_t n;
 
-        if (rc != LIBSSH2_ERROR_EAGAIN)
+        if (file_handler_data->window_len == file_handler_data->window_size)
         {
-            sftpfs_ssherror_to_gliberror (super_data, rc, mcerror);
-            return -1;
+            /* wait until a half of window is free and move the rest to its beginning */
+            if (!sftpfs_push_window (file_handler, file_handler_data->window_size / 2, mcerror))
+                return -1;
+
+            file_handler_data->window_len -= file_handler_data->window_pos;
+            memmove (file_handler_data->window,
+                     file_handler_data->window + file_handler_data->window_pos,
+                     file_handler_data->window_len);
+            file_handler_data->window_pos = 0;
         }
 
-        sftpfs_waitsocket (super_data, mcerror);
-        mc_return_val_if_error (mcerror, -1);
+        n = MIN (count - written, file_handler_data->window_size - file_handler_data->window_len);
+        memcpy (file_handler_data->window + file_handler_data->window_len, buffer + written, n);
+        file_handler_data->window_len += n;
+        written += n;
     }
-    while (rc == LIBSSH2_ERROR_EAGAIN);
 
-    return rc;
+    /* send the new data and let it be acknowledged in the next calls */
+    if (!sftpfs_push_window (file_handler, file_handler_data->window_size, mcerror))
+        return -1;
+
+    file_handler->pos += written;
+
+    return (ssize_t) written;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -341,6 +531,7 @@ int
 sftpfs_close_file (vfs_file_handler_t * file_handler, GError ** mcerror)
 {
     sftpfs_file_handler_data_t *file_handler_data;
+    int rc = 0;
 
     mc_return_val_if_error (mcerror, -1);
 
@@ -348,10 +539,15 @@ sftpfs_close_file (vfs_file_handler_t * file_handler, GError ** mcerror)
     if (file_handler_data == NULL)
         return -1;
 
+    if (file_handler_data->window_write && !sftpfs_push_window (file_handler, 0, mcerror))
+        rc = -1;
+
     libssh2_sftp_close (file_handler_data->handle);
 
+    g_free (file_handler_data->window);
     g_free (file_handler_data);
-    return 0;
+    file_handler->data = NULL;
+    return rc;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -374,6 +570,9 @@ sftpfs_lseek (vfs_file_handler_t * file_handler, off_t offset, int whence, GErro
 
     mc_return_val_if_error (mcerror, 0);
 
+    sftpfs_sync_window (file_handler, mcerror);
+    mc_return_val_if_error (mcerror, 0);
+
     switch (whence)
     {
     case SEEK_SET:
@@ -14,6 +14,8 @@
 
 /*** global variables defined in .c file *********************************************************/
 
+extern int sftpfs_window_size;
+
 /*** declarations of public functions ************************************************************/
 
 void init_sftpfs (void);
@@ -53,6 +53,7 @@
 #include "lib/vfs/utilvfs.h"
 #include "lib/vfs/xdirentry.h"
 #include "lib/vfs/gc.h"         /* vfs_rmstamp */
+#include "lib/vfs/decompress.h"
 
 #include "tar.h"
 
@@ -215,6 +216,7 @@ typedef enum
 typedef struct
 {
     int fd;
+    vfs_decompress_t *stream;   /* decompressor of compressed archive, or NULL */
     struct stat st;
     int type;                   /* Type of the archive */
 } tar_super_data_t;
@@ -270,6 +272,7 @@ tar_free_archive (struct vfs_class *me, struct vfs_s_super *archive)
     {
         tar_super_data_t *arch = (tar_super_data_t *) archive->data;
 
+        vfs_decompress_close (arch->stream);
         if (arch->fd != -1)
             mc_close (arch->fd);
         g_free (archive->data);
@@ -299,13 +302,17 @@ tar_open_archive_int (struct vfs_class *me, const vfs_path_t * vpath, struct vfs
     arch = (tar_super_data_t *) archive->data;
     mc_stat (vpath, &arch->st);
     arch->fd = -1;
+    arch->stream = NULL;
     arch->type = TAR_UNKNOWN;
 
     /* Find out the method to handle this tar file */
     type = get_compression_type (result, archive->name);
-    mc_lseek (result, 0, SEEK_SET);
     if (type != COMPRESSION_NONE)
+        arch->stream = vfs_decompress_open (result, type);
+    mc_lseek (result, 0, SEEK_SET);
+    if (type != COMPRESSION_NONE && arch->stream == NULL)
     {
+        /* decompress to temporary file */
         char *s;
         vfs_path_t *tmp_vpath;
 
@@ -345,16 +352,40 @@ tar_open_archive_int (struct vfs_class *me, const vfs_path_t * vpath, struct vfs
     return result;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Read uncompressed data of the archive */
+
+static ssize_t
+tar_archive_read (tar_super_data_t * arch, char *buffer, size_t count)
+{
+    if (arch->stream != NULL)
+        return vfs_decompress_read (arch->stream, buffer, count);
+
+    return mc_read (arch->fd, buffer, count);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Set position in uncompressed data of the archive */
+
+static off_t
+tar_archive_seek (tar_super_data_t * arch, off_t offset, int whence)
+{
+    if (arch->stream != NULL)
+        return vfs_decompress_seek (arch->stream, offset, whence);
+
+    return mc_lseek (arch->fd, offset, whence);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static union record *
 tar_get_next_record (struct vfs_s_super *archive, int tard)
 {
-    int n;
+    ssize_t n;
 
-    (void) archive;
+    (void) tard;
 
-    n = mc_read (tard, rec_buf.charptr, RECORDSIZE);
+    n = tar_archive_read ((tar_super_data_t *) archive->data, rec_buf.charptr, RECORDSIZE);
     if (n != RECORDSIZE)
         return NULL;            /* An error has occurred */
     current_tar_position += RECORDSIZE;
@@ -366,9 +397,9 @@ tar_get_next_record (struct vfs_s_super *archive, int tard)
 static void
 tar_skip_n_records (struct vfs_s_super *archive, int tard, size_t n)
 {
-    (void) archive;
+    (void) tard;
 
-    mc_lseek (tard, n * RECORDSIZE, SEEK_CUR);
+    tar_archive_seek ((tar_super_data_t *) archive->data, n * RECORDSIZE, SEEK_CUR);
     current_tar_position += n * RECORDSIZE;
 }
 
@@ -755,6 +786,9 @@ tar_open_archive (struct vfs_s_super *archive, const vfs_path_t * vpath,
     /* Initial status at start of archive */
     ReadStatus status = STATUS_EOFMARK;
     int tard;
+    tar_super_data_t *arch;
+    /* the index is kept for local archives only: the stat of a remote file is not reliable */
+    const gboolean indexed = vfs_file_is_local (vpath);
 
     current_tar_position = 0;
     /* Open for reading */
@@ -762,6 +796,10 @@ tar_open_archive (struct vfs_s_super *archive, const vfs_path_t * vpath,
     if (tard == -1)
         return -1;
 
+    arch = (tar_super_data_t *) archive->data;
+    if (indexed && vfs_s_load_index (vpath_element->class, archive, &arch->st))
+        return 0;
+
     while (TRUE)
     {
         size_t h_size;
@@ -817,6 +855,10 @@ tar_open_archive (struct vfs_s_super *archive, const vfs_path_t * vpath,
         }
         break;
     }
+
+    /* the tree of an archive without the end marker may be incomplete */
+    if (indexed && status == STATUS_EOFMARK)
+        vfs_s_save_index (vpath_element->class, archive, &arch->st);
     return 0;
 }
 
@@ -865,16 +907,16 @@ static ssize_t
 tar_read (void *fh, char *buffer, size_t count)
 {
     off_t begin = FH->ino->data_offset;
-    int fd = ((tar_super_data_t *) FH_SUPER->data)->fd;
+    tar_super_data_t *arch = (tar_super_data_t *) FH_SUPER->data;
     struct vfs_class *me = FH_SUPER->me;
     ssize_t res;
 
-    if (mc_lseek (fd, begin + FH->pos, SEEK_SET) != begin + FH->pos)
+    if (tar_archive_seek (arch, begin + FH->pos, SEEK_SET) != begin + FH->pos)
         ERRNOR (EIO, -1);
 
     count = MIN (count, (size_t) (FH->ino->st.st_size - FH->pos));
 
-    res = mc_read (fd, buffer, count);
+    res = tar_archive_read (arch, buffer, count);
     if (res == -1)
         ERRNOR (errno, -1);
 
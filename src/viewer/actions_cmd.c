@@ -480,6 +480,12 @@ mcview_execute_cmd (WView * view, unsigned long command)
     case CK_Ruler:
         mcview_display_toggle_ruler (view);
         break;
+    case CK_Follow:
+        if (view->follow != NULL)
+            mcview_follow_stop (view);
+        else
+            mcview_follow_start (view);
+        break;
     case CK_Up:
         mcview_move_up (view, 1);
         break;
@@ -747,6 +753,13 @@ mcview_dialog_callback (Widget * w, Widget * sender, widget_msg_t msg, int parm,
             mcview_update (view);
         return MSG_HANDLED;
 
+    case MSG_IDLE:
+        /* build the line index while keys aren't pressed */
+        view = (WView *) find_widget_type (h, mcview_callback);
+        if (!mcview_ccache_index (view))
+            widget_want_idle (w, FALSE);
+        return MSG_HANDLED;
+
     default:
         return dlg_default_callback (w, sender, msg, parm, data);
     }
@@ -45,17 +45,24 @@
    neighbor entries. The algorithm used for determining the line/column
    for a specific offset needs to be kept synchronized with the one used
    in display().
+
+   The line index is built in the idle time of the standalone viewer:
+   files are scanned for line breaks by large blocks and a checkpoint
+   is added at the beginning of a line every VIEW_COORD_CACHE_INDEX_GRANUL
+   bytes. Lookups walk from the nearest checkpoint only, and remember
+   the position they stopped at between the checkpoints.
  */
 
 #include <config.h>
 
-#include <string.h>             /* memmove() */
+#include <string.h>             /* memchr(), memmove() */
 #ifdef MC_ENABLE_DEBUGGING_CODE
 #include <inttypes.h>           /* uintmax_t */
 #endif
 
 #include "lib/global.h"
 #include "lib/tty/tty.h"
+#include "lib/widget.h"         /* widget_want_idle() */
 #include "internal.h"
 
 /*** global variables ****************************************************************************/
@@ -65,6 +72,11 @@
 #define VIEW_COORD_CACHE_GRANUL 1024
 #define CACHE_CAPACITY_DELTA 64
 
+/* distance between the checkpoints of the line index */
+#define VIEW_COORD_CACHE_INDEX_GRANUL (16 * 1024)
+/* bytes scanned by the line indexer at once */
+#define VIEW_COORD_CACHE_INDEX_STEP (1024 * 1024)
+
 /*** file scope type declarations ****************************************************************/
 
 typedef gboolean (*cmp_func_t) (const coord_cache_entry_t * a, const coord_cache_entry_t * b);
@@ -86,18 +98,62 @@ mcview_ccache_add_entry (coord_cache_t * cache, size_t pos, const coord_cache_en
     /* increase cache capacity if needed */
     if (cache->size == cache->capacity)
     {
-        cache->capacity += CACHE_CAPACITY_DELTA;
+        cache->capacity *= 2;
         cache->cache = g_realloc (cache->cache, cache->capacity * sizeof (coord_cache_entry_t *));
     }
 
     /* insert new entry */
     if (pos != cache->size)
-        memmove (cache->cache[pos + 1], cache->cache[pos],
+        memmove (&cache->cache[pos + 1], &cache->cache[pos],
                  (cache->size - pos) * sizeof (coord_cache_entry_t *));
     cache->cache[pos] = g_memdup (entry, sizeof (coord_cache_entry_t));
     cache->size++;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Get the coordinate cache of the view, create it if needed */
+
+static coord_cache_t *
+mcview_ccache_get (WView * view)
+{
+    if (view->coord_cache == NULL)
+        view->coord_cache = coord_cache_new ();
+
+    if (view->coord_cache->size == 0)
+    {
+        coord_cache_entry_t entry;
+
+        entry.cc_offset = 0;
+        entry.cc_line = 0;
+        entry.cc_column = 0;
+        entry.cc_nroff_column = 0;
+        mcview_ccache_add_entry (view->coord_cache, 0, &entry);
+    }
+
+    return view->coord_cache;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Count a line break of the line index, add a checkpoint at the beginning of the new line
+ * if the last entry of the cache is far enough */
+
+static void
+mcview_ccache_index_newline (coord_cache_t * cache, off_t line_start)
+{
+    cache->index_line++;
+
+    if (line_start - cache->cache[cache->size - 1]->cc_offset >= VIEW_COORD_CACHE_INDEX_GRANUL)
+    {
+        coord_cache_entry_t entry;
+
+        entry.cc_offset = line_start;
+        entry.cc_line = cache->index_line;
+        entry.cc_column = 0;
+        entry.cc_nroff_column = 0;
+        mcview_ccache_add_entry (cache, cache->size, &entry);
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static gboolean
@@ -182,6 +238,8 @@ coord_cache_new (void)
     cache->size = 0;
     cache->capacity = CACHE_CAPACITY_DELTA;
     cache->cache = g_malloc0 (cache->capacity * sizeof (coord_cache_entry_t *));
+    cache->index_offset = 0;
+    cache->index_line = 0;
 
     return cache;
 }
@@ -298,19 +356,7 @@ mcview_ccache_lookup (WView * view, coord_cache_entry_t * coord, enum ccache_typ
         NROFF_CONTINUATION
     } nroff_state;
 
-    if (view->coord_cache == NULL)
-        view->coord_cache = coord_cache_new ();
-
-    cache = view->coord_cache;
-
-    if (cache->size == 0)
-    {
-        current.cc_offset = 0;
-        current.cc_line = 0;
-        current.cc_column = 0;
-        current.cc_nroff_column = 0;
-        mcview_ccache_add_entry (cache, 0, &current);
-    }
+    cache = mcview_ccache_get (view);
 
     sorter = (lookup_what == CCACHE_OFFSET) ? CCACHE_LINECOL : CCACHE_OFFSET;
 
@@ -429,12 +475,20 @@ mcview_ccache_lookup (WView * view, coord_cache_entry_t * coord, enum ccache_typ
             entry = next;
     }
 
-    if (i + 1 == cache->size && entry.cc_offset != cache->cache[i]->cc_offset)
+    if (entry.cc_offset != cache->cache[i]->cc_offset)
     {
-        mcview_ccache_add_entry (cache, cache->size, &entry);
+        if (i + 1 == cache->size)
+        {
+            mcview_ccache_add_entry (cache, cache->size, &entry);
 
-        if (!tty_got_interrupt ())
-            goto retry;
+            if (!tty_got_interrupt ())
+                goto retry;
+        }
+        else if (entry.cc_offset < cache->cache[i + 1]->cc_offset)
+        {
+            /* don't walk from the checkpoint of the line index again */
+            mcview_ccache_add_entry (cache, i + 1, &entry);
+        }
     }
 
     tty_disable_interrupt_key ();
@@ -452,3 +506,106 @@ mcview_ccache_lookup (WView * view, coord_cache_entry_t * coord, enum ccache_typ
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Extend the line index by one step. Lines are counted by the same rules as in
+ * mcview_ccache_lookup(): '\n' is a line break and '\r' is a line break unless it is
+ * followed by '\r' or '\n'. The beginning of a line is a valid cache entry in all modes:
+ * its column and nroff column are 0.
+ *
+ * @param view WView object
+ * @return TRUE if the index isn't complete yet, FALSE otherwise
+ */
+
+gboolean
+mcview_ccache_index (WView * view)
+{
+    coord_cache_t *cache;
+    const coord_cache_entry_t *last;
+    off_t offset, limit;
+
+    /* don't read the whole pipe to index it */
+    if (view->datasource != DS_FILE)
+        return FALSE;
+
+    cache = mcview_ccache_get (view);
+
+    /* lookups may get ahead of the index */
+    last = cache->cache[cache->size - 1];
+    if (last->cc_offset >= cache->index_offset)
+    {
+        cache->index_offset = last->cc_offset;
+        cache->index_line = last->cc_line;
+    }
+
+    offset = cache->index_offset;
+    limit = offset + VIEW_COORD_CACHE_INDEX_STEP;
+
+    while (offset < limit)
+    {
+        const char *block;
+        size_t len, i;
+        gboolean cr_at_end = FALSE;
+
+        block = mcview_get_block (view, offset, &len);
+        if (block == NULL)
+            break;
+
+        len = (size_t) min ((off_t) len, limit - offset);
+
+        for (i = 0; i < len; i++)
+        {
+            const char *nl, *cr;
+
+            nl = memchr (block + i, '\n', len - i);
+            cr = memchr (block + i, '\r', (nl != NULL ? (size_t) (nl - block) : len) - i);
+
+            if (cr != NULL)
+            {
+                i = (size_t) (cr - block);
+                if (i + 1 == len)
+                {
+                    /* the next byte can be out of this block */
+                    cr_at_end = TRUE;
+                    break;
+                }
+                if (block[i + 1] == '\r' || block[i + 1] == '\n')
+                    continue;
+            }
+            else if (nl != NULL)
+                i = (size_t) (nl - block);
+            else
+                break;
+
+            mcview_ccache_index_newline (cache, offset + (off_t) i + 1);
+        }
+
+        offset += (off_t) len;
+
+        if (cr_at_end)
+        {
+            int c;
+
+            mcview_get_byte (view, offset, &c);
+            if (c != '\r' && c != '\n')
+                mcview_ccache_index_newline (cache, offset);
+        }
+    }
+
+    cache->index_offset = offset;
+
+    return (offset >= limit);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Build the line index of the file in the idle time of the standalone viewer */
+
+void
+mcview_ccache_index_start (WView * view)
+{
+    Widget *w = WIDGET (view);
+
+    if (view->datasource == DS_FILE && !mcview_is_in_panel (view) && w->owner != NULL)
+        widget_want_idle (WIDGET (w->owner), TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -54,6 +54,10 @@
 
 #include <config.h>
 
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
 #include "lib/global.h"
 #include "lib/vfs/vfs.h"
 #include "lib/util.h"
@@ -65,8 +69,22 @@
 
 /*** file scope macro definitions ****************************************************************/
 
+/* size of blocks read from files that aren't mapped into memory */
+#define VIEW_FILE_PAGE_SIZE (16 * 1024)
+
+/* number of cached blocks of file that isn't mapped into memory */
+#define VIEW_FILE_PAGES 64
+
 /*** file scope type declarations ****************************************************************/
 
+typedef struct
+{
+    off_t offset;               /* offset of the block in the file */
+    size_t len;                 /* number of valid bytes in data */
+    guint stamp;                /* time of last access */
+    byte data[VIEW_FILE_PAGE_SIZE];
+} mcview_file_page_t;
+
 /*** file scope variables ************************************************************************/
 
 /* --------------------------------------------------------------------------------------------- */
@@ -87,6 +105,123 @@ mcview_set_datasource_stdio_pipe (WView * view, mc_pipe_t * p)
     mcview_growbuf_init (view);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Map the whole file into memory. Only files of local filesystem can be mapped.
+ *
+ * @return TRUE if file was mapped, FALSE otherwise
+ */
+
+static gboolean
+mcview_file_map (WView * view, off_t size)
+{
+#ifdef HAVE_MMAP
+    int *fd;
+    void *map;
+
+    if (mcview_use_mmap == 0 || size <= 0 || (off_t) (size_t) size != size)
+        return FALSE;
+
+    fd = vfs_local_fd_find_by_handle (view->ds_file_fd);
+    if (fd == NULL)
+        return FALSE;
+
+    map = mmap (NULL, (size_t) size, PROT_READ, MAP_SHARED, *fd, 0);
+    if (map == MAP_FAILED)
+        return FALSE;
+
+#ifdef HAVE_MADVISE
+    /* file is mostly paged through forwards */
+    (void) madvise (map, (size_t) size, MADV_SEQUENTIAL);
+#endif
+
+    view->ds_file_map = (byte *) map;
+    view->ds_file_maplen = (size_t) size;
+    view->ds_file_offset = 0;
+    view->ds_file_data = view->ds_file_map;
+    view->ds_file_datalen = view->ds_file_maplen;
+
+    return TRUE;
+#else
+    (void) view;
+    (void) size;
+
+    return FALSE;
+#endif /* HAVE_MMAP */
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+mcview_file_unmap (WView * view)
+{
+#ifdef HAVE_MMAP
+    if (view->ds_file_map != NULL)
+        munmap (view->ds_file_map, view->ds_file_maplen);
+#endif
+
+    view->ds_file_map = NULL;
+    view->ds_file_maplen = 0;
+    view->ds_file_data = NULL;
+    view->ds_file_datalen = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find cached block of file at specified offset. If there is no such block, the free one or
+ * the least recently used one is returned with zero length.
+ */
+
+static mcview_file_page_t *
+mcview_file_page_get (WView * view, off_t blockoffset)
+{
+    mcview_file_page_t *lru = NULL;
+    guint i;
+
+    if (view->ds_file_pages == NULL)
+        view->ds_file_pages = g_ptr_array_sized_new (VIEW_FILE_PAGES);
+
+    for (i = 0; i < view->ds_file_pages->len; i++)
+    {
+        mcview_file_page_t *page;
+
+        page = (mcview_file_page_t *) g_ptr_array_index (view->ds_file_pages, i);
+        if (page->len != 0 && page->offset == blockoffset)
+            return page;
+        /* prefer blocks that don't hold data */
+        if (lru == NULL || (lru->len != 0 && (page->len == 0 || page->stamp < lru->stamp)))
+            lru = page;
+    }
+
+    if (view->ds_file_pages->len < VIEW_FILE_PAGES)
+    {
+        lru = g_new (mcview_file_page_t, 1);
+        g_ptr_array_add (view->ds_file_pages, lru);
+    }
+
+    lru->offset = blockoffset;
+    lru->len = 0;
+    lru->stamp = 0;
+
+    return lru;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+mcview_file_pages_free (WView * view)
+{
+    if (view->ds_file_pages != NULL)
+    {
+        g_ptr_array_foreach (view->ds_file_pages, (GFunc) g_free, NULL);
+        g_ptr_array_free (view->ds_file_pages, TRUE);
+        view->ds_file_pages = NULL;
+    }
+
+    view->ds_file_data = NULL;
+    view->ds_file_datalen = 0;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -130,7 +265,13 @@ mcview_update_filesize (WView * view)
     {
         struct stat st;
         if (mc_fstat (view->ds_file_fd, &st) != -1)
+        {
             view->ds_file_filesize = st.st_size;
+
+            /* don't touch mapped pages beyond the end of truncated file */
+            if (view->ds_file_map != NULL && (off_t) view->ds_file_datalen > st.st_size)
+                view->ds_file_datalen = (size_t) MAX (st.st_size, 0);
+        }
     }
 }
 
@@ -143,7 +284,8 @@ mcview_get_ptr_file (WView * view, off_t byte_index)
     assert (view->datasource == DS_FILE);
 #endif
 
-    mcview_file_load_data (view, byte_index);
+    if (!mcview_already_loaded (view->ds_file_offset, byte_index, view->ds_file_datalen))
+        mcview_file_load_data (view, byte_index);
     if (mcview_already_loaded (view->ds_file_offset, byte_index, view->ds_file_datalen))
         return (char *) (view->ds_file_data + (byte_index - view->ds_file_offset));
     return NULL;
@@ -235,6 +377,48 @@ mcview_get_ptr_string (WView * view, off_t byte_index)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Get pointer to the contiguous data of datasource at specified index.
+ *
+ * @param view WView object
+ * @param byte_index index of first byte
+ * @param len length of data available by returned pointer
+ * @return pointer to the data or NULL if byte_index is out of data
+ */
+
+char *
+mcview_get_block (WView * view, off_t byte_index, size_t * len)
+{
+    char *p = NULL;
+
+    *len = 0;
+
+    switch (view->datasource)
+    {
+    case DS_STDIO_PIPE:
+    case DS_VFS_PIPE:
+        p = mcview_get_block_growing_buffer (view, byte_index, len);
+        break;
+    case DS_FILE:
+        p = mcview_get_ptr_file (view, byte_index);
+        if (p != NULL)
+            *len = (size_t) (view->ds_file_offset + (off_t) view->ds_file_datalen - byte_index);
+        break;
+    case DS_STRING:
+        p = mcview_get_ptr_string (view, byte_index);
+        if (p != NULL)
+            *len = view->ds_string_len - (size_t) byte_index;
+        break;
+    case DS_NONE:
+    default:
+        break;
+    }
+
+    return p;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 gboolean
 mcview_get_byte_string (WView * view, off_t byte_index, int *retval)
 {
@@ -275,22 +459,39 @@ void
 mcview_set_byte (WView * view, off_t offset, byte b)
 {
     (void) &b;
-#ifndef HAVE_ASSERT_H
-    (void) offset;
-#else
+#ifdef HAVE_ASSERT_H
     assert (offset < mcview_get_filesize (view));
     assert (view->datasource == DS_FILE);
-
 #endif
-    view->ds_file_datalen = 0;  /* just force reloading */
+
+    /* shared mapping sees changes of file, cached block should be reloaded */
+    if (view->ds_file_map == NULL)
+    {
+        guint i;
+
+        for (i = 0; view->ds_file_pages != NULL && i < view->ds_file_pages->len; i++)
+        {
+            mcview_file_page_t *page;
+
+            page = (mcview_file_page_t *) g_ptr_array_index (view->ds_file_pages, i);
+            if (mcview_already_loaded (page->offset, offset, page->len))
+                page->len = 0;
+        }
+        view->ds_file_datalen = 0;
+    }
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Make the block containing specified offset the current data of file datasource.
+ * Mapped file is remapped if it has grown. Otherwise the block is taken from the cache
+ * or read from file.
+ */
 
-/*static */
 void
 mcview_file_load_data (WView * view, off_t byte_index)
 {
+    mcview_file_page_t *page;
     off_t blockoffset;
     ssize_t res;
     size_t bytes_read;
@@ -305,38 +506,86 @@ mcview_file_load_data (WView * view, off_t byte_index)
     if (byte_index >= view->ds_file_filesize)
         return;
 
+    if (view->ds_file_map != NULL)
+    {
+        if (byte_index < (off_t) view->ds_file_maplen)
+        {
+            /* the file was truncated and has grown again */
+            view->ds_file_datalen = MIN (view->ds_file_maplen, (size_t) view->ds_file_filesize);
+            return;
+        }
+
+        /* the file has grown in the meantime */
+        mcview_file_unmap (view);
+        if (mcview_file_map (view, view->ds_file_filesize))
+            return;
+    }
+
     blockoffset = mcview_offset_rounddown (byte_index, view->ds_file_datasize);
-    if (mc_lseek (view->ds_file_fd, blockoffset, SEEK_SET) == -1)
-        goto error;
+    page = mcview_file_page_get (view, blockoffset);
 
-    bytes_read = 0;
-    while (bytes_read < view->ds_file_datasize)
+    if (!mcview_already_loaded (page->offset, byte_index, page->len))
     {
-        res =
-            mc_read (view->ds_file_fd, view->ds_file_data + bytes_read,
-                     view->ds_file_datasize - bytes_read);
-        if (res == -1)
+        page->len = 0;
+
+        if (mc_lseek (view->ds_file_fd, blockoffset, SEEK_SET) == -1)
             goto error;
-        if (res == 0)
-            break;
-        bytes_read += (size_t) res;
-    }
-    view->ds_file_offset = blockoffset;
-    if ((off_t) bytes_read > view->ds_file_filesize - view->ds_file_offset)
-    {
-        /* the file has grown in the meantime -- stick to the old size */
-        view->ds_file_datalen = view->ds_file_filesize - view->ds_file_offset;
-    }
-    else
-    {
-        view->ds_file_datalen = bytes_read;
+
+        bytes_read = 0;
+        while (bytes_read < view->ds_file_datasize)
+        {
+            res =
+                mc_read (view->ds_file_fd, page->data + bytes_read,
+                         view->ds_file_datasize - bytes_read);
+            if (res == -1)
+                goto error;
+            if (res == 0)
+                break;
+            bytes_read += (size_t) res;
+        }
+
+        if ((off_t) bytes_read > view->ds_file_filesize - blockoffset)
+        {
+            /* the file has grown in the meantime -- stick to the old size */
+            page->len = view->ds_file_filesize - blockoffset;
+        }
+        else
+        {
+            page->len = bytes_read;
+        }
     }
+
+    page->stamp = ++view->ds_file_pages_clock;
+    view->ds_file_offset = page->offset;
+    view->ds_file_data = page->data;
+    view->ds_file_datalen = page->len;
     return;
 
   error:
     view->ds_file_datalen = 0;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Drop data loaded from file, e.g. after the file was truncated.
+ */
+
+void
+mcview_file_reset_data (WView * view)
+{
+#ifdef HAVE_ASSERT_H
+    assert (view->datasource == DS_FILE);
+#endif
+
+    if (view->ds_file_map != NULL)
+    {
+        mcview_file_unmap (view);
+        mcview_file_map (view, view->ds_file_filesize);
+    }
+    else
+        mcview_file_pages_free (view);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -360,9 +609,12 @@ mcview_close_datasource (WView * view)
         mcview_growbuf_free (view);
         break;
     case DS_FILE:
+        if (view->ds_file_map != NULL)
+            mcview_file_unmap (view);
+        else
+            mcview_file_pages_free (view);
         (void) mc_close (view->ds_file_fd);
         view->ds_file_fd = -1;
-        MC_PTR_FREE (view->ds_file_data);
         break;
     case DS_STRING:
         MC_PTR_FREE (view->ds_string_data);
@@ -385,9 +637,15 @@ mcview_set_datasource_file (WView * view, int fd, const struct stat *st)
     view->ds_file_fd = fd;
     view->ds_file_filesize = st->st_size;
     view->ds_file_offset = 0;
-    view->ds_file_data = g_malloc (4096);
+    view->ds_file_data = NULL;
     view->ds_file_datalen = 0;
-    view->ds_file_datasize = 4096;
+    view->ds_file_datasize = VIEW_FILE_PAGE_SIZE;
+    view->ds_file_map = NULL;
+    view->ds_file_maplen = 0;
+    view->ds_file_pages = NULL;
+    view->ds_file_pages_clock = 0;
+
+    mcview_file_map (view, st->st_size);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -177,7 +177,7 @@ mcview_display_status (WView * view)
             size_trunc_len (buffer, BUF_TRUNC_LEN, mcview_get_filesize (view), 0,
                             panels_options.kilobyte_si);
             tty_printf ("%9" PRIuMAX "/%s%s %s", (uintmax_t) view->dpy_end,
-                        buffer, mcview_may_still_grow (view) ? "+" : " ",
+                        buffer, mcview_may_still_grow (view) || view->follow != NULL ? "+" : " ",
 #ifdef HAVE_CHARSET
                         mc_global.source_codepage >= 0 ?
                         get_codepage_id (mc_global.source_codepage) :
@@ -0,0 +1,391 @@
+/*
+   Internal file viewer for the Midnight Commander
+   Following of growing files
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+   In follow mode the viewer shows data appended to the file like "tail -f".
+
+   Local files are watched with inotify where it is available, so nothing is
+   done while the file is idle. Other files are polled: a ticker thread wakes up
+   the main loop through a pipe once per MCVIEW_FOLLOW_INTERVAL.
+
+   When the file grows, only the file size is updated: the datasource loads
+   the new data from the old end on demand and the coordinate cache stays
+   valid. When the file is truncated or replaced by another file (log
+   rotation), the viewer starts from the beginning of the new data.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+#include "lib/global.h"
+#include "lib/tty/key.h"        /* add_select_channel(), delete_select_channel() */
+#include "lib/vfs/vfs.h"
+#include "lib/widget.h"         /* message(), mc_refresh() */
+
+#include "internal.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* interval of polling of files that can't be watched, in microseconds */
+#define MCVIEW_FOLLOW_INTERVAL G_USEC_PER_SEC
+
+/*** file scope type declarations ****************************************************************/
+
+struct mcview_follow_struct
+{
+    int fd;                     /* descriptor watched in the main loop */
+    int watch;                  /* inotify watch of the file or -1 if file is polled */
+    int ticker_pipe[2];         /* pipe written by the ticker thread */
+    GThread *ticker;            /* thread waking up the main loop to poll the file */
+    GAsyncQueue *ticker_stop;   /* message to this queue stops the ticker */
+};
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static gpointer
+mcview_follow_ticker (gpointer data)
+{
+    mcview_follow_t *follow = (mcview_follow_t *) data;
+
+    while (g_async_queue_timeout_pop (follow->ticker_stop, MCVIEW_FOLLOW_INTERVAL) == NULL)
+    {
+        /* pipe is full if the main loop is busy: one pending tick is enough */
+        if (write (follow->ticker_pipe[1], "", 1) == -1 && errno != EAGAIN && errno != EINTR)
+            break;
+    }
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+mcview_follow_ticker_start (mcview_follow_t * follow)
+{
+    if (pipe (follow->ticker_pipe) == -1)
+        return FALSE;
+
+    fcntl (follow->ticker_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl (follow->ticker_pipe[1], F_SETFL, O_NONBLOCK);
+
+    follow->ticker_stop = g_async_queue_new ();
+    follow->ticker = g_thread_try_new ("mcview_follow", mcview_follow_ticker, follow, NULL);
+    if (follow->ticker == NULL)
+    {
+        g_async_queue_unref (follow->ticker_stop);
+        follow->ticker_stop = NULL;
+        close (follow->ticker_pipe[0]);
+        close (follow->ticker_pipe[1]);
+        return FALSE;
+    }
+
+    follow->fd = follow->ticker_pipe[0];
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Watch the file with inotify if @use_inotify is TRUE and the file is local, otherwise
+ * start polling.
+ */
+
+static gboolean
+mcview_follow_watch_start (WView * view, mcview_follow_t * follow, gboolean use_inotify)
+{
+    follow->fd = -1;
+    follow->watch = -1;
+
+#ifdef HAVE_SYS_INOTIFY_H
+    if (use_inotify && vfs_file_is_local (view->filename_vpath))
+    {
+        follow->fd = inotify_init ();
+        if (follow->fd != -1)
+        {
+            follow->watch =
+                inotify_add_watch (follow->fd, vfs_path_as_str (view->filename_vpath),
+                                   IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+            if (follow->watch == -1)
+            {
+                close (follow->fd);
+                follow->fd = -1;
+            }
+            else
+                fcntl (follow->fd, F_SETFL, O_NONBLOCK);
+        }
+    }
+#else
+    (void) view;
+    (void) use_inotify;
+#endif /* HAVE_SYS_INOTIFY_H */
+
+    if (follow->fd == -1 && !mcview_follow_ticker_start (follow))
+        return FALSE;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+mcview_follow_watch_stop (mcview_follow_t * follow)
+{
+    if (follow->fd == -1)
+        return;
+
+    delete_select_channel (follow->fd);
+
+    if (follow->ticker != NULL)
+    {
+        g_async_queue_push (follow->ticker_stop, GINT_TO_POINTER (1));
+        g_thread_join (follow->ticker);
+        follow->ticker = NULL;
+        g_async_queue_unref (follow->ticker_stop);
+        follow->ticker_stop = NULL;
+        close (follow->ticker_pipe[1]);
+    }
+
+    /* closing of inotify descriptor removes the watch */
+    close (follow->fd);
+    follow->fd = -1;
+    follow->watch = -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check if the file name refers to another file than the viewed one.
+ * File that was moved away or removed and isn't created again is still viewed.
+ */
+
+static gboolean
+mcview_follow_is_rotated (WView * view)
+{
+    struct stat st_fd, st_path;
+
+    if (mc_fstat (view->ds_file_fd, &st_fd) == -1)
+        return TRUE;
+    if (mc_stat (view->filename_vpath, &st_path) == -1)
+        return FALSE;
+
+    return (st_fd.st_ino != st_path.st_ino || st_fd.st_dev != st_path.st_dev);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+mcview_follow_reopen (WView * view)
+{
+    int fd;
+    struct stat st;
+
+    fd = mc_open (view->filename_vpath, O_RDONLY | O_NONBLOCK);
+    if (fd == -1)
+        return FALSE;
+
+    if (mc_fstat (fd, &st) == -1 || !S_ISREG (st.st_mode))
+    {
+        mc_close (fd);
+        return FALSE;
+    }
+
+    mcview_close_datasource (view);
+    mcview_set_datasource_file (view, fd, &st);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** Show the new data from the beginning after the file was truncated or replaced */
+
+static void
+mcview_follow_reset (WView * view)
+{
+    coord_cache_free (view->coord_cache);
+    view->coord_cache = NULL;
+
+    view->dpy_start = 0;
+    view->dpy_paragraph_skip_lines = 0;
+    mcview_state_machine_init (&view->dpy_state_top, 0);
+    view->dpy_wrap_dirty = TRUE;
+    view->hex_cursor = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+mcview_follow_update (WView * view)
+{
+    mcview_follow_t *follow = view->follow;
+    off_t filesize;
+    gboolean at_bottom;
+    gboolean reset = FALSE;
+    gboolean rewatch = FALSE;
+    struct stat st;
+
+    filesize = mcview_get_filesize (view);
+    if (view->hex_mode)
+        at_bottom = view->hex_cursor + 1 >= filesize;
+    else
+        at_bottom = view->dpy_end >= filesize;
+
+    if (mcview_follow_is_rotated (view) && mcview_follow_reopen (view))
+    {
+        /* watch the new file */
+        reset = TRUE;
+        rewatch = TRUE;
+    }
+    else if (follow->watch != -1 && mc_stat (view->filename_vpath, &st) == -1)
+    {
+        /* file was moved away: inotify doesn't report creation of the new one, poll for it */
+        rewatch = TRUE;
+    }
+
+    if (rewatch)
+    {
+        mcview_follow_watch_stop (follow);
+        if (!mcview_follow_watch_start (view, follow, reset))
+        {
+            mcview_follow_stop (view);
+            return;
+        }
+        add_select_channel (follow->fd, mcview_follow_callback, view);
+    }
+
+    if (!reset)
+    {
+        mcview_update_filesize (view);
+        if (mcview_get_filesize (view) < filesize)
+        {
+            /* truncated */
+            mcview_file_reset_data (view);
+            reset = TRUE;
+        }
+    }
+
+    if (reset)
+    {
+        mcview_follow_reset (view);
+        at_bottom = TRUE;
+    }
+    else if (mcview_get_filesize (view) == filesize)
+        return;
+
+    mcview_ccache_index_start (view);
+
+    if (at_bottom)
+        mcview_moveto_bottom (view);
+
+    view->dirty++;
+
+    /* the file may change while a dialog is over the viewer or the viewer is in background:
+       then it is redrawn when it gets the focus again */
+    if (top_dlg != NULL && DIALOG (top_dlg->data) == WIDGET (view)->owner)
+    {
+        mcview_display (view);
+        mc_refresh ();
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/** Called from the main loop when the file may have changed */
+
+int
+mcview_follow_callback (int fd, void *info)
+{
+    char buf[4096];
+
+    /* drop the notifications, file is checked once for all of them */
+    while (read (fd, buf, sizeof (buf)) > 0)
+        ;
+
+    mcview_follow_update ((WView *) info);
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+gboolean
+mcview_follow_start (WView * view)
+{
+    mcview_follow_t *follow;
+
+    if (view->follow != NULL)
+        return TRUE;
+
+    /* empty file is opened as a pipe: reopen it as a file to see the data appended to it */
+    if (view->filename_vpath != NULL && view->datasource == DS_VFS_PIPE
+        && view->growbuf_finished && mcview_get_filesize (view) == 0)
+        mcview_follow_reopen (view);
+
+    if (view->filename_vpath == NULL || view->datasource != DS_FILE)
+    {
+        message (D_ERROR, MSG_ERROR, _("Follow mode is available for regular files only"));
+        return FALSE;
+    }
+
+    follow = g_new0 (mcview_follow_t, 1);
+    if (!mcview_follow_watch_start (view, follow, TRUE))
+    {
+        g_free (follow);
+        message (D_ERROR, MSG_ERROR, _("Cannot watch the file for changes"));
+        return FALSE;
+    }
+
+    view->follow = follow;
+    add_select_channel (follow->fd, mcview_follow_callback, view);
+
+    mcview_update_filesize (view);
+    mcview_moveto_bottom (view);
+    view->dirty++;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+mcview_follow_stop (WView * view)
+{
+    if (view->follow == NULL)
+        return;
+
+    mcview_follow_watch_stop (view->follow);
+    MC_PTR_FREE (view->follow);
+    view->dirty++;
+}
+
+/* --------------------------------------------------------------------------------------------- */
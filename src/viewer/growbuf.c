@@ -302,3 +302,33 @@ mcview_get_ptr_growing_buffer (WView * view, off_t byte_index)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Get pointer to the data of growing buffer at specified index and length of
+ * the data available by this pointer without crossing the page boundary.
+ */
+
+char *
+mcview_get_block_growing_buffer (WView * view, off_t byte_index, size_t * len)
+{
+    char *p;
+    off_t pageno, pageindex;
+
+    *len = 0;
+
+    p = mcview_get_ptr_growing_buffer (view, byte_index);
+    if (p == NULL)
+        return NULL;
+
+    pageno = byte_index / VIEW_PAGE_SIZE;
+    pageindex = byte_index % VIEW_PAGE_SIZE;
+
+    if (pageno < (off_t) view->growbuf_blockptr->len - 1)
+        *len = VIEW_PAGE_SIZE - pageindex;
+    else
+        *len = view->growbuf_lastindex - pageindex;
+
+    return p;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -85,6 +85,8 @@ typedef struct
     size_t size;
     size_t capacity;
     coord_cache_entry_t **cache;
+    off_t index_offset;         /* the line index is built up to this offset */
+    off_t index_line;           /* line at index_offset */
 } coord_cache_t;
 
 /* TODO: find a better name. This is not actually a "state machine",
@@ -101,6 +103,8 @@ typedef struct
 
 struct mcview_nroff_struct;
 
+typedef struct mcview_follow_struct mcview_follow_t;
+
 struct WView
 {
     Widget widget;
@@ -124,7 +128,11 @@ struct WView
     off_t ds_file_offset;       /* Offset of the currently loaded data */
     byte *ds_file_data;         /* Currently loaded data */
     size_t ds_file_datalen;     /* Number of valid bytes in file_data */
-    size_t ds_file_datasize;    /* Number of allocated bytes in file_data */
+    size_t ds_file_datasize;    /* Size of blocks loaded into file_data */
+    byte *ds_file_map;          /* Whole file mapped into memory or NULL */
+    size_t ds_file_maplen;      /* Length of the mapping */
+    GPtrArray *ds_file_pages;   /* Cache of blocks read from file that isn't mapped */
+    guint ds_file_pages_clock;  /* Time of last access to the cache, for LRU eviction */
 
     /* string data source */
     byte *ds_string_data;       /* The characters of the string */
@@ -153,6 +161,8 @@ struct WView
 
     coord_cache_t *coord_cache; /* Cache for mapping offsets to cursor positions */
 
+    mcview_follow_t *follow;    /* Follow mode state or NULL if file isn't followed */
+
     /* Display information */
     gboolean active;            /* Active or not in QuickView mode */
     screen_dimen dpy_frame_size;        /* Size of the frame surrounding the real viewer */
@@ -258,6 +268,8 @@ void mcview_ccache_dump (WView * view);
 #endif
 
 void mcview_ccache_lookup (WView * view, coord_cache_entry_t * coord, enum ccache_type lookup_what);
+gboolean mcview_ccache_index (WView * view);
+void mcview_ccache_index_start (WView * view);
 
 /* datasource.c: */
 void mcview_set_datasource_none (WView *);
@@ -265,11 +277,13 @@ off_t mcview_get_filesize (WView *);
 void mcview_update_filesize (WView * view);
 char *mcview_get_ptr_file (WView *, off_t);
 char *mcview_get_ptr_string (WView *, off_t);
+char *mcview_get_block (WView * view, off_t byte_index, size_t * len);
 int mcview_get_utf (WView *, off_t, int *, gboolean *);
 gboolean mcview_get_byte_string (WView *, off_t, int *);
 gboolean mcview_get_byte_none (WView *, off_t, int *);
 void mcview_set_byte (WView *, off_t, byte);
 void mcview_file_load_data (WView *, off_t);
+void mcview_file_reset_data (WView * view);
 void mcview_close_datasource (WView *);
 void mcview_set_datasource_file (WView *, int, const struct stat *);
 gboolean mcview_load_command_output (WView *, const char *);
@@ -289,6 +303,11 @@ void mcview_display_toggle_ruler (WView * view);
 void mcview_display_clean (WView * view);
 void mcview_display_ruler (WView * view);
 
+/* follow.c: */
+int mcview_follow_callback (int fd, void *info);
+gboolean mcview_follow_start (WView * view);
+void mcview_follow_stop (WView * view);
+
 /* growbuf.c: */
 void mcview_growbuf_init (WView * view);
 void mcview_growbuf_done (WView * view);
@@ -297,6 +316,7 @@ off_t mcview_growbuf_filesize (WView * view);
 void mcview_growbuf_read_until (WView * view, off_t p);
 gboolean mcview_get_byte_growing_buffer (WView * view, off_t p, int *);
 char *mcview_get_ptr_growing_buffer (WView * view, off_t p);
+char *mcview_get_block_growing_buffer (WView * view, off_t byte_index, size_t * len);
 
 /* hex.c: */
 void mcview_display_hex (WView * view);
@@ -348,6 +368,8 @@ int mcview_nroff_seq_prev (mcview_nroff_t *);
 /* search.c: */
 mc_search_cbret_t mcview_search_cmd_callback (const void *user_data, gsize char_offset,
                                               int *current_char);
+mc_search_cbret_t mcview_search_cmd_block_callback (const void *user_data, gsize char_offset,
+                                                    const char **block, gsize * block_len);
 mc_search_cbret_t mcview_search_update_cmd_callback (const void *user_data, gsize char_offset);
 void mcview_do_search (WView * view, off_t want_search_start);
 
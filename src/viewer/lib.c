@@ -232,6 +232,7 @@ mcview_done (WView * view)
     view->workdir_vpath = NULL;
     MC_PTR_FREE (view->command);
 
+    mcview_follow_stop (view);
     mcview_close_datasource (view);
     /* the growing buffer is freed with the datasource */
 
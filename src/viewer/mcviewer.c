@@ -62,6 +62,9 @@ int mcview_altered_nroff_flag = 0;
 
 int mcview_remember_file_position = FALSE;
 
+/* Map local files into memory instead of reading them by blocks */
+int mcview_use_mmap = 0;
+
 /* Maxlimit for skipping updates */
 int mcview_max_dirt_limit = 10;
 
@@ -449,6 +452,9 @@ mcview_load (WView * view, const char *command, const char *file, int start_line
     view->hexview_in_text = FALSE;
     view->change_list = NULL;
     vfs_path_free (vpath);
+
+    mcview_ccache_index_start (view);
+
     return retval;
 }
 
@@ -28,6 +28,7 @@ extern int mcview_altered_magic_flag;
 extern int mcview_altered_nroff_flag;
 
 extern int mcview_remember_file_position;
+extern int mcview_use_mmap;
 extern int mcview_max_dirt_limit;
 
 extern int mcview_mouse_move_pages;
@@ -37,6 +37,7 @@
 
 #include "lib/global.h"
 #include "lib/strutil.h"
+#include "lib/util.h"           /* MC_PTR_FREE */
 #include "lib/widget.h"
 
 #include "src/setup.h"
@@ -47,6 +48,9 @@
 
 /*** file scope macro definitions ****************************************************************/
 
+/* size of the window scanned by the forward engine during backward search */
+#define MCVIEW_SEARCH_BACKWARD_WINDOW (64 * 1024)
+
 /*** file scope type declarations ****************************************************************/
 
 typedef struct
@@ -116,6 +120,136 @@ mcview_search_update_steps (WView * view)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Find start of the line containing specified offset.
+ */
+
+static off_t
+mcview_search_line_start (WView * view, off_t offset)
+{
+    int c;
+
+    while (offset > 0 && mcview_get_byte (view, offset - 1, &c) && c != '\n')
+        offset--;
+
+    return offset;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find offset of the newline ending the line containing specified offset.
+ *
+ * @return offset of the newline or @limit if there is no newline before it
+ */
+
+static off_t
+mcview_search_line_end (WView * view, off_t offset, off_t limit)
+{
+    while (offset < limit)
+    {
+        const char *p, *eol;
+        size_t len;
+
+        p = mcview_get_block (view, offset, &len);
+        if (p == NULL)
+            break;
+
+        len = MIN (len, (size_t) (limit - offset));
+        eol = memchr (p, '\n', len);
+        if (eol != NULL)
+            return offset + (eol - p);
+
+        offset += len;
+    }
+
+    return limit;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the last match starting at or before @search_start.
+ *
+ * Data is scanned backwards by windows.  The forward engine finds the last match starting
+ * in each window; matches may run past the window end.  Regular expressions are matched
+ * within a line, so windows of them are aligned to line starts.
+ */
+
+static gboolean
+mcview_find_backward (mcview_search_status_msg_t * ssm, off_t search_start, gsize * len)
+{
+    WView *view = ssm->view;
+    mc_search_t *search = view->search;
+    status_msg_t *sm = STATUS_MSG (ssm);
+    gboolean is_fixed;
+    off_t filesize, max_len = 0;
+
+    is_fixed = mc_search_is_fixed_search_str (search);
+    filesize = mcview_get_filesize (view);
+
+    /* the string recoded to other charsets may be longer */
+    if (is_fixed)
+        max_len = (off_t) mc_search_get_fixed_max_len (search);
+
+    while (search_start >= 0)
+    {
+        off_t window_start, window_end, offset;
+        off_t found = -1;
+        gsize found_len = 0;
+
+        window_start = MAX (0, search_start - MCVIEW_SEARCH_BACKWARD_WINDOW + 1);
+        if (!is_fixed)
+            window_start = mcview_search_line_start (view, window_start);
+
+        if (is_fixed)
+            window_end = MIN (filesize, search_start + max_len);
+        else
+            window_end = mcview_search_line_end (view, search_start, filesize);
+
+        for (offset = window_start; offset <= search_start; offset = search->normal_offset + 1)
+        {
+            gsize match_len;
+
+            if (!mc_search_run (search, (void *) ssm, offset, window_end, &match_len))
+            {
+                /* stop if search was aborted by user */
+                if (search->error_str == NULL)
+                    return FALSE;
+                break;
+            }
+
+            if (search->normal_offset > search_start)
+                break;
+
+            found = search->normal_offset;
+            found_len = match_len;
+        }
+
+        if (found >= 0)
+        {
+            search->normal_offset = found;
+            search->error = MC_SEARCH_E_OK;
+            MC_PTR_FREE (search->error_str);
+            *len = found_len;
+            return TRUE;
+        }
+
+        search_start = window_start - 1;
+
+        ssm->offset = window_start;
+        if (sm->update (sm) == B_CANCEL)
+        {
+            MC_PTR_FREE (search->error_str);
+            return FALSE;
+        }
+    }
+
+    g_free (search->error_str);
+    search->error_str = g_strdup (_("Search string not found"));
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static gboolean
 mcview_find (mcview_search_status_msg_t * ssm, off_t search_start, off_t search_end, gsize * len)
 {
@@ -124,23 +258,34 @@ mcview_find (mcview_search_status_msg_t * ssm, off_t search_start, off_t search_
     view->search_numNeedSkipChar = 0;
     search_cb_char_curr_index = -1;
 
+    /* nroff sequences are decoded byte by byte, raw data is searched by blocks */
+    view->search->search_block_fn = view->text_nroff_mode ? NULL : mcview_search_cmd_block_callback;
+
+    if (mcview_search_options.backwards && !view->text_nroff_mode)
+        return mcview_find_backward (ssm, search_start, len);
+
     if (mcview_search_options.backwards)
     {
+        off_t max_len;
+
+        /* offsets of nroff text don't map to the searched characters, try each start */
         search_end = mcview_get_filesize (view);
+        max_len = search_end;
+        if (mc_search_is_fixed_search_str (view->search))
+            max_len = (off_t) mc_search_get_fixed_max_len (view->search);
+
         while (search_start >= 0)
         {
             view->search_nroff_seq->index = search_start;
             mcview_nroff_seq_info (view->search_nroff_seq);
 
-            if (search_end > search_start + (off_t) view->search->original_len
-                && mc_search_is_fixed_search_str (view->search))
-                search_end = search_start + view->search->original_len;
+            if (search_end > search_start + max_len)
+                search_end = search_start + max_len;
 
             if (mc_search_run (view->search, (void *) ssm, search_start, search_end, len)
                 && view->search->normal_offset == search_start)
             {
-                if (view->text_nroff_mode)
-                    view->search->normal_offset++;
+                view->search->normal_offset++;
                 return TRUE;
             }
 
@@ -238,6 +383,27 @@ mcview_search_cmd_callback (const void *user_data, gsize char_offset, int *curre
 
 /* --------------------------------------------------------------------------------------------- */
 
+mc_search_cbret_t
+mcview_search_cmd_block_callback (const void *user_data, gsize char_offset, const char **block,
+                                  gsize * block_len)
+{
+    WView *view = ((mcview_search_status_msg_t *) user_data)->view;
+    size_t len;
+
+    *block = mcview_get_block (view, (off_t) char_offset, &len);
+    if (*block == NULL || len == 0)
+    {
+        /* stop search symbol, like mcview_search_cmd_callback() returns beyond the data */
+        *block = "\n";
+        len = 1;
+    }
+
+    *block_len = len;
+    return MC_SEARCH_CB_OK;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 mc_search_cbret_t
 mcview_search_update_cmd_callback (const void *user_data, gsize char_offset)
 {
@@ -0,0 +1,178 @@
+/*
+   libmc - checks for search of fixed strings
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "lib/search/normal"
+
+#include "tests/mctest.h"
+
+#include "normal.c"             /* for testing static functions */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_literal_find_ds") */
+/* *INDENT-OFF* */
+static const struct test_literal_find_ds
+{
+    const char *pattern;
+    gboolean is_case_sensitive;
+    const char *text;
+    int expected_offset;
+} test_literal_find_ds[] =
+{
+    { /* 0. */
+        "a",
+        TRUE,
+        "bbbab",
+        3
+    },
+    { /* 1. */
+        "needle",
+        TRUE,
+        "haystack with needle inside",
+        14
+    },
+    { /* 2. */
+        "needle",
+        TRUE,
+        "haystack with NEEDLE inside",
+        -1
+    },
+    { /* 3. */
+        "NeEdLe",
+        FALSE,
+        "haystack with needle inside",
+        14
+    },
+    { /* 4. */
+        "abcab",
+        FALSE,
+        "ABCAxabCAB",
+        5
+    },
+    { /* 5. */
+        "tail",
+        FALSE,
+        "at the TAIL",
+        7
+    },
+    { /* 6. */
+        "longer than text",
+        TRUE,
+        "short",
+        -1
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_literal_find_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_literal_find, test_literal_find_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    mc_search_t search;
+    GString *pattern;
+    mc_search_literal_t *literal;
+    const char *found;
+
+    memset (&search, 0, sizeof (search));
+    search.is_case_sensitive = data->is_case_sensitive;
+    pattern = g_string_new (data->pattern);
+
+    /* when */
+    literal = mc_search__literal_new (&search, pattern);
+    found = mc_search__literal_find (literal, data->text, strlen (data->text));
+
+    /* then */
+    if (data->expected_offset < 0)
+        mctest_assert_null (found);
+    else
+        mctest_assert_int_eq (found - data->text, data->expected_offset);
+
+    mc_search__literal_free (literal);
+    g_string_free (pattern, TRUE);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_literal_new_rejected)
+/* *INDENT-ON* */
+{
+    /* given */
+    mc_search_t search;
+    GString *pattern;
+
+    memset (&search, 0, sizeof (search));
+
+    /* when */
+    /* then */
+    pattern = g_string_new ("two\nlines");
+    search.is_case_sensitive = TRUE;
+    mctest_assert_null (mc_search__literal_new (&search, pattern));
+    g_string_free (pattern, TRUE);
+
+    pattern = g_string_new ("\xd0\x9f\xd1\x80\xd0\xb8");
+    search.is_case_sensitive = FALSE;
+    mctest_assert_null (mc_search__literal_new (&search, pattern));
+    g_string_free (pattern, TRUE);
+
+    pattern = g_string_new ("word");
+    search.is_case_sensitive = TRUE;
+    search.whole_words = TRUE;
+    mctest_assert_null (mc_search__literal_new (&search, pattern));
+    g_string_free (pattern, TRUE);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_literal_find, test_literal_find_ds);
+    tcase_add_test (tc_core, test_literal_new_rejected);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "normal_literal_find.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
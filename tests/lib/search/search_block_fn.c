@@ -0,0 +1,191 @@
+/*
+   libmc - checks for search by blocks of data
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "lib/search"
+
+#include "tests/mctest.h"
+
+#include "lib/strutil.h"
+#include "lib/search.h"
+
+#define TEST_BLOCK_SIZE 3
+
+static const char test_text[] = "first line\nsecond needle line\nthird neeedle";
+
+/* --------------------------------------------------------------------------------------------- */
+
+static mc_search_cbret_t
+test_block_callback (const void *user_data, gsize char_offset, const char **block,
+                     gsize * block_len)
+{
+    const char *text = (const char *) user_data;
+    gsize text_len;
+
+    text_len = strlen (text);
+    if (char_offset >= text_len)
+    {
+        *block = "\n";
+        *block_len = 1;
+    }
+    else
+    {
+        *block = text + char_offset;
+        *block_len = MIN (TEST_BLOCK_SIZE, text_len - char_offset);
+    }
+
+    return MC_SEARCH_CB_OK;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_search_block_fn_ds") */
+/* *INDENT-OFF* */
+static const struct test_search_block_fn_ds
+{
+    const char *pattern;
+    mc_search_type_t search_type;
+    gsize start_search;
+    gboolean expected_result;
+    off_t expected_offset;
+    gsize expected_len;
+} test_search_block_fn_ds[] =
+{
+    { /* 0. */
+        "needle",
+        MC_SEARCH_T_NORMAL,
+        0,
+        TRUE,
+        18,
+        6
+    },
+    { /* 1. */
+        "ne+dle",
+        MC_SEARCH_T_REGEX,
+        0,
+        TRUE,
+        18,
+        6
+    },
+    { /* 2. */
+        "ne+dle",
+        MC_SEARCH_T_REGEX,
+        19,
+        TRUE,
+        36,
+        7
+    },
+    { /* 3. */
+        "line\nthird",
+        MC_SEARCH_T_NORMAL,
+        0,
+        FALSE,
+        0,
+        0
+    },
+    { /* 4. */
+        "haystack",
+        MC_SEARCH_T_NORMAL,
+        0,
+        FALSE,
+        0,
+        0
+    },
+};
+/* *INDENT-ON* */
+
+/* @Test(dataSource = "test_search_block_fn_ds") */
+/* *INDENT-OFF* */
+START_PARAMETRIZED_TEST (test_search_block_fn, test_search_block_fn_ds)
+/* *INDENT-ON* */
+{
+    /* given */
+    mc_search_t *search;
+    gboolean result;
+    gsize found_len = 0;
+
+    search = mc_search_new (data->pattern, -1, NULL);
+    search->search_type = data->search_type;
+    search->is_case_sensitive = TRUE;
+    search->search_block_fn = test_block_callback;
+
+    /* when */
+    result = mc_search_run (search, test_text, data->start_search, strlen (test_text), &found_len);
+
+    /* then */
+    mctest_assert_int_eq (result, data->expected_result);
+    if (data->expected_result)
+    {
+        mctest_assert_int_eq (search->normal_offset, data->expected_offset);
+        mctest_assert_int_eq (found_len, data->expected_len);
+    }
+
+    mc_search_free (search);
+}
+/* *INDENT-OFF* */
+END_PARAMETRIZED_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    mctest_add_parameterized_test (tc_core, test_search_block_fn, test_search_block_fn_ds);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "search_block_fn.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
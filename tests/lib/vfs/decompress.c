@@ -0,0 +1,260 @@
+/*
+   lib/vfs - streaming decompression of archives
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "lib/strutil.h"
+#include "lib/vfs/xdirentry.h"
+#include "lib/vfs/path.h"
+#include "lib/vfs/decompress.h"
+
+#include "src/vfs/local/local.c"
+
+/* more than distance between seek points */
+#define TEST_DATA_SIZE (3 * 1024 * 1024 + 12345)
+
+static char *test_data;
+static vfs_path_t *test_vpath;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    int fd;
+    size_t i;
+    GRand *rand;
+
+    str_init_strings (NULL);
+
+    vfs_init ();
+    init_localfs ();
+    vfs_setup_work_dir ();
+
+    /* compressible text which isn't too repetitive */
+    rand = g_rand_new_with_seed (1);
+    test_data = g_malloc (TEST_DATA_SIZE);
+    for (i = 0; i < TEST_DATA_SIZE; i++)
+        test_data[i] = (char) ("abcdefgh \n"[g_rand_int_range (rand, 0, 10)]);
+    g_rand_free (rand);
+
+    fd = mc_mkstemps (&test_vpath, "mctest-", NULL);
+    close (fd);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    unlink (vfs_path_as_str (test_vpath));
+    vfs_path_free (test_vpath);
+    g_free (test_data);
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_ZLIB
+/* write the data as two gzip members like concatenated .gz files */
+static void
+write_gzip (void)
+{
+    gzFile gz;
+    size_t half = TEST_DATA_SIZE / 2;
+
+    gz = gzopen (vfs_path_as_str (test_vpath), "wb");
+    gzwrite (gz, test_data, half);
+    gzclose (gz);
+
+    gz = gzopen (vfs_path_as_str (test_vpath), "ab");
+    gzwrite (gz, test_data + half, TEST_DATA_SIZE - half);
+    gzclose (gz);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+check_read_at (vfs_decompress_t * d, off_t offset, size_t count)
+{
+    char *buffer;
+    size_t expected;
+
+    expected = offset >= TEST_DATA_SIZE ? 0 : MIN (count, (size_t) (TEST_DATA_SIZE - offset));
+
+    mctest_assert_int_eq (vfs_decompress_seek (d, offset, SEEK_SET), MIN (offset, TEST_DATA_SIZE));
+
+    buffer = g_malloc (count);
+    mctest_assert_int_eq (vfs_decompress_read (d, buffer, count), expected);
+    fail_unless (expected == 0 || memcmp (buffer, test_data + offset, expected) == 0,
+                 "\nwrong data at offset %ld\n", (long) offset);
+    g_free (buffer);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_decompress_gzip_read)
+/* *INDENT-ON* */
+{
+    /* given */
+    int fd;
+    vfs_decompress_t *d;
+    char *buffer;
+    size_t total = 0;
+    ssize_t n;
+
+    write_gzip ();
+    fd = mc_open (test_vpath, O_RDONLY);
+    buffer = g_malloc (TEST_DATA_SIZE + 1);
+
+    /* when */
+    d = vfs_decompress_open (fd, COMPRESSION_GZIP);
+    mctest_assert_not_null (d);
+    while ((n = vfs_decompress_read (d, buffer + total, 10000)) > 0)
+        total += n;
+
+    /* then */
+    mctest_assert_int_eq (n, 0);
+    mctest_assert_int_eq (total, TEST_DATA_SIZE);
+    fail_unless (memcmp (buffer, test_data, TEST_DATA_SIZE) == 0, "\nwrong data\n");
+
+    vfs_decompress_close (d);
+    mc_close (fd);
+    g_free (buffer);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_decompress_gzip_seek)
+/* *INDENT-ON* */
+{
+    /* given */
+    int fd;
+    vfs_decompress_t *d;
+
+    write_gzip ();
+    fd = mc_open (test_vpath, O_RDONLY);
+    d = vfs_decompress_open (fd, COMPRESSION_GZIP);
+    mctest_assert_not_null (d);
+
+    /* when */
+    /* then */
+    check_read_at (d, TEST_DATA_SIZE - 100, 1000);
+    check_read_at (d, 5, 70000);
+    check_read_at (d, TEST_DATA_SIZE / 2 - 10, 20);
+    check_read_at (d, 2500000, 100);
+    check_read_at (d, 1100000, 100);
+    check_read_at (d, 1100050, 100);
+    check_read_at (d, 1090000, 100);
+    check_read_at (d, TEST_DATA_SIZE + 10, 100);
+    check_read_at (d, 0, 100);
+
+    mctest_assert_int_eq (vfs_decompress_seek (d, 100, SEEK_CUR), 200);
+    check_read_at (d, 200, 100);
+
+    vfs_decompress_close (d);
+    mc_close (fd);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+#endif /* HAVE_ZLIB */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_decompress_unsupported)
+/* *INDENT-ON* */
+{
+    /* given */
+    int fd;
+    vfs_decompress_t *d;
+
+    /* compress(1) data is detected as COMPRESSION_GZIP */
+    g_file_set_contents (vfs_path_as_str (test_vpath), "\037\235\220abc", 6, NULL);
+    fd = mc_open (test_vpath, O_RDONLY);
+
+    /* when */
+    d = vfs_decompress_open (fd, COMPRESSION_GZIP);
+
+    /* then */
+    mctest_assert_null (d);
+    mctest_assert_null (vfs_decompress_open (fd, COMPRESSION_LZMA));
+
+    mc_close (fd);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+#ifdef HAVE_ZLIB
+    tcase_add_test (tc_core, test_decompress_gzip_read);
+    tcase_add_test (tc_core, test_decompress_gzip_seek);
+#endif
+    tcase_add_test (tc_core, test_decompress_unsupported);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "decompress.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
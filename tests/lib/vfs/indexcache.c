@@ -0,0 +1,324 @@
+/*
+   lib/vfs - cache of archive indexes
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "lib/fileloc.h"
+#include "lib/mcconfig.h"
+#include "lib/strutil.h"
+#include "lib/util.h"
+#include "lib/vfs/vfs.h"
+#include "lib/vfs/indexcache.h"
+
+#include "src/vfs/local/local.c"
+
+#define TEST_PREFIX "utar"
+#define TEST_ARCHIVE "/tmp/archive.tar"
+
+static char *home_dir;
+static struct stat archive_st;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* remove the directory with all its contents */
+static void
+remove_dir (const char *path)
+{
+    GDir *dir;
+
+    dir = g_dir_open (path, 0, NULL);
+    if (dir != NULL)
+    {
+        const char *name;
+
+        while ((name = g_dir_read_name (dir)) != NULL)
+        {
+            char *entry;
+
+            entry = g_build_filename (path, name, NULL);
+            if (g_file_test (entry, G_FILE_TEST_IS_DIR)
+                && !g_file_test (entry, G_FILE_TEST_IS_SYMLINK))
+                remove_dir (entry);
+            else
+                unlink (entry);
+            g_free (entry);
+        }
+        g_dir_close (dir);
+    }
+
+    rmdir (path);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    home_dir = g_build_filename (g_get_tmp_dir (), "mctest-indexcache-XXXXXX", NULL);
+    mkdtemp (home_dir);
+    g_setenv ("HOME", home_dir, TRUE);
+    g_setenv ("XDG_CACHE_HOME", home_dir, TRUE);
+
+    str_init_strings (NULL);
+    vfs_init ();
+    init_localfs ();
+
+    memset (&archive_st, 0, sizeof (archive_st));
+    archive_st.st_size = 10240;
+    archive_st.st_mtime = 1400000000;
+    archive_st.st_ino = 42;
+    archive_st.st_dev = 3;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    vfs_shut ();
+    str_uninit_strings ();
+
+    remove_dir (home_dir);
+    g_free (home_dir);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* root directory, directory "dir", file "dir/file" and its hardlink "link" */
+static gboolean
+save_test_index (const char *archive, gboolean broken)
+{
+    vfs_index_t *index;
+    struct stat st;
+    guint root, dir, file;
+    gboolean ret;
+
+    index = vfs_index_new ();
+
+    memset (&st, 0, sizeof (st));
+    st.st_mode = S_IFDIR | 0755;
+    root = vfs_index_add_inode (index, &st, NULL, -1);
+    dir = vfs_index_add_inode (index, &st, NULL, -1);
+
+    st.st_mode = S_IFREG | 0644;
+    st.st_size = 1000;
+    st.st_mtime = 1300000000;
+    st.st_uid = 500;
+    file = vfs_index_add_inode (index, &st, "target", 1536);
+
+    vfs_index_add_entry (index, root, dir, "dir");
+    /* a file can't contain entries */
+    vfs_index_add_entry (index, broken ? file : dir, file, "file");
+    vfs_index_add_entry (index, root, file, "link");
+
+    ret = vfs_index_save (index, TEST_PREFIX, archive, &archive_st);
+    vfs_index_free (index);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_index_load)
+/* *INDENT-ON* */
+{
+    /* given */
+    vfs_index_t *index;
+    struct stat st;
+    off_t data_offset;
+    guint dir, ino;
+    const char *name;
+
+    mctest_assert_true (save_test_index (TEST_ARCHIVE, FALSE));
+
+    /* when */
+    index = vfs_index_load (TEST_PREFIX, TEST_ARCHIVE, &archive_st);
+
+    /* then */
+    mctest_assert_not_null (index);
+    mctest_assert_int_eq (vfs_index_get_inode_count (index), 3);
+    mctest_assert_int_eq (vfs_index_get_entry_count (index), 3);
+
+    name = vfs_index_get_entry (index, 1, &dir, &ino);
+    mctest_assert_str_eq (name, "file");
+    mctest_assert_int_eq (dir, 1);
+    mctest_assert_int_eq (ino, 2);
+
+    name = vfs_index_get_entry (index, 2, &dir, &ino);
+    mctest_assert_str_eq (name, "link");
+    mctest_assert_int_eq (dir, 0);
+    mctest_assert_int_eq (ino, 2);
+
+    mctest_assert_null (vfs_index_get_inode (index, 0, &st, &data_offset));
+    mctest_assert_true (S_ISDIR (st.st_mode));
+
+    mctest_assert_str_eq (vfs_index_get_inode (index, 2, &st, &data_offset), "target");
+    mctest_assert_int_eq (st.st_mode, S_IFREG | 0644);
+    mctest_assert_int_eq (st.st_size, 1000);
+    mctest_assert_int_eq (st.st_mtime, 1300000000);
+    mctest_assert_int_eq (st.st_uid, 500);
+    mctest_assert_int_eq (data_offset, 1536);
+
+    vfs_index_free (index);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_index_changed_archive)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct stat st;
+
+    mctest_assert_true (save_test_index (TEST_ARCHIVE, FALSE));
+
+    /* when */
+    /* then */
+    mctest_assert_null (vfs_index_load (TEST_PREFIX, "/tmp/other.tar", &archive_st));
+    mctest_assert_null (vfs_index_load ("ucpio", TEST_ARCHIVE, &archive_st));
+
+    st = archive_st;
+    st.st_size++;
+    mctest_assert_null (vfs_index_load (TEST_PREFIX, TEST_ARCHIVE, &st));
+
+    st = archive_st;
+    st.st_mtime++;
+    mctest_assert_null (vfs_index_load (TEST_PREFIX, TEST_ARCHIVE, &st));
+
+    st = archive_st;
+    st.st_ino++;
+    mctest_assert_null (vfs_index_load (TEST_PREFIX, TEST_ARCHIVE, &st));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_index_broken_tree)
+/* *INDENT-ON* */
+{
+    /* given */
+    mctest_assert_true (save_test_index (TEST_ARCHIVE, TRUE));
+
+    /* when */
+    /* then */
+    mctest_assert_null (vfs_index_load (TEST_PREFIX, TEST_ARCHIVE, &archive_st));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_index_sweep)
+/* *INDENT-ON* */
+{
+    /* given */
+    vfs_index_t *index;
+    char *dir_path;
+    GDir *dir;
+    const char *name;
+    struct utimbuf times;
+
+    mctest_assert_true (save_test_index (TEST_ARCHIVE, FALSE));
+
+    /* the index wasn't used for a long time */
+    times.actime = times.modtime = time (NULL) - 365 * 24 * 60 * 60;
+    dir_path = g_build_filename (mc_config_get_cache_path (), MC_VFS_INDEX_DIR, (char *) NULL);
+    dir = g_dir_open (dir_path, 0, NULL);
+    mctest_assert_not_null (dir);
+    while ((name = g_dir_read_name (dir)) != NULL)
+    {
+        char *path;
+
+        path = g_build_filename (dir_path, name, (char *) NULL);
+        mctest_assert_int_eq (utime (path, &times), 0);
+        g_free (path);
+    }
+    g_dir_close (dir);
+    g_free (dir_path);
+
+    /* when */
+    mctest_assert_true (save_test_index ("/tmp/other.tar", FALSE));
+
+    /* then */
+    mctest_assert_null (vfs_index_load (TEST_PREFIX, TEST_ARCHIVE, &archive_st));
+    index = vfs_index_load (TEST_PREFIX, "/tmp/other.tar", &archive_st);
+    mctest_assert_not_null (index);
+    vfs_index_free (index);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_index_load);
+    tcase_add_test (tc_core, test_index_changed_archive);
+    tcase_add_test (tc_core, test_index_broken_tree);
+    tcase_add_test (tc_core, test_index_sweep);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "indexcache.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,414 @@
+/*
+   lib/vfs - read-ahead of linear transfers
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "lib/timer.h"
+#include "lib/tty/tty.h"
+#include "lib/vfs/readahead.h"
+
+/* more than all read-ahead buffers */
+#define TEST_DATA_SIZE (5 * 1000 * 1000 + 7)
+
+/* delays of the throttled transfer in microseconds */
+#define TEST_LINK_DELAY 200     /* for every chunk sent and received */
+#define TEST_DISK_DELAY 100     /* for every block written by the reader */
+
+static char *test_data;
+
+/* pipe from the writer thread standing in for the remote side */
+static int test_pipe[2];
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    size_t i;
+
+#if !GLIB_CHECK_VERSION (2, 32, 0)
+    if (!g_thread_supported ())
+        g_thread_init (NULL);
+#endif
+
+    test_data = g_malloc (TEST_DATA_SIZE);
+    for (i = 0; i < TEST_DATA_SIZE; i++)
+        test_data[i] = (char) (i * 7 + i / 1000);
+
+    vfs_readahead_size = 64;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    g_free (test_data);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* writes the test data to the pipe, sleeping for the specified time in microseconds per chunk */
+static gpointer
+writer_thread (gpointer data)
+{
+    const gulong delay = (gulong) GPOINTER_TO_INT (data);
+    size_t written = 0;
+
+    while (written < TEST_DATA_SIZE)
+    {
+        ssize_t n;
+
+        if (delay != 0)
+            g_usleep (delay);
+
+        n = write (test_pipe[1], test_data + written, MIN (16384, TEST_DATA_SIZE - written));
+        if (n <= 0)
+            break;
+        written += n;
+    }
+
+    close (test_pipe[1]);
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+pipe_read (void *data, void *buffer, size_t count)
+{
+    (void) data;
+
+    return vfs_readahead_recv (test_pipe[0], buffer, count);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+throttled_read (void *data, void *buffer, size_t count)
+{
+    (void) data;
+
+    g_usleep (TEST_LINK_DELAY);
+    return vfs_readahead_recv (test_pipe[0], buffer, count);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy the data from the throttled pipe to memory by blocks of 8 KiB, as the file is copied
+ * from FISH or FTP.
+ *
+ * @return time of the transfer in seconds
+ */
+
+static double
+throttled_transfer (gboolean ahead)
+{
+    GThread *writer;
+    vfs_readahead_t *ra;
+    mc_timer_t *timer;
+    char *buffer;
+    size_t total = 0;
+    ssize_t n;
+    double elapsed;
+
+    mctest_assert_int_eq (pipe (test_pipe), 0);
+    writer = g_thread_try_new ("writer", writer_thread, GINT_TO_POINTER (TEST_LINK_DELAY), NULL);
+    buffer = g_malloc (TEST_DATA_SIZE + 8192);
+
+    timer = mc_timer_new ();
+    vfs_readahead_size = ahead ? 512 : 0;
+    ra = vfs_readahead_new (throttled_read, NULL);
+
+    while (TRUE)
+    {
+        if (ra != NULL)
+            n = vfs_readahead_read (ra, buffer + total, 8192);
+        else
+            n = throttled_read (NULL, buffer + total, 8192);
+
+        if (n == -1 && errno == EAGAIN)
+            continue;
+        if (n <= 0)
+            break;
+
+        total += n;
+        g_usleep (TEST_DISK_DELAY);
+    }
+
+    elapsed = (double) mc_timer_elapsed (timer) / G_USEC_PER_SEC;
+
+    mctest_assert_int_eq (n, 0);
+    mctest_assert_int_eq (total, TEST_DATA_SIZE);
+    fail_unless (memcmp (buffer, test_data, TEST_DATA_SIZE) == 0, "\nwrong data\n");
+
+    if (ra != NULL)
+        vfs_readahead_free (ra);
+    mc_timer_destroy (timer);
+    g_thread_join (writer);
+    close (test_pipe[0]);
+    g_free (buffer);
+
+    return elapsed;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* returns 1000 bytes, then fails */
+static ssize_t
+failing_read (void *data, void *buffer, size_t count)
+{
+    size_t *done = (size_t *) data;
+
+    if (*done == 1000)
+    {
+        errno = EIO;
+        return -1;
+    }
+
+    count = MIN (count, 1000 - *done);
+    memset (buffer, 'a', count);
+    *done += count;
+    return (ssize_t) count;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+endless_read (void *data, void *buffer, size_t count)
+{
+    (void) data;
+
+    memset (buffer, 'a', count);
+    return (ssize_t) count;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_readahead_all_data)
+/* *INDENT-ON* */
+{
+    /* given */
+    GThread *writer;
+    vfs_readahead_t *ra;
+    char *buffer;
+    size_t total = 0;
+    ssize_t n;
+
+    mctest_assert_int_eq (pipe (test_pipe), 0);
+    writer = g_thread_try_new ("writer", writer_thread, GINT_TO_POINTER (0), NULL);
+    buffer = g_malloc (TEST_DATA_SIZE + 1);
+
+    /* when */
+    ra = vfs_readahead_new (pipe_read, NULL);
+    mctest_assert_not_null (ra);
+    while ((n = vfs_readahead_read (ra, buffer + total, 3000)) > 0)
+        total += n;
+
+    /* then */
+    mctest_assert_int_eq (n, 0);
+    mctest_assert_int_eq (vfs_readahead_read (ra, buffer, 3000), 0);
+    mctest_assert_int_eq (total, TEST_DATA_SIZE);
+    fail_unless (memcmp (buffer, test_data, TEST_DATA_SIZE) == 0, "\nwrong data\n");
+
+    vfs_readahead_free (ra);
+    g_thread_join (writer);
+    close (test_pipe[0]);
+    g_free (buffer);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_readahead_throttled)
+/* *INDENT-ON* */
+{
+    /* given */
+    double sync, ahead;
+
+    /* when */
+    sync = throttled_transfer (FALSE);
+    ahead = throttled_transfer (TRUE);
+
+    /* then: the data is received while the reader writes */
+    printf ("throttled transfer: %.2f s synchronous, %.2f s with read-ahead\n", sync, ahead);
+    fail_unless (ahead < sync, "\nread-ahead %.2f s is not faster than synchronous %.2f s\n",
+                 ahead, sync);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_readahead_error)
+/* *INDENT-ON* */
+{
+    /* given */
+    vfs_readahead_t *ra;
+    char buffer[300];
+    size_t done = 0, total = 0;
+    ssize_t n;
+
+    /* when */
+    ra = vfs_readahead_new (failing_read, &done);
+    mctest_assert_not_null (ra);
+    while ((n = vfs_readahead_read (ra, buffer, sizeof (buffer))) > 0)
+        total += n;
+
+    /* then: data received before the error isn't lost */
+    mctest_assert_int_eq (total, 1000);
+    mctest_assert_int_eq (n, -1);
+    mctest_assert_int_eq (errno, EIO);
+    mctest_assert_int_eq (vfs_readahead_read (ra, buffer, sizeof (buffer)), -1);
+
+    vfs_readahead_free (ra);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_readahead_free_unread)
+/* *INDENT-ON* */
+{
+    /* given */
+    vfs_readahead_t *ra;
+    char buffer[100];
+
+    ra = vfs_readahead_new (endless_read, NULL);
+    mctest_assert_not_null (ra);
+    mctest_assert_int_eq (vfs_readahead_read (ra, buffer, sizeof (buffer)), sizeof (buffer));
+
+    /* when */
+    /* then: the thread waiting for a free buffer is stopped */
+    usleep (10000);
+    vfs_readahead_free (ra);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_readahead_interrupt_stalled)
+/* *INDENT-ON* */
+{
+    /* given: the remote side sends nothing, but keeps the connection open */
+    vfs_readahead_t *ra;
+    char buffer[100];
+    ssize_t n;
+
+    mctest_assert_int_eq (pipe (test_pipe), 0);
+    ra = vfs_readahead_new (pipe_read, NULL);
+    mctest_assert_not_null (ra);
+
+    /* when */
+    tty_enable_interrupt_key ();
+    raise (SIGINT);
+    n = vfs_readahead_read (ra, buffer, sizeof (buffer));
+    tty_disable_interrupt_key ();
+
+    /* then: the reader is interrupted and the thread waiting for data is stopped */
+    mctest_assert_int_eq (n, -1);
+    mctest_assert_int_eq (errno, EINTR);
+    vfs_readahead_free (ra);
+
+    close (test_pipe[1]);
+    close (test_pipe[0]);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_readahead_disabled)
+/* *INDENT-ON* */
+{
+    /* given */
+    vfs_readahead_size = 0;
+
+    /* when */
+    /* then */
+    mctest_assert_null (vfs_readahead_new (endless_read, NULL));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_readahead_all_data);
+    tcase_add_test (tc_core, test_readahead_throttled);
+    tcase_add_test (tc_core, test_readahead_error);
+    tcase_add_test (tc_core, test_readahead_free_unread);
+    tcase_add_test (tc_core, test_readahead_interrupt_stalled);
+    tcase_add_test (tc_core, test_readahead_disabled);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "readahead.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,198 @@
+/*
+   lib/vfs - test vfs_s_find_inode() function on large directories
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include "lib/strutil.h"
+#include "lib/vfs/direntry.c"   /* for testing static methods  */
+
+#include "src/vfs/local/local.c"
+
+#define TEST_ENTRIES_COUNT (VFS_S_SUBDIR_INDEX_MIN * 4)
+
+struct vfs_s_subclass test_subclass;
+struct vfs_class vfs_test_ops;
+
+static struct vfs_s_super *test_super;
+
+/* --------------------------------------------------------------------------------------------- */
+
+static struct vfs_s_entry *
+test_add_file (struct vfs_s_inode *dir, const char *name)
+{
+    struct vfs_s_entry *ent;
+
+    ent = vfs_s_generate_entry (&vfs_test_ops, name, dir, S_IFREG | 0644);
+    vfs_s_insert_entry (&vfs_test_ops, dir, ent);
+    return ent;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+
+    vfs_init ();
+    init_localfs ();
+    vfs_setup_work_dir ();
+
+    vfs_s_init_class (&vfs_test_ops, &test_subclass);
+    vfs_test_ops.name = "testfs";
+    vfs_test_ops.prefix = "test:";
+    vfs_register_class (&vfs_test_ops);
+
+    test_super = vfs_s_new_super (&vfs_test_ops);
+    test_super->root =
+        vfs_s_new_inode (&vfs_test_ops, test_super,
+                         vfs_s_default_stat (&vfs_test_ops, S_IFDIR | 0755));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    vfs_s_free_inode (&vfs_test_ops, test_super->root);
+    g_free (test_super);
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_die (const char *m)
+{
+    printf ("VFS_DIE: '%s'\n", m);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_vfs_s_find_inode_large_dir)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct vfs_s_entry *ents[TEST_ENTRIES_COUNT];
+    int i;
+
+    for (i = 0; i < TEST_ENTRIES_COUNT; i++)
+    {
+        char name[BUF_TINY];
+
+        g_snprintf (name, sizeof (name), "file%d", i);
+        ents[i] = test_add_file (test_super->root, name);
+    }
+
+    /* when */
+    /* then */
+    for (i = 0; i < TEST_ENTRIES_COUNT; i++)
+    {
+        char name[BUF_TINY];
+
+        g_snprintf (name, sizeof (name), "/file%d", i);
+        mctest_assert_ptr_eq (vfs_s_find_inode (&vfs_test_ops, test_super, name,
+                                                LINK_NO_FOLLOW, FL_NONE), ents[i]->ino);
+    }
+    mctest_assert_not_null (test_super->root->subdir_index);
+    mctest_assert_null (vfs_s_find_inode (&vfs_test_ops, test_super, "file", LINK_NO_FOLLOW,
+                                          FL_NONE));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_vfs_s_find_inode_duplicates)
+/* *INDENT-ON* */
+{
+    /* given */
+    struct vfs_s_entry *first, *second;
+    int i;
+
+    for (i = 0; i < TEST_ENTRIES_COUNT; i++)
+    {
+        char name[BUF_TINY];
+
+        g_snprintf (name, sizeof (name), "file%d", i);
+        test_add_file (test_super->root, name);
+    }
+
+    /* when */
+    first = test_add_file (test_super->root, "dup");
+    second = test_add_file (test_super->root, "dup");
+
+    /* then */
+    mctest_assert_ptr_eq (vfs_s_find_inode (&vfs_test_ops, test_super, "dup", LINK_NO_FOLLOW,
+                                            FL_NONE), first->ino);
+
+    /* when */
+    vfs_s_free_entry (&vfs_test_ops, first);
+
+    /* then */
+    mctest_assert_ptr_eq (vfs_s_find_inode (&vfs_test_ops, test_super, "dup", LINK_NO_FOLLOW,
+                                            FL_NONE), second->ino);
+    mctest_assert_int_eq (g_queue_get_length (test_super->root->subdir), TEST_ENTRIES_COUNT + 1);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_vfs_s_find_inode_large_dir);
+    tcase_add_test (tc_core, test_vfs_s_find_inode_duplicates);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "vfs_s_find_inode.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
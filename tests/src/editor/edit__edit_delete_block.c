@@ -0,0 +1,353 @@
+/*
+   src/editor - tests for undo and redo of edit_delete_block() function
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "lib/timer.h"
+#ifdef HAVE_CHARSET
+#include "lib/charsets.h"
+#endif
+#include "lib/strutil.h"
+#include "lib/keybind.h"
+
+#include "src/vfs/local/local.c"
+#include "src/editor/editwidget.h"
+
+#define TEST_TEXT_LEN (64 * 1024)
+
+static WEdit *test_edit;
+static int test_max_undo;
+
+/* --------------------------------------------------------------------------------------------- */
+/* @Mock */
+void
+edit_load_syntax (WEdit * _edit, GPtrArray * _pnames, const char *_type)
+{
+    (void) _edit;
+    (void) _pnames;
+    (void) _type;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+int
+edit_get_syntax_color (WEdit * _edit, off_t _byte_index)
+{
+    (void) _edit;
+    (void) _byte_index;
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+gboolean
+edit_load_macro_cmd (WEdit * _edit)
+{
+    (void) _edit;
+
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* lines of 64 bytes, every line is filled with one letter */
+static char
+test_text_byte (off_t i)
+{
+    return (i % 64 == 63) ? '\n' : 'A' + (i / 64) % 26;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* put the text into the editor without undo history */
+static void
+test_text_load (off_t len)
+{
+    char *text;
+    off_t i;
+
+    text = g_malloc (len);
+    for (i = 0; i < len; i++)
+        text[i] = test_text_byte (i);
+
+    /* a change without a key press is not kept in the undo stack */
+    edit_insert_ahead_block (test_edit, text, (size_t) len);
+    g_free (text);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* check that the editor holds the text from the specified offset, with skip bytes deleted at */
+static gboolean
+test_text_check (off_t from, off_t at, off_t skip, off_t len)
+{
+    off_t i;
+
+    if (test_edit->buffer.size != len - from - skip)
+        return FALSE;
+
+    for (i = 0; i < test_edit->buffer.size; i++)
+        if (edit_buffer_get_byte (&test_edit->buffer, i)
+            != test_text_byte (from + (i < at ? i : i + skip)))
+            return FALSE;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* redo steps one by one until all undone actions are redone */
+static void
+test_redo_all (void)
+{
+    while (test_edit->redo_stack_pointer != test_edit->redo_stack_bottom)
+        edit_execute_key_command (test_edit, CK_Redo, -1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    mc_global.timer = mc_timer_new ();
+    str_init_strings (NULL);
+
+    vfs_init ();
+    init_localfs ();
+    vfs_setup_work_dir ();
+
+#ifdef HAVE_CHARSET
+    mc_global.sysconfig_dir = (char *) TEST_SHARE_DIR;
+    load_codepages_list ();
+#endif /* HAVE_CHARSET */
+
+    test_max_undo = option_max_undo;
+
+    test_edit = edit_init (NULL, 0, 0, 24, 80, NULL, 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    edit_clean (test_edit);
+    g_free (test_edit);
+
+    option_max_undo = test_max_undo;
+
+#ifdef HAVE_CHARSET
+    free_codepages_list ();
+#endif /* HAVE_CHARSET */
+
+    vfs_shut ();
+
+    str_uninit_strings ();
+    mc_timer_destroy (mc_global.timer);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_delete_block_undo_redo)
+/* *INDENT-ON* */
+{
+    /* given */
+    test_text_load (TEST_TEXT_LEN);
+
+    /* when */
+    edit_push_key_press (test_edit);
+    edit_cursor_move (test_edit, 1000);
+    edit_delete_block (test_edit, 500);
+    edit_delete_block (test_edit, 300);
+
+    /* then: one record of the cursor move, the deletions of one key press are joined */
+    mctest_assert_int_eq (test_edit->undo_blocks.records->len, 2);
+    mctest_assert_int_eq (test_edit->undo_blocks.text->len, 800);
+    mctest_assert_true (test_text_check (0, 1000, 800, TEST_TEXT_LEN));
+
+    /* when */
+    edit_execute_key_command (test_edit, CK_Undo, -1);
+
+    /* then */
+    mctest_assert_true (test_text_check (0, 0, 0, TEST_TEXT_LEN));
+    mctest_assert_int_eq (test_edit->buffer.curs1, 0);
+    mctest_assert_int_eq (test_edit->undo_blocks.records->len, 0);
+    mctest_assert_int_eq (test_edit->undo_blocks.text->len, 0);
+
+    /* when */
+    test_redo_all ();
+
+    /* then */
+    mctest_assert_true (test_text_check (0, 1000, 800, TEST_TEXT_LEN));
+    mctest_assert_int_eq (test_edit->buffer.curs1, 1000);
+
+    /* when */
+    edit_execute_key_command (test_edit, CK_Undo, -1);
+
+    /* then */
+    mctest_assert_true (test_text_check (0, 0, 0, TEST_TEXT_LEN));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_delete_block_redo_reset)
+/* *INDENT-ON* */
+{
+    /* given */
+    test_text_load (TEST_TEXT_LEN);
+    edit_push_key_press (test_edit);
+    edit_delete_block (test_edit, 500);
+    edit_execute_key_command (test_edit, CK_Undo, -1);
+    mctest_assert_int_eq (test_edit->redo_blocks.records->len, 1);
+
+    /* when: a new change is made after undo */
+    edit_execute_key_command (test_edit, CK_Delete, -1);
+
+    /* then: the undone deletion can't be redone */
+    mctest_assert_int_eq (test_edit->redo_blocks.records->len, 0);
+    edit_execute_key_command (test_edit, CK_Redo, -1);
+    mctest_assert_true (test_text_check (1, 0, 0, TEST_TEXT_LEN));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_delete_block_stack_bottom)
+/* *INDENT-ON* */
+{
+    /* given */
+    const int count = 200;
+    int i;
+    off_t dropped;
+
+    option_max_undo = 256;
+    test_text_load (TEST_TEXT_LEN);
+
+    /* when: the undo stack is overwritten */
+    for (i = 0; i < count; i++)
+    {
+        edit_push_key_press (test_edit);
+        edit_delete_block (test_edit, 10);
+    }
+
+    /* then: the texts of the oldest deletions are dropped with them */
+    mctest_assert_true (test_edit->undo_blocks.records->len < (guint) count);
+    mctest_assert_true (test_edit->undo_blocks.records->len != 0);
+    mctest_assert_int_eq (test_edit->undo_blocks.text->len,
+                          10 * test_edit->undo_blocks.records->len);
+
+    /* when */
+    dropped = 10 * (count - test_edit->undo_blocks.records->len);
+    for (i = 0; i < count; i++)
+        edit_execute_key_command (test_edit, CK_Undo, -1);
+
+    /* then: the kept deletions are undone */
+    mctest_assert_true (test_text_check (dropped, 0, 0, TEST_TEXT_LEN));
+    mctest_assert_int_eq (test_edit->undo_blocks.records->len, 0);
+    mctest_assert_int_eq (test_edit->undo_blocks.text->len, 0);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_delete_block_text_max)
+/* *INDENT-ON* */
+{
+    /* given */
+    const off_t len = UNDO_TEXT_MAX + 2 * 1024 * 1024;
+    const off_t first = 1024 * 1024;
+
+    test_text_load (len);
+    edit_push_key_press (test_edit);
+    edit_delete_block (test_edit, first);
+
+    /* when: the saved text of the next key press reaches the limit */
+    edit_push_key_press (test_edit);
+    edit_delete_block (test_edit, UNDO_TEXT_MAX);
+
+    /* then: the older key press is dropped, the current one is kept whole */
+    mctest_assert_int_eq (test_edit->undo_blocks.records->len, 1);
+    mctest_assert_int_eq (test_edit->undo_blocks.text->len, UNDO_TEXT_MAX);
+
+    /* when */
+    edit_execute_key_command (test_edit, CK_Undo, -1);
+    edit_execute_key_command (test_edit, CK_Undo, -1);
+
+    /* then */
+    mctest_assert_true (test_text_check (first, 0, 0, len));
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_edit_delete_block_undo_redo);
+    tcase_add_test (tc_core, test_edit_delete_block_redo_reset);
+    tcase_add_test (tc_core, test_edit_delete_block_stack_bottom);
+    tcase_add_test (tc_core, test_edit_delete_block_text_max);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "edit__edit_delete_block.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
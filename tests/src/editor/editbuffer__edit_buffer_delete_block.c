@@ -0,0 +1,159 @@
+/*
+   src/editor - tests for edit_buffer_delete_block() and edit_buffer_backspace_block() functions
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "tests/src/editor/editbuffer_test.h"
+
+/* not a divisor of buffer page size */
+#define TEST_CHUNK_LEN 1000
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    test_buffer_init ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    test_buffer_deinit ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_buffer_delete_block)
+/* *INDENT-ON* */
+{
+    /* given */
+    char *deleted;
+    long lines;
+    int i;
+
+    edit_buffer_insert_ahead_block (&test_buf, test_data, TEST_DATA_LEN);
+    deleted = g_malloc (TEST_DATA_LEN);
+
+    /* when */
+    lines = edit_buffer_delete_block (&test_buf, deleted, TEST_CHUNK_LEN);
+
+    /* then */
+    mctest_assert_int_eq (lines, TEST_CHUNK_LEN / 100);
+    mctest_assert_int_eq (memcmp (deleted, test_data, TEST_CHUNK_LEN), 0);
+    mctest_assert_int_eq (test_buf.curs2, TEST_DATA_LEN - TEST_CHUNK_LEN);
+    for (i = 0; i < TEST_DATA_LEN - TEST_CHUNK_LEN; i++)
+        mctest_assert_int_eq (edit_buffer_get_byte (&test_buf, i), test_data[TEST_CHUNK_LEN + i]);
+
+    /* when */
+    lines = edit_buffer_delete_block (&test_buf, deleted, TEST_DATA_LEN - TEST_CHUNK_LEN);
+
+    /* then */
+    mctest_assert_int_eq (lines, (TEST_DATA_LEN - TEST_CHUNK_LEN) / 100);
+    mctest_assert_int_eq (memcmp (deleted, test_data + TEST_CHUNK_LEN,
+                                  TEST_DATA_LEN - TEST_CHUNK_LEN), 0);
+    mctest_assert_int_eq (test_buf.curs2, 0);
+    mctest_assert_int_eq (test_buf.b2->len, 0);
+
+    g_free (deleted);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_buffer_backspace_block)
+/* *INDENT-ON* */
+{
+    /* given */
+    char *deleted;
+    long lines;
+    int i;
+
+    edit_buffer_insert_block (&test_buf, test_data, TEST_DATA_LEN);
+    deleted = g_malloc (TEST_DATA_LEN);
+
+    /* when */
+    lines = edit_buffer_backspace_block (&test_buf, deleted, TEST_CHUNK_LEN);
+
+    /* then */
+    mctest_assert_int_eq (lines, TEST_CHUNK_LEN / 100);
+    mctest_assert_int_eq (memcmp (deleted, test_data + TEST_DATA_LEN - TEST_CHUNK_LEN,
+                                  TEST_CHUNK_LEN), 0);
+    mctest_assert_int_eq (test_buf.curs1, TEST_DATA_LEN - TEST_CHUNK_LEN);
+    for (i = 0; i < TEST_DATA_LEN - TEST_CHUNK_LEN; i++)
+        mctest_assert_int_eq (edit_buffer_get_byte (&test_buf, i), test_data[i]);
+
+    /* when */
+    lines = edit_buffer_backspace_block (&test_buf, deleted, TEST_DATA_LEN - TEST_CHUNK_LEN);
+
+    /* then */
+    mctest_assert_int_eq (lines, (TEST_DATA_LEN - TEST_CHUNK_LEN) / 100);
+    mctest_assert_int_eq (memcmp (deleted, test_data, TEST_DATA_LEN - TEST_CHUNK_LEN), 0);
+    mctest_assert_int_eq (test_buf.curs1, 0);
+    mctest_assert_int_eq (test_buf.b1->len, 0);
+
+    g_free (deleted);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_edit_buffer_delete_block);
+    tcase_add_test (tc_core, test_edit_buffer_backspace_block);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "editbuffer__edit_buffer_delete_block.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,166 @@
+/*
+   src/editor - tests for the line index of editor buffer
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "tests/src/editor/editbuffer_test.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    test_buffer_init ();
+
+    edit_buffer_insert_block (&test_buf, test_data, TEST_DATA_LEN);
+    test_buf.size = TEST_DATA_LEN;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    test_buffer_deinit ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_buffer_get_line_offset)
+/* *INDENT-ON* */
+{
+    /* given */
+    off_t cursor;
+
+    for (cursor = 0; cursor <= TEST_DATA_LEN; cursor += 50 * 1024 + 17)
+    {
+        long line;
+
+        /* when */
+        edit_buffer_move_cursor (&test_buf, cursor - test_buf.curs1);
+
+        /* then */
+        mctest_assert_int_eq (edit_buffer_get_line_offset (&test_buf, -1), 0);
+        mctest_assert_int_eq (edit_buffer_get_line_offset (&test_buf, 0), 0);
+        for (line = 1; line <= TEST_DATA_LEN / 100; line++)
+            mctest_assert_int_eq (edit_buffer_get_line_offset (&test_buf, line), line * 100);
+        mctest_assert_int_eq (edit_buffer_get_line_offset (&test_buf, line), TEST_DATA_LEN);
+    }
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_buffer_count_lines)
+/* *INDENT-ON* */
+{
+    /* given */
+    char block[300];
+
+    edit_buffer_move_cursor (&test_buf, -TEST_DATA_LEN / 2);
+
+    /* when */
+    edit_buffer_delete_block (&test_buf, block, sizeof (block));
+
+    /* then */
+    test_buf.size -= sizeof (block);
+    mctest_assert_int_eq (edit_buffer_count_lines (&test_buf, 0, test_buf.size),
+                          TEST_DATA_LEN / 100 - 3);
+    mctest_assert_int_eq (edit_buffer_count_lines (&test_buf, 150, TEST_DATA_LEN / 2 + 50), 767);
+    mctest_assert_int_eq (edit_buffer_move_forward (&test_buf, 150, 2, 0), 300);
+    mctest_assert_int_eq (edit_buffer_move_backward (&test_buf, TEST_DATA_LEN / 2 + 50, 1),
+                          TEST_DATA_LEN / 2 - 100);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_buffer_move_lines)
+/* *INDENT-ON* */
+{
+    /* given */
+    static const long moves[] = { 1, 2, 63, 64, 65, 100, 1000, 2000 };
+    const long total = TEST_DATA_LEN / 100;
+    size_t i;
+
+    edit_buffer_move_cursor (&test_buf, -TEST_DATA_LEN / 2);
+
+    for (i = 0; i < G_N_ELEMENTS (moves); i++)
+    {
+        /* when */
+        off_t forward, backward;
+
+        forward = edit_buffer_move_forward (&test_buf, 150, moves[i], 0);
+        backward = edit_buffer_move_backward (&test_buf, TEST_DATA_LEN / 2 + 50, moves[i]);
+
+        /* then: short moves scan the data, long ones use the line index */
+        mctest_assert_int_eq (forward, min (1 + moves[i], total) * 100);
+        mctest_assert_int_eq (backward, max (TEST_DATA_LEN / 200 - moves[i], 0) * 100);
+    }
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_edit_buffer_get_line_offset);
+    tcase_add_test (tc_core, test_edit_buffer_count_lines);
+    tcase_add_test (tc_core, test_edit_buffer_move_lines);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "editbuffer__edit_buffer_get_line_offset.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
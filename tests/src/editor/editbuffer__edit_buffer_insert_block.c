@@ -0,0 +1,137 @@
+/*
+   src/editor - tests for edit_buffer_insert_block() function
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "tests/src/editor/editbuffer_test.h"
+
+/* not a divisor of buffer page size */
+#define TEST_CHUNK_LEN 1000
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    test_buffer_init ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    test_buffer_deinit ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_buffer_insert_block)
+/* *INDENT-ON* */
+{
+    /* given */
+    long lines = 0;
+    int i;
+
+    /* when */
+    for (i = 0; i < TEST_DATA_LEN; i += TEST_CHUNK_LEN)
+        lines += edit_buffer_insert_block (&test_buf, test_data + i,
+                                           MIN (TEST_CHUNK_LEN, TEST_DATA_LEN - i));
+
+    /* then */
+    mctest_assert_int_eq (lines, TEST_DATA_LEN / 100);
+    mctest_assert_int_eq (test_buf.curs1, TEST_DATA_LEN);
+    mctest_assert_int_eq (test_buf.curs2, 0);
+    for (i = 0; i < TEST_DATA_LEN; i++)
+        mctest_assert_int_eq (edit_buffer_get_byte (&test_buf, i), test_data[i]);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_buffer_insert_block_after_bytes)
+/* *INDENT-ON* */
+{
+    /* given */
+    long lines;
+    int i;
+
+    for (i = 0; i < 10; i++)
+        edit_buffer_insert (&test_buf, test_data[i]);
+
+    /* when */
+    lines = edit_buffer_insert_block (&test_buf, test_data + 10, TEST_DATA_LEN - 10);
+
+    /* then */
+    mctest_assert_int_eq (lines, TEST_DATA_LEN / 100);
+    mctest_assert_int_eq (test_buf.curs1, TEST_DATA_LEN);
+    for (i = 0; i < TEST_DATA_LEN; i++)
+        mctest_assert_int_eq (edit_buffer_get_byte (&test_buf, i), test_data[i]);
+
+    /* when */
+    edit_buffer_insert (&test_buf, 'z');
+
+    /* then */
+    mctest_assert_int_eq (edit_buffer_get_byte (&test_buf, TEST_DATA_LEN), 'z');
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_edit_buffer_insert_block);
+    tcase_add_test (tc_core, test_edit_buffer_insert_block_after_bytes);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "editbuffer__edit_buffer_insert_block.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
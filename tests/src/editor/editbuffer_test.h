@@ -0,0 +1,69 @@
+/*
+   src/editor - common fixture of editor buffer tests
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MC__TEST_EDITBUFFER_H
+#define MC__TEST_EDITBUFFER_H
+
+#include "lib/widget.h"
+
+#include "src/editor/editbuffer.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/* more than two buffer pages */
+#define TEST_DATA_LEN (150 * 1024)
+
+/*** file scope variables ************************************************************************/
+
+static edit_buffer_t test_buf;
+
+/* lines of 100 bytes: 99 letters and newline */
+static char *test_data;
+
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+/* create the empty buffer and the test data */
+static void
+test_buffer_init (void)
+{
+    int i;
+
+    edit_buffer_init (&test_buf, 0);
+
+    test_data = g_malloc (TEST_DATA_LEN);
+    for (i = 0; i < TEST_DATA_LEN; i++)
+        test_data[i] = (i % 100 == 99) ? '\n' : 'a' + i % 26;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+test_buffer_deinit (void)
+{
+    g_free (test_data);
+    edit_buffer_clean (&test_buf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#endif /* MC__TEST_EDITBUFFER_H */
@@ -0,0 +1,138 @@
+/*
+   src/editor - tests for edit_syntax_changed() function
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "src/editor/syntax.c"
+
+static WEdit *test_edit;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    syntax_marker_t m;
+    off_t offset;
+
+    test_edit = g_new0 (WEdit, 1);
+    /* the current state is before all changes */
+    test_edit->last_get_rule = -1;
+
+    test_edit->syntax_marker = g_array_new (FALSE, TRUE, sizeof (syntax_marker_t));
+    memset (&m, 0, sizeof (m));
+    for (offset = 1000; offset <= 3000; offset += 1000)
+    {
+        m.offset = offset;
+        g_array_append_val (test_edit->syntax_marker, m);
+    }
+    test_edit->syntax_marker_valid = test_edit->syntax_marker->len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    g_array_free (test_edit->syntax_marker, TRUE);
+    g_free (test_edit);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_syntax_changed_same_region)
+/* *INDENT-ON* */
+{
+    /* given */
+
+    /* when: two characters are typed one after another */
+    edit_syntax_changed (test_edit, 1500, 1);
+    edit_syntax_changed (test_edit, 1501, 1);
+
+    /* then: old checkpoints after the change are kept to be checked */
+    mctest_assert_int_eq (test_edit->syntax_marker_valid, 1);
+    mctest_assert_int_eq (test_edit->syntax_marker->len, 3);
+    mctest_assert_int_eq (SYNTAX_MARKER (test_edit, 0)->offset, 1000);
+    mctest_assert_int_eq (SYNTAX_MARKER (test_edit, 1)->offset, 2002);
+    mctest_assert_int_eq (SYNTAX_MARKER (test_edit, 2)->offset, 3002);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_edit_syntax_changed_other_region)
+/* *INDENT-ON* */
+{
+    /* given */
+
+    /* when: the second change is after the next checkpoint */
+    edit_syntax_changed (test_edit, 1500, 1);
+    edit_syntax_changed (test_edit, 2500, -10);
+
+    /* then: only the first changed region is re-checked */
+    mctest_assert_int_eq (test_edit->syntax_marker_valid, 1);
+    mctest_assert_int_eq (test_edit->syntax_marker->len, 2);
+    mctest_assert_int_eq (SYNTAX_MARKER (test_edit, 0)->offset, 1000);
+    mctest_assert_int_eq (SYNTAX_MARKER (test_edit, 1)->offset, 2001);
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_edit_syntax_changed_same_region);
+    tcase_add_test (tc_core, test_edit_syntax_changed_other_region);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "syntax__edit_syntax_changed.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,174 @@
+/*
+   src/filemanager - tests for dir_list_sort() function
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/filemanager"
+
+#include "tests/mctest.h"
+
+#include "lib/strutil.h"
+
+#include "src/setup.h"
+#include "src/filemanager/dir.h"
+
+#define TEST_ENTRIES_COUNT 40000
+#define TEST_SIZES_COUNT 97
+
+static dir_list test_list;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    struct stat st;
+    int i;
+
+    str_init_strings (NULL);
+
+    panels_options.mix_all_files = TRUE;
+
+    test_list.list = NULL;
+    test_list.size = 0;
+    test_list.len = 0;
+
+    memset (&st, 0, sizeof (st));
+    st.st_mode = S_IFDIR | 0755;
+    dir_list_append (&test_list, "..", &st, FALSE, FALSE);
+
+    st.st_mode = S_IFREG | 0644;
+    for (i = 0; i < TEST_ENTRIES_COUNT; i++)
+    {
+        char name[BUF_TINY];
+
+        st.st_size = (i * 31) % TEST_SIZES_COUNT;
+        g_snprintf (name, sizeof (name), "file%05d", TEST_ENTRIES_COUNT - i);
+        dir_list_append (&test_list, name, &st, FALSE, FALSE);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    dir_list_clean (&test_list);
+    g_free (test_list.list);
+
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+check_sorted_by_size (void)
+{
+    int i;
+
+    mctest_assert_int_eq (test_list.len, TEST_ENTRIES_COUNT + 1);
+    mctest_assert_str_eq (test_list.list[0].fname, "..");
+
+    for (i = 2; i < test_list.len; i++)
+    {
+        const file_entry_t *a = &test_list.list[i - 1];
+        const file_entry_t *b = &test_list.list[i];
+
+        mctest_assert_true (a->st.st_size <= b->st.st_size);
+        if (a->st.st_size == b->st.st_size)
+            mctest_assert_true (strcmp (a->fname, b->fname) < 0);
+        mctest_assert_null (b->sort_key);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_dir_list_sort_serial)
+/* *INDENT-ON* */
+{
+    /* given */
+    dir_sort_options_t sort_op = { FALSE, TRUE, FALSE };
+
+    dir_sort_threads = 0;
+
+    /* when */
+    dir_list_sort (&test_list, (GCompareFunc) sort_size, &sort_op);
+
+    /* then */
+    check_sorted_by_size ();
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_dir_list_sort_parallel)
+/* *INDENT-ON* */
+{
+    /* given */
+    dir_sort_options_t sort_op = { FALSE, TRUE, FALSE };
+
+    dir_sort_threads = 3;
+
+    /* when */
+    dir_list_sort (&test_list, (GCompareFunc) sort_size, &sort_op);
+
+    /* then */
+    check_sorted_by_size ();
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_dir_list_sort_serial);
+    tcase_add_test (tc_core, test_dir_list_sort_parallel);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "dir_list_sort.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,279 @@
+/*
+   src/vfs/sftpfs - tests for writing of files through the window
+
+   Copyright (C) 2015
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/vfs/sftpfs"
+
+#include "tests/mctest.h"
+
+#include "src/vfs/sftpfs/file.c"
+
+/* the fake server acknowledges so many bytes by one call */
+#define TEST_ACK_LEN 1000
+
+#define TEST_WINDOW_SIZE (8 * 1024)
+
+#define TEST_DATA_LEN (5 * TEST_WINDOW_SIZE + 123)
+
+static char *test_data;
+
+/* the file on the fake server */
+static GByteArray *server_file;
+static guint64 server_offset;
+/* the server fails to store data after this offset, or never if negative */
+static gint64 server_fail_offset;
+
+static sftpfs_super_data_t test_super_data;
+static struct vfs_s_super test_super;
+static struct vfs_s_inode test_ino;
+static vfs_file_handler_t *test_fh;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+ssize_t
+libssh2_sftp_write (LIBSSH2_SFTP_HANDLE * handle, const char *buffer, size_t count)
+{
+    size_t n;
+
+    (void) handle;
+
+    n = MIN (count, TEST_ACK_LEN);
+
+    if (server_fail_offset >= 0 && server_offset + n > (guint64) server_fail_offset)
+        return LIBSSH2_ERROR_SFTP_PROTOCOL;
+
+    if (server_file->len < server_offset + n)
+        g_byte_array_set_size (server_file, (guint) (server_offset + n));
+    memcpy (server_file->data + server_offset, buffer, n);
+    server_offset += n;
+
+    return (ssize_t) n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+void
+libssh2_sftp_seek64 (LIBSSH2_SFTP_HANDLE * handle, libssh2_uint64_t offset)
+{
+    (void) handle;
+
+    server_offset = offset;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+int
+libssh2_sftp_close_handle (LIBSSH2_SFTP_HANDLE * handle)
+{
+    (void) handle;
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+int
+libssh2_sftp_fstat_ex (LIBSSH2_SFTP_HANDLE * handle, LIBSSH2_SFTP_ATTRIBUTES * attrs, int setstat)
+{
+    (void) handle;
+    (void) setstat;
+
+    memset (attrs, 0, sizeof (*attrs));
+    attrs->flags = LIBSSH2_SFTP_ATTR_SIZE;
+    attrs->filesize = server_file->len;
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+int
+libssh2_session_last_error (LIBSSH2_SESSION * session, char **errmsg, int *errmsg_len,
+                            int want_buf)
+{
+    (void) session;
+    (void) want_buf;
+
+    *errmsg = g_strdup ("failure");
+    if (errmsg_len != NULL)
+        *errmsg_len = (int) strlen (*errmsg);
+
+    return LIBSSH2_ERROR_SFTP_PROTOCOL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    sftpfs_file_handler_data_t *data;
+    int i;
+
+    test_data = g_malloc (TEST_DATA_LEN);
+    for (i = 0; i < TEST_DATA_LEN; i++)
+        test_data[i] = (char) (i * 13 + i / 251);
+
+    server_file = g_byte_array_new ();
+    server_offset = 0;
+    server_fail_offset = -1;
+
+    test_super.data = &test_super_data;
+    test_ino.super = &test_super;
+
+    data = g_new0 (sftpfs_file_handler_data_t, 1);
+    /* any handle, the fake server has one file only */
+    data->handle = (LIBSSH2_SFTP_HANDLE *) &test_ino;
+    data->flags = O_WRONLY;
+    data->window_size = TEST_WINDOW_SIZE;
+    data->window = g_malloc (data->window_size);
+
+    test_fh = g_new0 (vfs_file_handler_t, 1);
+    test_fh->ino = &test_ino;
+    test_fh->handle = -1;
+    test_fh->data = data;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    if (test_fh->data != NULL)
+        sftpfs_close_file (test_fh, NULL);
+    g_free (test_fh);
+    g_byte_array_free (server_file, TRUE);
+    g_free (test_data);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_sftpfs_write_file)
+/* *INDENT-ON* */
+{
+    /* given */
+    GError *mcerror = NULL;
+    size_t written = 0, chunk = 1;
+
+    /* when: writes of growing sizes go through the window and past it */
+    while (written < TEST_DATA_LEN)
+    {
+        size_t n;
+
+        n = MIN (chunk, TEST_DATA_LEN - written);
+        mctest_assert_int_eq (sftpfs_write_file (test_fh, test_data + written, n, &mcerror), n);
+        mctest_assert_null (mcerror);
+        written += n;
+        chunk = chunk * 3 + 1;
+    }
+
+    /* then: all data is stored on close */
+    mctest_assert_int_eq (test_fh->pos, TEST_DATA_LEN);
+    mctest_assert_int_eq (sftpfs_close_file (test_fh, &mcerror), 0);
+    mctest_assert_null (mcerror);
+    mctest_assert_int_eq (server_file->len, TEST_DATA_LEN);
+    fail_unless (memcmp (server_file->data, test_data, TEST_DATA_LEN) == 0, "\nwrong data\n");
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+/* *INDENT-OFF* */
+START_TEST (test_sftpfs_write_file_error)
+/* *INDENT-ON* */
+{
+    /* given: data of the first write isn't acknowledged yet */
+    GError *mcerror = NULL;
+    struct stat st;
+
+    mctest_assert_int_eq (sftpfs_write_file (test_fh, test_data, 3000, &mcerror), 3000);
+    mctest_assert_null (mcerror);
+    mctest_assert_int_eq (server_file->len, TEST_ACK_LEN);
+
+    /* when: the server fails to store the rest */
+    server_fail_offset = TEST_ACK_LEN;
+
+    /* then: the error is reported by the next write */
+    mctest_assert_int_eq (sftpfs_write_file (test_fh, test_data + 3000, 3000, &mcerror), -1);
+    mctest_assert_not_null (mcerror);
+    g_clear_error (&mcerror);
+
+    /* and by retries, stat and close, although the server works again */
+    server_fail_offset = -1;
+    mctest_assert_int_eq (sftpfs_write_file (test_fh, test_data + 3000, 3000, &mcerror), -1);
+    mctest_assert_not_null (mcerror);
+    g_clear_error (&mcerror);
+
+    mctest_assert_int_eq (sftpfs_fstat (test_fh, &st, &mcerror), -1);
+    mctest_assert_not_null (mcerror);
+    g_clear_error (&mcerror);
+
+    mctest_assert_int_eq (sftpfs_close_file (test_fh, &mcerror), -1);
+    mctest_assert_not_null (mcerror);
+    g_clear_error (&mcerror);
+
+    /* only acknowledged data is stored */
+    mctest_assert_int_eq (server_file->len, TEST_ACK_LEN);
+    fail_unless (memcmp (server_file->data, test_data, TEST_ACK_LEN) == 0, "\nwrong data\n");
+}
+/* *INDENT-OFF* */
+END_TEST
+/* *INDENT-ON* */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    int number_failed;
+
+    Suite *s = suite_create (TEST_SUITE_NAME);
+    TCase *tc_core = tcase_create ("Core");
+    SRunner *sr;
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    /* Add new tests here: *************** */
+    tcase_add_test (tc_core, test_sftpfs_write_file);
+    tcase_add_test (tc_core, test_sftpfs_write_file_error);
+    /* *********************************** */
+
+    suite_add_tcase (s, tc_core);
+    sr = srunner_create (s);
+    srunner_set_log (sr, "file__sftpfs_write_file.log");
+    srunner_run_all (sr, CK_ENV);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* --------------------------------------------------------------------------------------------- */